@@ -0,0 +1,86 @@
+#include <new>
+#include <stdlib.h>
+#include <QElapsedTimer>
+#include "benchmark.h"
+#include "util/cpufeatures.h"
+
+#if defined(CPUFEATURES_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+// every allocation made through the global operator new is counted - on ELF platforms
+// this also covers the ones made inside sdrbase
+static qint64 allocationCount = 0;
+
+void* operator new(size_t size)
+{
+	allocationCount++;
+	void* p = malloc(size > 0 ? size : 1);
+	if(p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	allocationCount++;
+	void* p = malloc(size > 0 ? size : 1);
+	if(p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) throw()
+{
+	free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+	free(p);
+}
+
+static quint64 readCycleCounter()
+{
+#if defined(CPUFEATURES_X86)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+BenchmarkResult runBenchmark(Benchmark* benchmark, const std::vector<SampleVector>& blocks, int minMSecs)
+{
+	BenchmarkResult result;
+	result.m_name = benchmark->name();
+
+	benchmark->prepare(blocks[0].size());
+
+	// warm up caches, lazily grown buffers and the branch predictor
+	for(size_t i = 0; i < blocks.size(); i++)
+		benchmark->run(blocks[i]);
+
+	QElapsedTimer timer;
+	qint64 blockCount = 0;
+	qint64 allocations = allocationCount;
+	quint64 cycles = readCycleCounter();
+	timer.start();
+
+	do {
+		for(size_t i = 0; i < blocks.size(); i++)
+			benchmark->run(blocks[i]);
+		blockCount += blocks.size();
+	} while(timer.elapsed() < minMSecs);
+
+	result.m_nsecs = timer.nsecsElapsed();
+	result.m_cycles = readCycleCounter() - cycles;
+	result.m_allocations = allocationCount - allocations;
+	result.m_blocks = blockCount;
+	result.m_samples = blockCount * blocks[0].size();
+
+	return result;
+}
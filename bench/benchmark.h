@@ -0,0 +1,37 @@
+#ifndef INCLUDE_BENCHMARK_H
+#define INCLUDE_BENCHMARK_H
+
+#include <vector>
+#include <QString>
+#include "dsp/dsptypes.h"
+
+// one DSP component fed with synthetic IQ, block by block
+class Benchmark {
+public:
+	Benchmark(const QString& name) : m_name(name) { }
+	virtual ~Benchmark() { }
+
+	const QString& name() const { return m_name; }
+
+	// called once before timing starts - allocations done here are not counted
+	virtual void prepare(int blockSize) { Q_UNUSED(blockSize); }
+	virtual void run(const SampleVector& block) = 0;
+
+private:
+	QString m_name;
+};
+typedef std::vector<Benchmark*> Benchmarks;
+
+struct BenchmarkResult {
+	QString m_name;
+	qint64 m_samples;
+	qint64 m_blocks;
+	qint64 m_nsecs;
+	quint64 m_cycles; // 0 if there is no cycle counter
+	qint64 m_allocations;
+};
+
+void createBenchmarks(Benchmarks* benchmarks);
+BenchmarkResult runBenchmark(Benchmark* benchmark, const std::vector<SampleVector>& blocks, int minMSecs);
+
+#endif // INCLUDE_BENCHMARK_H
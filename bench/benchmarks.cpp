@@ -0,0 +1,594 @@
+#include "benchmark.h"
+#include "dsp/channelizer.h"
+#include "dsp/channelizertree.h"
+#include "dsp/dspcommands.h"
+#include "dsp/fftfilter.h"
+#include "dsp/glspectruminterface.h"
+#include "dsp/interpolator.h"
+#include "dsp/inthalfbandfilter.h"
+#include "dsp/iqcorrection.h"
+#include "dsp/lowpass.h"
+#include "dsp/nco.h"
+#include "dsp/pfbchannelizer.h"
+#include "dsp/sampleconverter.h"
+#include "dsp/samplefifo.h"
+#include "dsp/samplesink.h"
+#include "dsp/spectrumvis.h"
+#include "audio/audiofifo.h"
+#include "nfmdemod.h"
+#include "util/messagequeue.h"
+
+namespace {
+
+enum {
+	InputSampleRate = 2048000,
+	ChannelSampleRate = 64000,
+	AudioSampleRate = 48000
+};
+
+// swallows whatever a component produces
+class NullSink : public SampleSink {
+public:
+	NullSink() : m_samples(0) { }
+
+	void feed(SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst)
+	{
+		Q_UNUSED(firstOfBurst);
+		m_samples += end - begin;
+	}
+	void start() { }
+	void stop() { }
+	bool handleMessage(Message* cmd) { Q_UNUSED(cmd); return false; }
+
+private:
+	qint64 m_samples;
+};
+
+class NullSpectrum : public GLSpectrumInterface {
+public:
+	NullSpectrum() : m_frames(0) { }
+
+	void newSpectrum(const std::vector<Real>& spectrum, int fftSize)
+	{
+		Q_UNUSED(spectrum);
+		Q_UNUSED(fftSize);
+		m_frames++;
+	}
+
+private:
+	qint64 m_frames;
+};
+
+// keeps the compiler from optimizing away results nobody looks at
+volatile Real sink;
+
+class HalfbandBenchmark : public Benchmark {
+public:
+	HalfbandBenchmark() : Benchmark("IntHalfbandFilter::decimateCenter") { }
+
+	void prepare(int blockSize) { m_output.resize(blockSize / 2 + 1); }
+
+	void run(const SampleVector& block)
+	{
+		m_filter.decimateCenter(&block[0], block.size(), &m_output[0]);
+	}
+
+private:
+	IntHalfbandFilter m_filter;
+	SampleVector m_output;
+};
+
+// the first half of the block's bytes is taken as RTL-SDR style u8 I/Q, same number of samples as the block
+class HalfbandU8Benchmark : public Benchmark {
+public:
+	HalfbandU8Benchmark() : Benchmark("IntHalfbandFilter::decimateCenterU8") { }
+
+	void prepare(int blockSize) { m_output.resize(blockSize / 2 + 1); }
+
+	void run(const SampleVector& block)
+	{
+		m_filter.decimateCenterU8((const quint8*)&block[0], block.size(), &m_output[0]);
+	}
+
+private:
+	IntHalfbandFilter m_filter;
+	SampleVector m_output;
+};
+
+class SampleConverterBenchmark : public Benchmark {
+public:
+	SampleConverterBenchmark() : Benchmark("SampleConverter::convertU8") { }
+
+	void prepare(int blockSize) { m_output.resize(blockSize); }
+
+	void run(const SampleVector& block)
+	{
+		SampleConverter::convertU8((const quint8*)&block[0], block.size(), &m_output[0]);
+	}
+
+private:
+	SampleVector m_output;
+};
+
+// entry into the float pipeline, done once per block by every ComplexSampleSink
+class SampleConverterComplexBenchmark : public Benchmark {
+public:
+	SampleConverterComplexBenchmark() : Benchmark("SampleConverter::toComplex") { }
+
+	void prepare(int blockSize) { m_output.resize(blockSize); }
+
+	void run(const SampleVector& block)
+	{
+		SampleConverter::toComplex(&block[0], block.size(), &m_output[0]);
+	}
+
+private:
+	ComplexVector m_output;
+};
+
+// the gr_adaptor path - the float input is made once, its contents do not change the timing
+class SampleConverterFloatBenchmark : public Benchmark {
+public:
+	SampleConverterFloatBenchmark() : Benchmark("SampleConverter::convertFloat") { }
+
+	void prepare(int blockSize)
+	{
+		m_input.resize(2 * blockSize);
+		for(int i = 0; i < 2 * blockSize; i++)
+			m_input[i] = ((i * 7919) % 2001 - 1000) / 1000.0f;
+		m_output.resize(blockSize);
+	}
+
+	void run(const SampleVector& block)
+	{
+		SampleConverter::convertFloat(&m_input[0], block.size(), 32000.0f, &m_output[0]);
+	}
+
+private:
+	std::vector<float> m_input;
+	SampleVector m_output;
+};
+
+class ChannelizerBenchmark : public Benchmark {
+public:
+	ChannelizerBenchmark() :
+		Benchmark("Channelizer"),
+		m_channelizer(&m_sink)
+	{ }
+
+	void prepare(int blockSize)
+	{
+		Q_UNUSED(blockSize);
+		Message* cmd = DSPSignalNotification::create(InputSampleRate, 0);
+		if(!m_channelizer.handleMessage(cmd))
+			cmd->completed();
+		cmd = DSPConfigureChannelizer::create(ChannelSampleRate, 300000);
+		if(!m_channelizer.handleMessage(cmd))
+			cmd->completed();
+	}
+
+	void run(const SampleVector& block) { m_channelizer.feed(block.begin(), block.end(), false); }
+
+private:
+	NullSink m_sink;
+	Channelizer m_channelizer;
+};
+
+// eight channels next to each other, most stages are shared
+class ChannelizerTreeBenchmark : public Benchmark {
+public:
+	ChannelizerTreeBenchmark() : Benchmark("ChannelizerTree (8 channels)") { }
+
+	void prepare(int blockSize)
+	{
+		Q_UNUSED(blockSize);
+		m_tree.configure(InputSampleRate);
+		for(int i = 0; i < 8; i++) {
+			m_tree.addChannel(&m_sinks[i]);
+			m_tree.configureChannel(&m_sinks[i], 12500, 600000 + i * 15000);
+		}
+	}
+
+	void run(const SampleVector& block) { m_tree.feed(block.begin(), block.end(), false); }
+
+private:
+	NullSink m_sinks[8];
+	ChannelizerTree m_tree;
+};
+
+class PFBChannelizerBenchmark : public Benchmark {
+public:
+	PFBChannelizerBenchmark() : Benchmark("PFBChannelizer (8 channels)") { }
+
+	void prepare(int blockSize)
+	{
+		Q_UNUSED(blockSize);
+		m_pfb.configure(InputSampleRate);
+		for(int i = 0; i < 8; i++) {
+			m_pfb.addChannel(&m_sinks[i]);
+			m_pfb.configureChannel(&m_sinks[i], 12500, 600000 + i * 15000);
+		}
+	}
+
+	void run(const SampleVector& block) { m_pfb.feed(block.begin(), block.end(), false); }
+
+private:
+	NullSink m_sinks[8];
+	PFBChannelizer m_pfb;
+};
+
+class IQCorrectionBenchmark : public Benchmark {
+public:
+	IQCorrectionBenchmark() : Benchmark("IQCorrection") { }
+
+	void prepare(int blockSize)
+	{
+		m_buffer.resize(blockSize);
+		m_correction.configure(true, true);
+	}
+
+	void run(const SampleVector& block)
+	{
+		std::copy(block.begin(), block.end(), m_buffer.begin());
+		m_correction.process(&m_buffer[0], m_buffer.size());
+	}
+
+private:
+	IQCorrection m_correction;
+	SampleVector m_buffer;
+};
+
+// resampling a 250 kS/s channel down to audio rate
+class InterpolatorBenchmark : public Benchmark {
+public:
+	InterpolatorBenchmark() :
+		Benchmark("Interpolator"),
+		m_distance(250000.0 / AudioSampleRate),
+		m_distanceRemain(0)
+	{ }
+
+	void prepare(int blockSize)
+	{
+		Q_UNUSED(blockSize);
+		m_interpolator.create(16, 250000, 12500 / 2.2);
+	}
+
+	void run(const SampleVector& block)
+	{
+		Complex ci;
+		Real acc = 0;
+		for(SampleVector::const_iterator it = block.begin(); it != block.end(); ++it) {
+			Complex c(it->real() / 32768.0, it->imag() / 32768.0);
+			bool consumed = false;
+			while(!consumed) {
+				if(m_interpolator.interpolate(&m_distanceRemain, c, &consumed, &ci)) {
+					acc += ci.real();
+					m_distanceRemain += m_distance;
+				}
+			}
+		}
+		sink = acc;
+	}
+
+private:
+	Interpolator m_interpolator;
+	Real m_distance;
+	Real m_distanceRemain;
+};
+
+class InterpolatorResampleBenchmark : public Benchmark {
+public:
+	InterpolatorResampleBenchmark() :
+		Benchmark("Interpolator::resample"),
+		m_distance(250000.0 / AudioSampleRate),
+		m_distanceRemain(0)
+	{ }
+
+	void prepare(int blockSize)
+	{
+		m_interpolator.create(16, 250000, 12500 / 2.2);
+		m_input.resize(blockSize);
+		m_output.resize(Interpolator::maxOutput(blockSize, m_distance));
+	}
+
+	void run(const SampleVector& block)
+	{
+		SampleConverter::toComplex(&block[0], block.size(), &m_input[0]);
+		int produced = m_interpolator.resample(&m_distanceRemain, m_distance, &m_input[0], block.size(), &m_output[0]);
+		sink = m_output[produced - 1].real();
+	}
+
+private:
+	Interpolator m_interpolator;
+	Real m_distance;
+	Real m_distanceRemain;
+	ComplexVector m_input;
+	ComplexVector m_output;
+};
+
+class NCOBenchmark : public Benchmark {
+public:
+	NCOBenchmark() : Benchmark("NCO::nextIQ") { }
+
+	void prepare(int blockSize)
+	{
+		Q_UNUSED(blockSize);
+		m_nco.setFreq(-123456, InputSampleRate);
+	}
+
+	void run(const SampleVector& block)
+	{
+		Complex acc(0, 0);
+		for(SampleVector::const_iterator it = block.begin(); it != block.end(); ++it)
+			acc += Complex(it->real(), it->imag()) * m_nco.nextIQ();
+		sink = acc.real();
+	}
+
+private:
+	NCO m_nco;
+};
+
+class NCOMixBenchmark : public Benchmark {
+public:
+	NCOMixBenchmark(NCO::Mode mode, const QString& name) :
+		Benchmark(name),
+		m_mode(mode)
+	{ }
+
+	void prepare(int blockSize)
+	{
+		m_nco.setFreq(-123456, InputSampleRate);
+		m_nco.setMode(m_mode);
+		m_buffer.resize(blockSize);
+	}
+
+	void run(const SampleVector& block)
+	{
+		SampleConverter::toComplex(&block[0], block.size(), &m_buffer[0]);
+		m_nco.mix(&m_buffer[0], &m_buffer[0], block.size());
+	}
+
+private:
+	NCO::Mode m_mode;
+	NCO m_nco;
+	ComplexVector m_buffer;
+};
+
+// the audio lowpass of the NFM demodulator
+class LowpassBenchmark : public Benchmark {
+public:
+	LowpassBenchmark() : Benchmark("Lowpass<Real> (21 taps)") { }
+
+	void prepare(int blockSize)
+	{
+		Q_UNUSED(blockSize);
+		m_lowpass.create(21, AudioSampleRate, 3000);
+	}
+
+	void run(const SampleVector& block)
+	{
+		Real acc = 0;
+		for(SampleVector::const_iterator it = block.begin(); it != block.end(); ++it)
+			acc += m_lowpass.filter(it->real() / 32768.0);
+		sink = acc;
+	}
+
+private:
+	Lowpass<Real> m_lowpass;
+};
+
+// the same filter over whole blocks
+class LowpassBlockBenchmark : public Benchmark {
+public:
+	LowpassBlockBenchmark() : Benchmark("Lowpass<Real>::filter block (21 taps)") { }
+
+	void prepare(int blockSize)
+	{
+		m_lowpass.create(21, AudioSampleRate, 3000);
+		m_buffer.resize(blockSize);
+	}
+
+	void run(const SampleVector& block)
+	{
+		for(size_t i = 0; i < block.size(); i++)
+			m_buffer[i] = block[i].real() / 32768.0;
+		m_lowpass.filter(&m_buffer[0], &m_buffer[0], block.size());
+	}
+
+private:
+	Lowpass<Real> m_lowpass;
+	std::vector<Real> m_buffer;
+};
+
+class LowpassComplexBenchmark : public Benchmark {
+public:
+	LowpassComplexBenchmark(int decimation, const QString& name) :
+		Benchmark(name),
+		m_decimation(decimation)
+	{ }
+
+	void prepare(int blockSize)
+	{
+		m_lowpass.create(31, 48000, 48000 / 2.2 / m_decimation, m_decimation);
+		m_buffer.resize(blockSize);
+	}
+
+	void run(const SampleVector& block)
+	{
+		SampleConverter::toComplex(&block[0], block.size(), &m_buffer[0]);
+		m_lowpass.filter(&m_buffer[0], &m_buffer[0], block.size());
+	}
+
+private:
+	int m_decimation;
+	Lowpass<Complex> m_lowpass;
+	ComplexVector m_buffer;
+};
+
+// a long channel filter: 511 taps, moved down from a quarter of the band and decimated by 8
+class FFTFilterBenchmark : public Benchmark {
+public:
+	FFTFilterBenchmark() : Benchmark("FFTFilter (511 taps, /8)") { }
+
+	void prepare(int blockSize)
+	{
+		m_filter.createLowpass(511, 48000, 2500, 8);
+		m_filter.setRotation(m_filter.binFor(12000, 48000));
+		m_buffer.resize(blockSize);
+		// room for the most a block can give, whatever the fill of the window
+		m_output.resize((blockSize + m_filter.getFFTSize()) / 8);
+	}
+
+	void run(const SampleVector& block)
+	{
+		SampleConverter::toComplex(&block[0], block.size(), &m_buffer[0]);
+		m_filter.filter(&m_buffer[0], block.size(), &m_output[0]);
+	}
+
+private:
+	FFTFilter m_filter;
+	ComplexVector m_buffer;
+	ComplexVector m_output;
+};
+
+class SpectrumVisBenchmark : public Benchmark {
+public:
+	SpectrumVisBenchmark(SpectrumVis::LogAccuracy logAccuracy, int frameRate, SpectrumVis::Averaging averaging, const QString& name) :
+		Benchmark(name),
+		m_logAccuracy(logAccuracy),
+		m_frameRate(frameRate),
+		m_averaging(averaging),
+		m_spectrumVis(&m_spectrum)
+	{ }
+
+	void prepare(int blockSize)
+	{
+		Q_UNUSED(blockSize);
+		m_spectrumVis.handleMessage(DSPConfigureSpectrumVis::create(1024, 10, FFTWindow::BlackmanHarris, m_logAccuracy));
+		m_spectrumVis.handleMessage(DSPConfigureSpectrumFrames::create(m_frameRate, m_averaging));
+	}
+
+	void run(const SampleVector& block) { m_spectrumVis.feed(block.begin(), block.end(), false); }
+
+private:
+	SpectrumVis::LogAccuracy m_logAccuracy;
+	int m_frameRate;
+	SpectrumVis::Averaging m_averaging;
+	NullSpectrum m_spectrum;
+	SpectrumVis m_spectrumVis;
+};
+
+// fed at channel rate, the audio is thrown away after every block. squelch in dB, the test
+// signal is about -12 dB
+class NFMDemodBenchmark : public Benchmark {
+public:
+	NFMDemodBenchmark(Real squelch, const QString& name) :
+		Benchmark(name),
+		m_squelch(squelch),
+		m_audioFifo(4, AudioSampleRate),
+		m_nfmDemod(&m_audioFifo, NULL)
+	{ }
+
+	void prepare(int blockSize)
+	{
+		Q_UNUSED(blockSize);
+		m_audioFifo.setSampleRate(AudioSampleRate);
+		Message* cmd = DSPSignalNotification::create(ChannelSampleRate, 0);
+		if(!m_nfmDemod.handleMessage(cmd))
+			cmd->completed();
+
+		MessageQueue queue;
+		m_nfmDemod.configure(&queue, 12500, 3000, 2.0, m_squelch);
+		while((cmd = queue.accept()) != NULL) {
+			m_nfmDemod.handleMessage(cmd);
+			cmd->completed();
+		}
+
+		m_nfmDemod.start();
+	}
+
+	void run(const SampleVector& block)
+	{
+		m_nfmDemod.feed(block.begin(), block.end(), true);
+		m_audioFifo.flush();
+	}
+
+private:
+	Real m_squelch;
+	AudioFifo m_audioFifo;
+	NFMDemod m_nfmDemod;
+};
+
+class SampleFifoBenchmark : public Benchmark {
+public:
+	SampleFifoBenchmark() : Benchmark("SampleFifo write/read") { }
+
+	void prepare(int blockSize) { m_sampleFifo.setSize(blockSize * 4); }
+
+	void run(const SampleVector& block)
+	{
+		SampleVector::iterator begin;
+		SampleVector::iterator end;
+		m_sampleFifo.write(block.begin(), block.end());
+		uint count = m_sampleFifo.readBegin(m_sampleFifo.fill(), &begin, &end);
+		m_sampleFifo.readCommit(count);
+	}
+
+private:
+	SampleFifo m_sampleFifo;
+};
+
+// the zero-copy producer side - converts straight into the ring like the RTL-SDR thread does
+class SampleFifoReserveBenchmark : public Benchmark {
+public:
+	SampleFifoReserveBenchmark() : Benchmark("SampleFifo writeBegin/readBegin") { }
+
+	void prepare(int blockSize) { m_sampleFifo.setSize(blockSize * 4); }
+
+	void run(const SampleVector& block)
+	{
+		SampleVector::iterator begin;
+		SampleVector::iterator end;
+		uint count = m_sampleFifo.writeBegin(block.size(), &begin, &end);
+		SampleConverter::convertU8((const quint8*)&block[0], count, &(*begin));
+		m_sampleFifo.writeCommit(count);
+		count = m_sampleFifo.readBegin(m_sampleFifo.fill(), &begin, &end);
+		m_sampleFifo.readCommit(count);
+	}
+
+private:
+	SampleFifo m_sampleFifo;
+};
+
+} // namespace
+
+void createBenchmarks(Benchmarks* benchmarks)
+{
+	benchmarks->push_back(new SampleFifoBenchmark);
+	benchmarks->push_back(new SampleFifoReserveBenchmark);
+	benchmarks->push_back(new IQCorrectionBenchmark);
+	benchmarks->push_back(new SampleConverterBenchmark);
+	benchmarks->push_back(new SampleConverterFloatBenchmark);
+	benchmarks->push_back(new SampleConverterComplexBenchmark);
+	benchmarks->push_back(new HalfbandBenchmark);
+	benchmarks->push_back(new HalfbandU8Benchmark);
+	benchmarks->push_back(new ChannelizerBenchmark);
+	benchmarks->push_back(new ChannelizerTreeBenchmark);
+	benchmarks->push_back(new PFBChannelizerBenchmark);
+	benchmarks->push_back(new NCOBenchmark);
+	benchmarks->push_back(new NCOMixBenchmark(NCO::ModeTable, "NCO::mix (table)"));
+	benchmarks->push_back(new NCOMixBenchmark(NCO::ModeOscillator, "NCO::mix (oscillator)"));
+	benchmarks->push_back(new InterpolatorBenchmark);
+	benchmarks->push_back(new InterpolatorResampleBenchmark);
+	benchmarks->push_back(new LowpassBenchmark);
+	benchmarks->push_back(new LowpassBlockBenchmark);
+	benchmarks->push_back(new LowpassComplexBenchmark(1, "Lowpass<Complex>::filter block (31 taps)"));
+	benchmarks->push_back(new LowpassComplexBenchmark(4, "Lowpass<Complex>::filter block (31 taps, /4)"));
+	benchmarks->push_back(new FFTFilterBenchmark);
+	benchmarks->push_back(new SpectrumVisBenchmark(SpectrumVis::LogFast, 0, SpectrumVis::AvgNone, "SpectrumVis (1024 bins)"));
+	benchmarks->push_back(new SpectrumVisBenchmark(SpectrumVis::LogExact, 0, SpectrumVis::AvgNone, "SpectrumVis (1024 bins, exact log)"));
+	benchmarks->push_back(new SpectrumVisBenchmark(SpectrumVis::LogFast, 25, SpectrumVis::AvgNone, "SpectrumVis (1024 bins, 25 fps)"));
+	benchmarks->push_back(new SpectrumVisBenchmark(SpectrumVis::LogFast, 25, SpectrumVis::AvgLinear, "SpectrumVis (1024 bins, 25 fps, average)"));
+	benchmarks->push_back(new NFMDemodBenchmark(-40, "NFMDemod"));
+	benchmarks->push_back(new NFMDemodBenchmark(0, "NFMDemod (squelch closed)"));
+}
@@ -0,0 +1,158 @@
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <QCoreApplication>
+#include <QStringList>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include "benchmark.h"
+#include "util/cpufeatures.h"
+
+// a few tones and some noise, split into blocks like the sample FIFO would deliver them
+static void createInput(std::vector<SampleVector>* blocks, int blockSize, int blockCount)
+{
+	static const double tones[4] = { 0.01, -0.07, 0.23, 0.31 };
+	quint32 noise = 0x12345678;
+	qint64 n = 0;
+
+	blocks->resize(blockCount);
+	for(int b = 0; b < blockCount; b++) {
+		SampleVector& block = (*blocks)[b];
+		block.resize(blockSize);
+		for(int i = 0; i < blockSize; i++, n++) {
+			double re = 0;
+			double im = 0;
+			for(int t = 0; t < 4; t++) {
+				re += 4000.0 * cos(2.0 * M_PI * tones[t] * n);
+				im += 4000.0 * sin(2.0 * M_PI * tones[t] * n);
+			}
+			noise = noise * 1664525 + 1013904223;
+			re += (qint16)(noise >> 16) / 32;
+			noise = noise * 1664525 + 1013904223;
+			im += (qint16)(noise >> 16) / 32;
+			block[i] = Sample(re, im);
+		}
+	}
+}
+
+static QJsonArray cpuFeatures()
+{
+	static const struct {
+		CPUFeatures::Feature m_feature;
+		const char* m_name;
+	} features[] = {
+		{ CPUFeatures::SSE2, "sse2" },
+		{ CPUFeatures::SSSE3, "ssse3" },
+		{ CPUFeatures::SSE41, "sse4.1" },
+		{ CPUFeatures::AVX, "avx" },
+		{ CPUFeatures::AVX2, "avx2" },
+		{ CPUFeatures::FMA, "fma" },
+		{ CPUFeatures::NEON, "neon" }
+	};
+
+	QJsonArray result;
+	for(size_t i = 0; i < sizeof(features) / sizeof(features[0]); i++) {
+		if(CPUFeatures::has(features[i].m_feature))
+			result.append(QString(features[i].m_name));
+	}
+	return result;
+}
+
+static void usage()
+{
+	fprintf(stderr,
+		"usage: sdrangelove-bench [options]\n"
+		"  -b <samples>  block size (default 16384)\n"
+		"  -t <msecs>    minimum run time per component (default 1000)\n"
+		"  -f <text>     only run components with <text> in their name\n"
+		"  -o <file>     write the JSON report to <file> instead of stdout\n");
+}
+
+int main(int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+	QStringList args = app.arguments();
+	int blockSize = 16384;
+	int minMSecs = 1000;
+	QString filter;
+	QString outputFile;
+
+	for(int i = 1; i < args.size(); i++) {
+		if((args[i] == "-b") && (i + 1 < args.size())) {
+			blockSize = args[++i].toInt();
+		} else if((args[i] == "-t") && (i + 1 < args.size())) {
+			minMSecs = args[++i].toInt();
+		} else if((args[i] == "-f") && (i + 1 < args.size())) {
+			filter = args[++i];
+		} else if((args[i] == "-o") && (i + 1 < args.size())) {
+			outputFile = args[++i];
+		} else {
+			usage();
+			return 1;
+		}
+	}
+	if(blockSize < 64) {
+		usage();
+		return 1;
+	}
+
+	// roughly 1M samples, so the input does not fit into the caches
+	std::vector<SampleVector> blocks;
+	createInput(&blocks, blockSize, qMax(1, (1 << 20) / blockSize));
+
+	Benchmarks benchmarks;
+	createBenchmarks(&benchmarks);
+
+	QJsonArray results;
+	for(Benchmarks::iterator it = benchmarks.begin(); it != benchmarks.end(); ++it) {
+		Benchmark* benchmark = *it;
+		if(filter.isEmpty() || benchmark->name().contains(filter, Qt::CaseInsensitive)) {
+			BenchmarkResult r = runBenchmark(benchmark, blocks, minMSecs);
+			double nsPerSample = (double)r.m_nsecs / r.m_samples;
+			double allocsPerBlock = (double)r.m_allocations / r.m_blocks;
+
+			QJsonObject result;
+			result["name"] = r.m_name;
+			result["samples"] = (double)r.m_samples;
+			result["blocks"] = (double)r.m_blocks;
+			result["seconds"] = r.m_nsecs / 1e9;
+			result["msps"] = 1e3 / nsPerSample;
+			result["ns_per_sample"] = nsPerSample;
+			if(r.m_cycles != 0)
+				result["cycles_per_sample"] = (double)r.m_cycles / r.m_samples;
+			else result["cycles_per_sample"] = QJsonValue();
+			result["allocs_per_block"] = allocsPerBlock;
+			results.append(result);
+
+			fprintf(stderr, "%-36s %10.2f Msps %8.2f ns/sample %8.2f cycles/sample %8.2f allocs/block\n",
+				qPrintable(r.m_name), 1e3 / nsPerSample, nsPerSample, (double)r.m_cycles / r.m_samples, allocsPerBlock);
+		}
+		delete benchmark;
+	}
+
+	QJsonObject report;
+	report["block_size"] = blockSize;
+#if defined(USE_SIMD)
+	report["simd"] = true;
+#else
+	report["simd"] = false;
+#endif
+	report["cpu_features"] = cpuFeatures();
+	report["results"] = results;
+	QByteArray json = QJsonDocument(report).toJson();
+
+	if(outputFile.isEmpty()) {
+		fwrite(json.constData(), 1, json.size(), stdout);
+	} else {
+		QFile file(outputFile);
+		if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || (file.write(json) != json.size())) {
+			qCritical("could not write %s", qPrintable(outputFile));
+			return 1;
+		}
+	}
+
+	return 0;
+}
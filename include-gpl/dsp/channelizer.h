@@ -2,6 +2,7 @@
 #define INCLUDE_CHANNELIZER_H
 
 #include <list>
+#include <vector>
 #include "dsp/samplesink.h"
 #include "util/export.h"
 
@@ -10,6 +11,16 @@ class IntHalfbandFilter;
 
 class SDRANGELOVE_API Channelizer : public SampleSink {
 public:
+	enum StageMode {
+		ModeCenter,
+		ModeLowerHalf,
+		ModeUpperHalf
+	};
+	typedef std::vector<StageMode> StageModes;
+
+	// picks the half-band stages cutting the channel out of the signal, returns the remaining offset
+	static Real planFilterChain(Real sigStart, Real sigEnd, Real chanStart, Real chanEnd, StageModes* stageModes);
+
 	Channelizer(SampleSink* sampleSink);
 	~Channelizer();
 
@@ -21,23 +32,21 @@ public:
 	bool handleMessage(Message* cmd);
 
 protected:
-	struct FilterStage {
-		enum Mode {
-			ModeCenter,
-			ModeLowerHalf,
-			ModeUpperHalf
-		};
+	enum {
+		ChunkSize = 4096 // input samples pushed through the whole filter chain at once
+	};
 
-		typedef bool (IntHalfbandFilter::*WorkFunction)(Sample* s);
+	struct FilterStage {
+		typedef int (IntHalfbandFilter::*WorkFunction)(const Sample* in, int count, Sample* out);
 		IntHalfbandFilter* m_filter;
 		WorkFunction m_workFunction;
 
-		FilterStage(Mode mode);
+		FilterStage(StageMode mode);
 		~FilterStage();
 
-		bool work(Sample* sample)
+		int work(const Sample* in, int count, Sample* out)
 		{
-			return (m_filter->*m_workFunction)(sample);
+			return (m_filter->*m_workFunction)(in, count, out);
 		}
 	};
 	typedef std::list<FilterStage*> FilterStages;
@@ -49,9 +58,10 @@ protected:
 	int m_currentOutputSampleRate;
 	int m_currentCenterFrequency;
 	SampleVector m_sampleBuffer;
+	SampleVector m_stageBuffer;
 
 	void applyConfiguration();
-	bool signalContainsChannel(Real sigStart, Real sigEnd, Real chanStart, Real chanEnd) const;
+	static bool signalContainsChannel(Real sigStart, Real sigEnd, Real chanStart, Real chanEnd);
 	Real createFilterChain(Real sigStart, Real sigEnd, Real chanStart, Real chanEnd);
 	void freeFilterChain();
 };
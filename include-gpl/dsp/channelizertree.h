@@ -0,0 +1,83 @@
+#ifndef INCLUDE_CHANNELIZERTREE_H
+#define INCLUDE_CHANNELIZERTREE_H
+
+#include <vector>
+#include "dsp/channelizer.h"
+#include "util/export.h"
+
+class SampleSink;
+class IntHalfbandFilter;
+
+// half-band decimation tree shared by all channels - every channel is planned like a Channelizer
+// would do it, but stages with the same path from the full rate input are only computed once.
+// Channels sitting in the same part of the spectrum share everything up to the point where
+// their paths split, channels at the same spot share the whole chain.
+class SDRANGELOVE_API ChannelizerTree {
+public:
+	ChannelizerTree();
+	~ChannelizerTree();
+
+	void configure(int sampleRate);
+
+	void addChannel(SampleSink* sampleSink);
+	void removeChannel(SampleSink* sampleSink);
+	void configureChannel(SampleSink* sampleSink, int sampleRate, int centerFrequency);
+	bool hasChannels() const { return !m_channels.empty(); }
+
+	void feed(SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst);
+	void start();
+	void stop();
+
+private:
+	enum {
+		ChunkSize = 4096 // input samples pushed through the whole tree at once
+	};
+
+	struct Node;
+	typedef std::vector<Node*> Nodes;
+
+	struct Node {
+		typedef int (IntHalfbandFilter::*WorkFunction)(const Sample* in, int count, Sample* out);
+		Node* m_parent;
+		Channelizer::StageMode m_mode;
+		IntHalfbandFilter* m_filter;
+		WorkFunction m_workFunction;
+		int m_depth;
+		int m_nChannels;
+		Nodes m_children;
+		// output of the current block, sinks attached here get it in one piece
+		SampleVector m_sampleBuffer;
+		int m_fill;
+
+		Node(Node* parent, Channelizer::StageMode mode);
+		~Node();
+	};
+
+	struct Channel {
+		SampleSink* m_sampleSink;
+		int m_sampleRate;
+		int m_centerFrequency;
+		int m_offset;
+		Node* m_node;
+
+		Channel(SampleSink* sampleSink) :
+			m_sampleSink(sampleSink),
+			m_sampleRate(0),
+			m_centerFrequency(0),
+			m_offset(0),
+			m_node(NULL)
+		{ }
+	};
+	typedef std::vector<Channel*> Channels;
+
+	Channels m_channels;
+	Node* m_root;
+	int m_sampleRate;
+
+	void attachChannel(Channel* channel);
+	void releaseNode(Node* node);
+	void notifyChannel(Channel* channel);
+	void work(Node* node, const Sample* in, int count, bool restart);
+};
+
+#endif // INCLUDE_CHANNELIZERTREE_H
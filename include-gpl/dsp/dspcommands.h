@@ -4,6 +4,7 @@
 #include <QString>
 #include "util/message.h"
 #include "fftwindow.h"
+#include "dsp/spectrumvis.h"
 #include "util/export.h"
 
 class SampleSource;
@@ -84,6 +85,54 @@ private:
 	SampleSink* m_sampleSink;
 };
 
+class SDRANGELOVE_API DSPAddPFBSink : public Message {
+	MESSAGE_CLASS_DECLARATION(DSPAddPFBSink)
+
+public:
+	DSPAddPFBSink(SampleSink* sampleSink) : Message(), m_sampleSink(sampleSink) { }
+
+	SampleSink* getSampleSink() const { return m_sampleSink; }
+
+private:
+	SampleSink* m_sampleSink;
+};
+
+class SDRANGELOVE_API DSPRemovePFBSink : public Message {
+	MESSAGE_CLASS_DECLARATION(DSPRemovePFBSink)
+
+public:
+	DSPRemovePFBSink(SampleSink* sampleSink) : Message(), m_sampleSink(sampleSink) { }
+
+	SampleSink* getSampleSink() const { return m_sampleSink; }
+
+private:
+	SampleSink* m_sampleSink;
+};
+
+class SDRANGELOVE_API DSPAddChannelizerSink : public Message {
+	MESSAGE_CLASS_DECLARATION(DSPAddChannelizerSink)
+
+public:
+	DSPAddChannelizerSink(SampleSink* sampleSink) : Message(), m_sampleSink(sampleSink) { }
+
+	SampleSink* getSampleSink() const { return m_sampleSink; }
+
+private:
+	SampleSink* m_sampleSink;
+};
+
+class SDRANGELOVE_API DSPRemoveChannelizerSink : public Message {
+	MESSAGE_CLASS_DECLARATION(DSPRemoveChannelizerSink)
+
+public:
+	DSPRemoveChannelizerSink(SampleSink* sampleSink) : Message(), m_sampleSink(sampleSink) { }
+
+	SampleSink* getSampleSink() const { return m_sampleSink; }
+
+private:
+	SampleSink* m_sampleSink;
+};
+
 class SDRANGELOVE_API DSPAddAudioSource : public Message {
 	MESSAGE_CLASS_DECLARATION(DSPAddAudioSource)
 
@@ -115,22 +164,48 @@ public:
 	int getFFTSize() const { return m_fftSize; }
 	int getOverlapPercent() const { return m_overlapPercent; }
 	FFTWindow::Function getWindow() const { return m_window; }
+	SpectrumVis::LogAccuracy getLogAccuracy() const { return m_logAccuracy; }
 
-	static DSPConfigureSpectrumVis* create(int fftSize, int overlapPercent, FFTWindow::Function window)
+	static DSPConfigureSpectrumVis* create(int fftSize, int overlapPercent, FFTWindow::Function window, SpectrumVis::LogAccuracy logAccuracy)
 	{
-		return new DSPConfigureSpectrumVis(fftSize, overlapPercent, window);
+		return new DSPConfigureSpectrumVis(fftSize, overlapPercent, window, logAccuracy);
 	}
 
 private:
 	int m_fftSize;
 	int m_overlapPercent;
 	FFTWindow::Function m_window;
+	SpectrumVis::LogAccuracy m_logAccuracy;
 
-	DSPConfigureSpectrumVis(int fftSize, int overlapPercent, FFTWindow::Function window) :
+	DSPConfigureSpectrumVis(int fftSize, int overlapPercent, FFTWindow::Function window, SpectrumVis::LogAccuracy logAccuracy) :
 		Message(),
 		m_fftSize(fftSize),
 		m_overlapPercent(overlapPercent),
-		m_window(window)
+		m_window(window),
+		m_logAccuracy(logAccuracy)
+	{ }
+};
+
+class SDRANGELOVE_API DSPConfigureSpectrumFrames : public Message {
+	MESSAGE_CLASS_DECLARATION(DSPConfigureSpectrumFrames)
+
+public:
+	int getFrameRate() const { return m_frameRate; }
+	SpectrumVis::Averaging getAveraging() const { return m_averaging; }
+
+	static DSPConfigureSpectrumFrames* create(int frameRate, SpectrumVis::Averaging averaging)
+	{
+		return new DSPConfigureSpectrumFrames(frameRate, averaging);
+	}
+
+private:
+	int m_frameRate;
+	SpectrumVis::Averaging m_averaging;
+
+	DSPConfigureSpectrumFrames(int frameRate, SpectrumVis::Averaging averaging) :
+		Message(),
+		m_frameRate(frameRate),
+		m_averaging(averaging)
 	{ }
 };
 
@@ -180,6 +255,26 @@ private:
 	{ }
 };
 
+class SDRANGELOVE_API DSPConfigureSinkThreads : public Message {
+	MESSAGE_CLASS_DECLARATION(DSPConfigureSinkThreads)
+
+public:
+	int getSinkThreads() const { return m_sinkThreads; }
+
+	static DSPConfigureSinkThreads* create(int sinkThreads)
+	{
+		return new DSPConfigureSinkThreads(sinkThreads);
+	}
+
+private:
+	int m_sinkThreads;
+
+	DSPConfigureSinkThreads(int sinkThreads) :
+		Message(),
+		m_sinkThreads(sinkThreads)
+	{ }
+};
+
 class SDRANGELOVE_API DSPEngineReport : public Message {
 	MESSAGE_CLASS_DECLARATION(DSPEngineReport)
 
@@ -229,6 +324,53 @@ private:
 	{ }
 };
 
+class SDRANGELOVE_API DSPConfigureIQRecorder : public Message {
+	MESSAGE_CLASS_DECLARATION(DSPConfigureIQRecorder)
+
+public:
+	const QString& getFileName() const { return m_fileName; }
+	quint64 getCenterFrequency() const { return m_centerFrequency; }
+	bool getDirectIO() const { return m_directIO; }
+
+	static DSPConfigureIQRecorder* create(const QString& fileName, quint64 centerFrequency, bool directIO)
+	{
+		return new DSPConfigureIQRecorder(fileName, centerFrequency, directIO);
+	}
+
+private:
+	QString m_fileName;
+	quint64 m_centerFrequency;
+	bool m_directIO;
+
+	DSPConfigureIQRecorder(const QString& fileName, quint64 centerFrequency, bool directIO) :
+		Message(),
+		m_fileName(fileName),
+		m_centerFrequency(centerFrequency),
+		m_directIO(directIO)
+	{ }
+};
+
+// the recorder stopped by itself, e.g. on a sample rate change
+class SDRANGELOVE_API DSPIQRecorderStopped : public Message {
+	MESSAGE_CLASS_DECLARATION(DSPIQRecorderStopped)
+
+public:
+	const QString& getFileName() const { return m_fileName; }
+
+	static DSPIQRecorderStopped* create(const QString& fileName)
+	{
+		return new DSPIQRecorderStopped(fileName);
+	}
+
+private:
+	QString m_fileName;
+
+	DSPIQRecorderStopped(const QString& fileName) :
+		Message(),
+		m_fileName(fileName)
+	{ }
+};
+
 class SDRANGELOVE_API DSPSignalNotification : public Message {
 	MESSAGE_CLASS_DECLARATION(DSPSignalNotification)
 
@@ -275,4 +417,56 @@ private:
 	{ }
 };
 
+class SDRANGELOVE_API DSPConfigurePFBSink : public Message {
+	MESSAGE_CLASS_DECLARATION(DSPConfigurePFBSink)
+
+public:
+	SampleSink* getSampleSink() const { return m_sampleSink; }
+	int getBandwidth() const { return m_bandwidth; }
+	int getCenterFrequency() const { return m_centerFrequency; }
+
+	static DSPConfigurePFBSink* create(SampleSink* sampleSink, int bandwidth, int centerFrequency)
+	{
+		return new DSPConfigurePFBSink(sampleSink, bandwidth, centerFrequency);
+	}
+
+private:
+	SampleSink* m_sampleSink;
+	int m_bandwidth;
+	int m_centerFrequency;
+
+	DSPConfigurePFBSink(SampleSink* sampleSink, int bandwidth, int centerFrequency) :
+		Message(),
+		m_sampleSink(sampleSink),
+		m_bandwidth(bandwidth),
+		m_centerFrequency(centerFrequency)
+	{ }
+};
+
+class SDRANGELOVE_API DSPConfigureChannelizerSink : public Message {
+	MESSAGE_CLASS_DECLARATION(DSPConfigureChannelizerSink)
+
+public:
+	SampleSink* getSampleSink() const { return m_sampleSink; }
+	int getSampleRate() const { return m_sampleRate; }
+	int getCenterFrequency() const { return m_centerFrequency; }
+
+	static DSPConfigureChannelizerSink* create(SampleSink* sampleSink, int sampleRate, int centerFrequency)
+	{
+		return new DSPConfigureChannelizerSink(sampleSink, sampleRate, centerFrequency);
+	}
+
+private:
+	SampleSink* m_sampleSink;
+	int m_sampleRate;
+	int m_centerFrequency;
+
+	DSPConfigureChannelizerSink(SampleSink* sampleSink, int sampleRate, int centerFrequency) :
+		Message(),
+		m_sampleSink(sampleSink),
+		m_sampleRate(sampleRate),
+		m_centerFrequency(centerFrequency)
+	{ }
+};
+
 #endif // INCLUDE_DSPCOMMANDS_H
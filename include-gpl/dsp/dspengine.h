@@ -25,6 +25,10 @@
 #include "dsp/dsptypes.h"
 #include "dsp/fftwindow.h"
 #include "dsp/samplefifo.h"
+#include "dsp/dspworkerpool.h"
+#include "dsp/pfbchannelizer.h"
+#include "dsp/channelizertree.h"
+#include "dsp/iqcorrection.h"
 #include "audio/audiooutput.h"
 #include "util/messagequeue.h"
 #include "util/export.h"
@@ -60,11 +64,22 @@ public:
 	void addSink(SampleSink* sink);
 	void removeSink(SampleSink* sink);
 
+	// narrow channels fed from the shared filterbank instead of the full rate input
+	void addPFBSink(SampleSink* sink);
+	void removePFBSink(SampleSink* sink);
+	void configurePFBSink(SampleSink* sink, int bandwidth, int centerFrequency);
+
+	// channels cut out by half-band stages shared with all other channels on the same path
+	void addChannelizerSink(SampleSink* sink);
+	void removeChannelizerSink(SampleSink* sink);
+	void configureChannelizerSink(SampleSink* sink, int sampleRate, int centerFrequency);
+
 	void addAudioSource(AudioFifo* audioFifo);
 	void removeAudioSource(AudioFifo* audioFifo);
 
 	void configureCorrections(bool dcOffsetCorrection, bool iqImbalanceCorrection);
 	void configureAudioOutput(const QString& audioOutput, quint32 audioOutputRate);
+	void configureSinkThreads(int sinkThreads);
 
 	State state() const { return m_state; }
 
@@ -84,24 +99,19 @@ private:
 
 	typedef std::list<SampleSink*> SampleSinks;
 	SampleSinks m_sampleSinks;
+	DSPWorkerPool m_workerPool;
+	PFBChannelizer m_pfbChannelizer;
+	ChannelizerTree m_channelizerTree;
 
 	AudioOutput m_audioOutput;
 
 	uint m_sampleRate;
 	quint64 m_centerFrequency;
 
-	bool m_dcOffsetCorrection;
-	bool m_iqImbalanceCorrection;
-	qint32 m_iOffset;
-	qint32 m_qOffset;
-	qint32 m_iRange;
-	qint32 m_qRange;
-	qint32 m_imbalance;
+	IQCorrection m_iqCorrection;
 
 	void run();
 
-	void dcOffset(SampleVector::iterator begin, SampleVector::iterator end);
-	void imbalance(SampleVector::iterator begin, SampleVector::iterator end);
 	void work();
 
 	State gotoIdle();
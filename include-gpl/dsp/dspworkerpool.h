@@ -0,0 +1,69 @@
+#ifndef INCLUDE_DSPWORKERPOOL_H
+#define INCLUDE_DSPWORKERPOOL_H
+
+#include <list>
+#include <vector>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include "dsp/dsptypes.h"
+#include "util/export.h"
+
+class SampleSink;
+
+// fans out one block of samples to several sinks running on a pool of threads
+class SDRANGELOVE_API DSPWorkerPool {
+public:
+	typedef std::list<SampleSink*> SampleSinks;
+
+	DSPWorkerPool();
+	~DSPWorkerPool();
+
+	// 0 disables the pool, all sinks are then fed by the calling thread
+	void setThreadCount(int threadCount);
+	int getThreadCount() const { return m_workers.size(); }
+
+	// returns after every sink has consumed the block
+	void feed(const SampleSinks& sinks, SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst);
+
+private:
+	// one block shared read-only between all workers
+	struct Block {
+		// workers inside runJobs(), guarded by m_mutex
+		int m_users;
+		QAtomicInt m_nextJob;
+		QAtomicInt m_pendingJobs;
+		std::vector<SampleSink*> m_sinks;
+		SampleVector::const_iterator m_begin;
+		SampleVector::const_iterator m_end;
+		bool m_firstOfBurst;
+	};
+
+	class Worker : public QThread {
+	public:
+		Worker(DSPWorkerPool* pool) : m_pool(pool) { }
+
+	protected:
+		void run() { m_pool->workerLoop(); }
+
+	private:
+		DSPWorkerPool* m_pool;
+	};
+	typedef std::vector<Worker*> Workers;
+
+	QMutex m_mutex;
+	QWaitCondition m_workAvailable;
+	QWaitCondition m_blockDone;
+	Workers m_workers;
+	Block m_block;
+	Block* m_currentBlock;
+	uint m_generation;
+	bool m_quit;
+
+	void workerLoop();
+	void runJobs(Block* block);
+	void stopWorkers();
+};
+
+#endif // INCLUDE_DSPWORKERPOOL_H
@@ -11,6 +11,14 @@ public:
 	virtual void configure(int n, bool inverse) = 0;
 	virtual void transform() = 0;
 
+	// several transforms of the configured size at once: frame i at in() + i * stride, its result
+	// at out() + i * stride. stride >= n and a multiple of 4, which keeps every frame aligned for
+	// SIMD. reserve() makes room for count frames (in() and out() may move, their contents are
+	// lost) and sets up the batch, transformMany() with fewer frames or another stride falls back
+	// to one transform per frame. configure() drops the batch
+	virtual void reserve(int count, int stride) = 0;
+	virtual void transformMany(int count, int stride) = 0;
+
 	virtual Complex* in() = 0;
 	virtual Complex* out() = 0;
 
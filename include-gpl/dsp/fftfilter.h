@@ -0,0 +1,63 @@
+#ifndef INCLUDE_FFTFILTER_H
+#define INCLUDE_FFTFILTER_H
+
+#include <vector>
+#include "dsp/dsptypes.h"
+#include "util/export.h"
+
+class FFTEngine;
+
+// overlap-save fast convolution: every FFT of m_fftSize input samples yields m_hop new outputs, the
+// first m_fftSize - m_hop samples of each window are the tail of the previous one. The input spectrum
+// can be rotated by whole bins before the taps are applied (that bin ends up at DC) and the output
+// can be decimated by folding the spectrum before the inverse FFT, which then is only
+// m_fftSize / decimation long.
+class SDRANGELOVE_API FFTFilter {
+public:
+	FFTFilter();
+	~FFTFilter();
+
+	// any (complex) taps up to fftSize / 2. fftSize has to be a multiple of decimation, 0 picks one
+	// about four times the filter length
+	bool create(const std::vector<Complex>& taps, int decimation = 1, int fftSize = 0);
+	// windowed sinc lowpass, cutoff in Hz
+	bool createLowpass(int nTaps, double sampleRate, double cutoff, int decimation = 1, int fftSize = 0);
+
+	// input bin moved to DC, negative for frequencies below the center
+	void setRotation(int bins);
+	int getRotation() const { return m_rotation; }
+	int binFor(double frequency, double sampleRate) const;
+
+	// count samples in, returns the number of outputs - out needs room for maxOutput(count)
+	int filter(const Complex* in, int count, Complex* out);
+	int maxOutput(int count) const;
+
+	int getFFTSize() const { return m_fftSize; }
+	int getDecimation() const { return m_decimation; }
+	// output delay in input samples
+	int getDelay() const { return (m_nTaps - 1) / 2; }
+
+private:
+	FFTEngine* m_fft;
+	FFTEngine* m_ifft;
+	int m_fftSize;
+	int m_hop;
+	int m_decimation;
+	int m_nTaps;
+
+	// taps spectrum, 1 / m_fftSize included
+	std::vector<Complex> m_spectrum;
+	// the current window, m_fill samples of it valid
+	std::vector<Complex> m_window;
+	int m_fill;
+
+	int m_rotation;
+	// start of the current window modulo m_fftSize, the rotation leaves a phase of
+	// -2 pi m_rotation m_windowStart / m_fftSize on every block
+	int m_windowStart;
+
+	void free();
+	void process(Complex* out);
+};
+
+#endif // INCLUDE_FFTFILTER_H
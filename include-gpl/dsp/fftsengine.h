@@ -12,11 +12,15 @@ public:
 	void configure(int n, bool inverse);
 	void transform();
 
+	void reserve(int count, int stride);
+	void transformMany(int count, int stride);
+
 	Complex* in();
 	Complex* out();
 
 protected:
 	void allocate(int n);
+	int m_size;
 	ffts_plan_t* m_currentplan;
 	void* m_imem;
 	void* m_iptr;
@@ -2,10 +2,20 @@
 #define INCLUDE_FFTWENGINE_H
 
 #include <QMutex>
+#include <QAtomicInt>
+#include <QAtomicPointer>
 #include <fftw3.h>
 #include <list>
+#include <vector>
 #include "dsp/fftengine.h"
+#include "dsp/kissfft.h"
 
+// new sizes start with an FFTW_ESTIMATE plan, the FFTW_PATIENT one is made on a background thread
+// and taken over by transform() once it is there. The wisdom is kept in the user's cache directory,
+// so after the first run the patient plans are available right away. Batches are one
+// fftwf_plan_many_dft() plan, done frame by frame until it is ready. Large transforms are planned
+// for all cores when FFTW comes with threads. The DSP thread never waits for the planner: a plan it
+// cannot make right away is tried again with the next transform, KissFFT does the work until then
 class FFTWEngine : public FFTEngine {
 public:
 	FFTWEngine();
@@ -14,24 +24,67 @@ public:
 	void configure(int n, bool inverse);
 	void transform();
 
+	void reserve(int count, int stride);
+	void transformMany(int count, int stride);
+
 	Complex* in();
 	Complex* out();
 
 protected:
 	static QMutex m_globalPlanMutex;
+	static bool m_initialized;
+	// plans to destroy once the planner is free
+	static QMutex m_retiredMutex;
+	static std::vector<fftwf_plan> m_retiredPlans;
+
+	// handed over from the background planner, owned by both until released twice
+	struct PatientPlan {
+		QAtomicInt refCount;
+		QAtomicPointer<fftwf_plan_s> plan;
+
+		PatientPlan() : refCount(2), plan(NULL) { }
+	};
+	class PatientPlanner;
 
+	// count transforms, stride samples apart. all plans run on m_in and m_out
 	struct Plan {
 		int n;
 		bool inverse;
-		fftwf_plan plan;
-		fftwf_complex* in;
-		fftwf_complex* out;
+		int count;
+		int stride;
+		fftwf_plan plan; // NULL for a batch until its patient plan is there
+		fftwf_plan estimate; // replaced by the patient plan, freed with the rest
+		PatientPlan* patient;
+		bool deferred; // the planner was busy
 	};
 	typedef std::list<Plan*> Plans;
 	Plans m_plans;
 	Plan* m_currentPlan;
+	Plan* m_batchPlan;
 
+	// for sizes without a plan yet
+	kissfft<Real, Complex> m_fallback;
+	int m_fallbackSize;
+	bool m_fallbackInverse;
+
+	fftwf_complex* m_in;
+	fftwf_complex* m_out;
+	int m_size;
+
+	Plan* findPlan(int n, bool inverse, int count, int stride);
+	Plan* createPlan(int n, bool inverse, int count, int stride);
+	void startPlan(Plan* plan);
+	void allocate(int size);
+	void fallback(int n, bool inverse, int count, int stride);
 	void freeAll();
+
+	static fftwf_plan makePlan(int n, bool inverse, int count, int stride, fftwf_complex* in, fftwf_complex* out, unsigned flags);
+	static void upgrade(Plan* plan);
+	static void release(PatientPlan* patient);
+	static void destroyPlan(fftwf_plan plan);
+	static void destroyRetired();
+	static void initialize();
+	static void saveWisdom();
 };
 
 #endif // INCLUDE_FFTWENGINE_H
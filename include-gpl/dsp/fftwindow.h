@@ -39,9 +39,18 @@ public:
 	void apply(const std::vector<Real>& in, std::vector<Real>* out);
 	void apply(const std::vector<Complex>& in, std::vector<Complex>* out);
 	void apply(const Complex* in, Complex* out);
+	// int16 IQ straight into the FFT input, scaled to [-1, 1) on the way
+	void apply(const Sample* in, Complex* out);
+
+	// count samples through window, which already holds the I and Q factors of every sample
+	typedef void (*SampleKernel)(const Sample* in, int count, const float* window, Complex* out);
 
 private:
 	std::vector<float> m_window;
+	std::vector<float> m_sampleWindow; // m_window / 32768, every value twice
+
+	static const SampleKernel m_sampleKernel;
+	static SampleKernel selectSampleKernel();
 
 	static inline Real flatTop(Real n, Real i)
 	{
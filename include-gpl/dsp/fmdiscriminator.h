@@ -0,0 +1,37 @@
+#ifndef INCLUDE_FMDISCRIMINATOR_H
+#define INCLUDE_FMDISCRIMINATOR_H
+
+#include "dsp/dsptypes.h"
+#include "util/export.h"
+
+// polar discriminator over whole blocks: out[i] = arg(conj(in[i - 1]) * in[i]) / pi, so full
+// deviation (half the sample rate) is +-1. The angle comes from a polynomial atan2 good to
+// about 2e-6 rad instead of a call to atan2() per sample
+class SDRANGELOVE_API FMDiscriminator {
+public:
+	// count outputs from the last sample and in. last is updated to in[count - 1]
+	typedef void (*Kernel)(const Complex* in, int count, Complex* last, Real* out);
+
+	FMDiscriminator() :
+		m_last(0, 0)
+	{ }
+
+	void demod(const Complex* in, int count, Real* out)
+	{
+		if(count > 0)
+			m_kernel(in, count, &m_last, out);
+	}
+
+	// the reference for the next demod() call, e.g. after skipping samples
+	void setLast(const Complex& last) { m_last = last; }
+
+	static Real atan2(Real y, Real x);
+
+private:
+	Complex m_last;
+
+	static const Kernel m_kernel;
+	static Kernel selectKernel();
+};
+
+#endif // INCLUDE_FMDISCRIMINATOR_H
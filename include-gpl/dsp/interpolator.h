@@ -1,18 +1,24 @@
 #ifndef INCLUDE_INTERPOLATOR_H
 #define INCLUDE_INTERPOLATOR_H
 
-#ifdef USE_SIMD
-#include <immintrin.h>
-#endif
+#include <math.h>
 #include "dsp/dsptypes.h"
+#include "util/cpufeatures.h"
 #include "util/export.h"
 #include <stdio.h>
 #ifndef WIN32
 #include <unistd.h>
 #endif
 
+#if defined(USE_SIMD) && defined(CPUFEATURES_X86)
+#include <emmintrin.h>
+#endif
+
 class SDRANGELOVE_API Interpolator {
 public:
+	// one output per entry of start/phase: the taps of that phase applied to the nTaps samples at start
+	typedef void (*Kernel)(const Complex* samples, const int* start, const int* phase, int count, const float* taps, int nTaps, Complex* out);
+
 	Interpolator();
 	~Interpolator();
 
@@ -34,98 +40,60 @@ public:
 		return true;
 	}
 
+	// the interpolate() loop over a whole block: all of in is consumed, an output is made whenever
+	// distance is below 1 and step is added after each. distance carries over between blocks just
+	// like with interpolate(). out needs room for maxOutput(count, step) samples
+	int resample(Real* distance, Real step, const Complex* in, int count, Complex* out);
+	static int maxOutput(int count, Real step) { return (int)((count + 1) / step) + 2; }
 
 private:
 	float* m_taps;
-	float* m_alignedTaps;
-	float* m_taps2;
-	float* m_alignedTaps2;
+	float* m_alignedTaps; // per phase, oldest sample first, every tap twice (for I and Q)
+	// linear history: the newest m_nTaps samples end at m_end, moved to the front when full
 	std::vector<Complex> m_samples;
-	int m_ptr;
+	int m_end;
 	int m_phaseSteps;
 	int m_nTaps;
 
+	// output schedule of resample()
+	std::vector<int> m_start;
+	std::vector<int> m_phase;
+
+	static const Kernel m_kernel;
+	static Kernel selectKernel();
+
 	void createTaps(int nTaps, double sampleRate, double cutoff, std::vector<Real>* taps);
+	void reserve(int count);
 
 	void advanceFilter(const Complex& next)
 	{
-		m_ptr--;
-		if(m_ptr < 0)
-			m_ptr = m_nTaps - 1;
-		m_samples[m_ptr] = next;
+		if(m_end >= (int)m_samples.size())
+			reserve(1);
+		m_samples[m_end++] = next;
 	}
 
 	void doInterpolate(int phase, Complex* result)
 	{
-#if USE_SIMD
-		// beware of the ringbuffer
-		if(m_ptr == 0) {
-			// only one straight block
-			const float* src = (const float*)&m_samples[0];
-			const __m128* filter = (const __m128*)&m_alignedTaps[phase * m_nTaps * 2];
-			__m128 sum = _mm_setzero_ps();
-			int todo = m_nTaps / 2;
-
-			for(int i = 0; i < todo; i++) {
-				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src), *filter));
-				src += 4;
-				filter += 1;
-			}
+		const float* src = (const float*)&m_samples[m_end - m_nTaps];
+		const float* coeff = &m_alignedTaps[phase * m_nTaps * 2];
+#if defined(USE_SIMD) && defined(CPUFEATURES_X86)
+		__m128 sum = _mm_setzero_ps();
 
-			// add upper half to lower half and store
-			_mm_storel_pi((__m64*)result, _mm_add_ps(sum, _mm_shuffle_ps(sum, _mm_setzero_ps(), _MM_SHUFFLE(1, 0, 3, 2))));
-		} else {
-			// two blocks
-			const float* src = (const float*)&m_samples[m_ptr];
-			const __m128* filter = (const __m128*)&m_alignedTaps[phase * m_nTaps * 2];
-			__m128 sum = _mm_setzero_ps();
-
-			// first block
-			int block = m_nTaps - m_ptr;
-			int todo = block / 2;
-			if(block & 1)
-				todo++;
-			for(int i = 0; i < todo; i++) {
-				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src), *filter));
-				src += 4;
-				filter += 1;
-			}
-			if(block & 1) {
-				// one sample beyond the end -> switch coefficient table
-				filter = (const __m128*)&m_alignedTaps2[phase * m_nTaps * 2 + todo * 4 - 4];
-			}
-			// second block
-			src = (const float*)&m_samples[0];
-			block = m_ptr;
-			todo = block / 2;
-			for(int i = 0; i < todo; i++) {
-				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src), *filter));
-				src += 4;
-				filter += 1;
-			}
-			if(block & 1) {
-				// one sample remaining
-				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)src), filter[0]));
-			}
+		for(int i = 0; i < m_nTaps / 2; i++)
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src + 4 * i), _mm_load_ps(coeff + 4 * i)));
 
-			// add upper half to lower half and store
-			_mm_storel_pi((__m64*)result, _mm_add_ps(sum, _mm_shuffle_ps(sum, _mm_setzero_ps(), _MM_SHUFFLE(1, 0, 3, 2))));
-		}
+		// add upper half to lower half and store
+		_mm_storel_pi((__m64*)result, _mm_add_ps(sum, _mm_movehl_ps(sum, sum)));
 #else
-		int sample = m_ptr;
-		const Real* coeff = &m_alignedTaps[phase * m_nTaps * 2];
 		Real rAcc = 0;
 		Real iAcc = 0;
 
 		for(int i = 0; i < m_nTaps; i++) {
-			rAcc += *coeff * m_samples[sample].real();
-			iAcc += *coeff * m_samples[sample].imag();
-			sample = (sample + 1) % m_nTaps;
-			coeff += 2;
+			rAcc += coeff[2 * i] * src[2 * i];
+			iAcc += coeff[2 * i] * src[2 * i + 1];
 		}
 		*result = Complex(rAcc, iAcc);
 #endif
-
 	}
 };
 
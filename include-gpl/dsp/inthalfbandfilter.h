@@ -14,21 +14,81 @@
 #define HB_SHIFT 14
 #define DTOFN(x) static_cast<qint32>(x)
 
+// the odd taps see every other input sample, all of them fall on the samples decimated away
+#define HB_EVENTAPS (HB_FILTERORDER / 2)
+// the center tap is this many output samples back
+#define HB_CENTERDELAY (HB_FILTERORDER / 4)
+
+// coefficents
+#if HB_FILTERORDER == 64
+static const qint32 HB_COEFF[16] = {
+	DTOFN(-0.001114417441601693505720538368564120901 * (1 << HB_SHIFT)),
+	DTOFN( 0.001268007827185253051302527005361753254 * (1 << HB_SHIFT)),
+	DTOFN(-0.001959831378850490895410230152151598304 * (1 << HB_SHIFT)),
+	DTOFN( 0.002878308307661380308073439948657323839 * (1 << HB_SHIFT)),
+	DTOFN(-0.004071361818258721100571850826099762344 * (1 << HB_SHIFT)),
+	DTOFN( 0.005597288494657440618973431867289036745 * (1 << HB_SHIFT)),
+	DTOFN(-0.007532345003308904551886371336877346039 * (1 << HB_SHIFT)),
+	DTOFN( 0.009980346844667375288961963519795972388 * (1 << HB_SHIFT)),
+	DTOFN(-0.013092614174300500062830820979797863401 * (1 << HB_SHIFT)),
+	DTOFN( 0.01710934914871829748417297878404497169  * (1 << HB_SHIFT)),
+	DTOFN(-0.022443558692997273018576720460259821266 * (1 << HB_SHIFT)),
+	DTOFN( 0.029875811511593811098386197500076377764 * (1 << HB_SHIFT)),
+	DTOFN(-0.041086352085710403647667021687084343284 * (1 << HB_SHIFT)),
+	DTOFN( 0.060465467462665789533104998554335907102 * (1 << HB_SHIFT)),
+	DTOFN(-0.104159517495977321788203084906854201108 * (1 << HB_SHIFT)),
+	DTOFN( 0.317657589850154464805598308885237202048 * (1 << HB_SHIFT)),
+};
+#elif HB_FILTERORDER == 48
+static const qint32 HB_COEFF[12] = {
+   DTOFN(-0.004102576237611492253332112767338912818 * (1 << HB_SHIFT)),
+	DTOFN(0.003950551047979387886410762575906119309 * (1 << HB_SHIFT)),
+   DTOFN(-0.005807875789391703583164350277456833282 * (1 << HB_SHIFT)),
+	DTOFN(0.00823497890520805998770814682075069868  * (1 << HB_SHIFT)),
+   DTOFN(-0.011372226513199541059195851744334504474 * (1 << HB_SHIFT)),
+	DTOFN(0.015471557140973646315984524335362948477 * (1 << HB_SHIFT)),
+   DTOFN(-0.020944996398689276484450516591095947661 * (1 << HB_SHIFT)),
+	DTOFN(0.028568078132034283034279553703527199104 * (1 << HB_SHIFT)),
+   DTOFN(-0.040015143905614086738964374490024056286 * (1 << HB_SHIFT)),
+	DTOFN(0.059669519431831075095828964549582451582 * (1 << HB_SHIFT)),
+   DTOFN(-0.103669138691865420076609893840213771909 * (1 << HB_SHIFT)),
+	DTOFN(0.317491986549921390015072120149852707982 * (1 << HB_SHIFT))
+};
+#elif HB_FILTERORDER == 32
+static const qint32 HB_COEFF[8] = {
+   DTOFN(-0.015956912844043127236437484839370881673 * (1 << HB_SHIFT)),
+	DTOFN(0.013023031678944928940522274274371739011 * (1 << HB_SHIFT)),
+   DTOFN(-0.01866942273717486777684371190844103694  * (1 << HB_SHIFT)),
+	DTOFN(0.026550887571157304190005987720724078827 * (1 << HB_SHIFT)),
+   DTOFN(-0.038350314277854319344740474662103224546 * (1 << HB_SHIFT)),
+	DTOFN(0.058429248652825838128421764849917963147 * (1 << HB_SHIFT)),
+   DTOFN(-0.102889802028955756885153505209018476307 * (1 << HB_SHIFT)),
+	DTOFN(0.317237706405931241260276465254719369113 * (1 << HB_SHIFT))
+};
+#else
+#error unsupported filter order
+#endif
+
 class SDRANGELOVE_API IntHalfbandFilter {
 public:
 	IntHalfbandFilter();
 
+	// block versions of the work functions below - consume count input samples, write the decimated
+	// samples to out and return how many were written. out may point to in (in-place decimation)
+	int decimateCenter(const Sample* in, int count, Sample* out);
+	int decimateLowerHalf(const Sample* in, int count, Sample* out);
+	int decimateUpperHalf(const Sample* in, int count, Sample* out);
+	// decimateCenter() straight from interleaved unsigned 8 bit I/Q, the conversion happens while the
+	// input is split for the filter kernel - count is in samples (2 * count bytes)
+	int decimateCenterU8(const quint8* in, int count, Sample* out);
+
 	// downsample by 2, return center part of original spectrum
 	bool workDecimateCenter(Sample* sample)
 	{
-		// insert sample into ring-buffer
-		m_samples[m_ptr][0] = sample->real();
-		m_samples[m_ptr][1] = sample->imag();
-
 		switch(m_state) {
 			case 0:
-				// advance write-pointer
-				m_ptr = (m_ptr + HB_FILTERORDER) % (HB_FILTERORDER + 1);
+				// insert sample into ring-buffer
+				storeSample(sample->real(), sample->imag());
 
 				// next state
 				m_state = 1;
@@ -38,10 +98,7 @@ public:
 
 			default:
 				// save result
-				doFIR(sample);
-
-				// advance write-pointer
-				m_ptr = (m_ptr + HB_FILTERORDER) % (HB_FILTERORDER + 1);
+				doFIR(sample, sample->real(), sample->imag());
 
 				// next state
 				m_state = 0;
@@ -57,11 +114,7 @@ public:
 		switch(m_state) {
 			case 0:
 				// insert sample into ring-buffer
-				m_samples[m_ptr][0] = sample->real();
-				m_samples[m_ptr][1] = sample->imag();
-
-				// advance write-pointer
-				m_ptr = (m_ptr + HB_FILTERORDER) % (HB_FILTERORDER + 1);
+				storeSample(sample->real(), sample->imag());
 
 				// next state
 				m_state = 1;
@@ -70,15 +123,8 @@ public:
 				return false;
 
 			default:
-				// insert sample into ring-buffer
-				m_samples[m_ptr][0] = -sample->real();
-				m_samples[m_ptr][1] = sample->imag();
-
 				// save result
-				doFIR(sample);
-
-				// advance write-pointer
-				m_ptr = (m_ptr + HB_FILTERORDER) % (HB_FILTERORDER + 1);
+				doFIR(sample, -sample->real(), sample->imag());
 
 				// next state
 				m_state = 0;
@@ -94,11 +140,7 @@ public:
 			switch(m_state) {
 				case 0:
 					// insert sample into ring-buffer
-					m_samples[m_ptr][0] = -sample->imag();
-					m_samples[m_ptr][1] = sample->real();
-
-					// advance write-pointer
-					m_ptr = (m_ptr + HB_FILTERORDER) % (HB_FILTERORDER + 1);
+					storeSample(-sample->imag(), sample->real());
 
 					// next state
 					m_state = 1;
@@ -107,15 +149,8 @@ public:
 					return false;
 
 				case 1:
-					// insert sample into ring-buffer
-					m_samples[m_ptr][0] = -sample->real();
-					m_samples[m_ptr][1] = -sample->imag();
-
 					// save result
-					doFIR(sample);
-
-					// advance write-pointer
-					m_ptr = (m_ptr + HB_FILTERORDER) % (HB_FILTERORDER + 1);
+					doFIR(sample, -sample->real(), -sample->imag());
 
 					// next state
 					m_state = 2;
@@ -125,11 +160,7 @@ public:
 
 				case 2:
 					// insert sample into ring-buffer
-					m_samples[m_ptr][0] = sample->imag();
-					m_samples[m_ptr][1] = -sample->real();
-
-					// advance write-pointer
-					m_ptr = (m_ptr + HB_FILTERORDER) % (HB_FILTERORDER + 1);
+					storeSample(sample->imag(), -sample->real());
 
 					// next state
 					m_state = 3;
@@ -138,15 +169,8 @@ public:
 					return false;
 
 				default:
-					// insert sample into ring-buffer
-					m_samples[m_ptr][0] = sample->real();
-					m_samples[m_ptr][1] = sample->imag();
-
 					// save result
-					doFIR(sample);
-
-					// advance write-pointer
-					m_ptr = (m_ptr + HB_FILTERORDER) % (HB_FILTERORDER + 1);
+					doFIR(sample, sample->real(), sample->imag());
 
 					// next state
 					m_state = 0;
@@ -162,11 +186,7 @@ public:
 			switch(m_state) {
 				case 0:
 					// insert sample into ring-buffer
-					m_samples[m_ptr][0] = sample->imag();
-					m_samples[m_ptr][1] = -sample->real();
-
-					// advance write-pointer
-					m_ptr = (m_ptr + HB_FILTERORDER) % (HB_FILTERORDER + 1);
+					storeSample(sample->imag(), -sample->real());
 
 					// next state
 					m_state = 1;
@@ -175,15 +195,8 @@ public:
 					return false;
 
 				case 1:
-					// insert sample into ring-buffer
-					m_samples[m_ptr][0] = -sample->real();
-					m_samples[m_ptr][1] = -sample->imag();
-
 					// save result
-					doFIR(sample);
-
-					// advance write-pointer
-					m_ptr = (m_ptr + HB_FILTERORDER) % (HB_FILTERORDER + 1);
+					doFIR(sample, -sample->real(), -sample->imag());
 
 					// next state
 					m_state = 2;
@@ -193,11 +206,7 @@ public:
 
 				case 2:
 					// insert sample into ring-buffer
-					m_samples[m_ptr][0] = -sample->imag();
-					m_samples[m_ptr][1] = sample->real();
-
-					// advance write-pointer
-					m_ptr = (m_ptr + HB_FILTERORDER) % (HB_FILTERORDER + 1);
+					storeSample(-sample->imag(), sample->real());
 
 					// next state
 					m_state = 3;
@@ -206,15 +215,8 @@ public:
 					return false;
 
 				default:
-					// insert sample into ring-buffer
-					m_samples[m_ptr][0] = sample->real();
-					m_samples[m_ptr][1] = sample->imag();
-
 					// save result
-					doFIR(sample);
-
-					// advance write-pointer
-					m_ptr = (m_ptr + HB_FILTERORDER) % (HB_FILTERORDER + 1);
+					doFIR(sample, sample->real(), sample->imag());
 
 					// next state
 					m_state = 0;
@@ -225,90 +227,73 @@ public:
 	}
 
 protected:
-	qint16 m_samples[HB_FILTERORDER + 1][2];
-	int m_ptr;
+	enum {
+		BlockSize = 256 // output samples per run of the block kernel
+	};
+
+	// computes count output samples, output j uses the HB_EVENTAPS samples starting at even[j + 1] for
+	// the odd taps and odd[j] for the center tap - all kernels are bit-exact with doFIR()
+	typedef void (*FIRKernel)(const Sample* even, const Sample* odd, int count, Sample* out);
+
+	// samples feeding the odd taps, stored twice so the window m_even[m_evenPtr]... never wraps
+	qint16 m_even[2 * HB_EVENTAPS][2];
+	// samples feeding the center tap
+	qint16 m_odd[HB_CENTERDELAY][2];
+	int m_evenPtr;
+	int m_oddPtr;
 	int m_state;
 
-	void doFIR(Sample* sample)
-	{
-		// coefficents
+	// linear work buffers of the block functions - history first, then the (rotated) new samples
+	Sample m_evenBlock[HB_EVENTAPS + BlockSize];
+	Sample m_oddBlock[HB_CENTERDELAY + BlockSize];
+	FIRKernel m_firKernel;
 
-#if HB_FILTERORDER == 64
-		static const qint32 COEFF[16] = {
-			DTOFN(-0.001114417441601693505720538368564120901 * (1 << HB_SHIFT)),
-			DTOFN( 0.001268007827185253051302527005361753254 * (1 << HB_SHIFT)),
-			DTOFN(-0.001959831378850490895410230152151598304 * (1 << HB_SHIFT)),
-			DTOFN( 0.002878308307661380308073439948657323839 * (1 << HB_SHIFT)),
-			DTOFN(-0.004071361818258721100571850826099762344 * (1 << HB_SHIFT)),
-			DTOFN( 0.005597288494657440618973431867289036745 * (1 << HB_SHIFT)),
-			DTOFN(-0.007532345003308904551886371336877346039 * (1 << HB_SHIFT)),
-			DTOFN( 0.009980346844667375288961963519795972388 * (1 << HB_SHIFT)),
-			DTOFN(-0.013092614174300500062830820979797863401 * (1 << HB_SHIFT)),
-			DTOFN( 0.01710934914871829748417297878404497169  * (1 << HB_SHIFT)),
-			DTOFN(-0.022443558692997273018576720460259821266 * (1 << HB_SHIFT)),
-			DTOFN( 0.029875811511593811098386197500076377764 * (1 << HB_SHIFT)),
-			DTOFN(-0.041086352085710403647667021687084343284 * (1 << HB_SHIFT)),
-			DTOFN( 0.060465467462665789533104998554335907102 * (1 << HB_SHIFT)),
-			DTOFN(-0.104159517495977321788203084906854201108 * (1 << HB_SHIFT)),
-			DTOFN( 0.317657589850154464805598308885237202048 * (1 << HB_SHIFT)),
-		};
-#elif HB_FILTERORDER == 48
-		static const qint32 COEFF[12] = {
-		   DTOFN(-0.004102576237611492253332112767338912818 * (1 << HB_SHIFT)),
-			DTOFN(0.003950551047979387886410762575906119309 * (1 << HB_SHIFT)),
-		   DTOFN(-0.005807875789391703583164350277456833282 * (1 << HB_SHIFT)),
-			DTOFN(0.00823497890520805998770814682075069868  * (1 << HB_SHIFT)),
-		   DTOFN(-0.011372226513199541059195851744334504474 * (1 << HB_SHIFT)),
-			DTOFN(0.015471557140973646315984524335362948477 * (1 << HB_SHIFT)),
-		   DTOFN(-0.020944996398689276484450516591095947661 * (1 << HB_SHIFT)),
-			DTOFN(0.028568078132034283034279553703527199104 * (1 << HB_SHIFT)),
-		   DTOFN(-0.040015143905614086738964374490024056286 * (1 << HB_SHIFT)),
-			DTOFN(0.059669519431831075095828964549582451582 * (1 << HB_SHIFT)),
-		   DTOFN(-0.103669138691865420076609893840213771909 * (1 << HB_SHIFT)),
-			DTOFN(0.317491986549921390015072120149852707982 * (1 << HB_SHIFT))
-		};
-#elif HB_FILTERORDER == 32
-		static const qint32 COEFF[8] = {
-		   DTOFN(-0.015956912844043127236437484839370881673 * (1 << HB_SHIFT)),
-			DTOFN(0.013023031678944928940522274274371739011 * (1 << HB_SHIFT)),
-		   DTOFN(-0.01866942273717486777684371190844103694  * (1 << HB_SHIFT)),
-			DTOFN(0.026550887571157304190005987720724078827 * (1 << HB_SHIFT)),
-		   DTOFN(-0.038350314277854319344740474662103224546 * (1 << HB_SHIFT)),
-			DTOFN(0.058429248652825838128421764849917963147 * (1 << HB_SHIFT)),
-		   DTOFN(-0.102889802028955756885153505209018476307 * (1 << HB_SHIFT)),
-			DTOFN(0.317237706405931241260276465254719369113 * (1 << HB_SHIFT))
-		};
-#else
-#error unsupported filter order
-#endif
+	static FIRKernel selectKernel();
 
-		// init read-pointer
-		int a = (m_ptr + 1) % (HB_FILTERORDER + 1);
-		int b = (m_ptr + (HB_FILTERORDER - 1)) % (HB_FILTERORDER + 1);
+	void storeSample(qint16 real, qint16 imag)
+	{
+		m_even[m_evenPtr][0] = real;
+		m_even[m_evenPtr][1] = imag;
+		m_even[m_evenPtr + HB_EVENTAPS][0] = real;
+		m_even[m_evenPtr + HB_EVENTAPS][1] = imag;
+		if(++m_evenPtr == HB_EVENTAPS)
+			m_evenPtr = 0;
+	}
+
+	// real/imag is the (rotated) input sample, the result goes to sample
+	void doFIR(Sample* sample, qint16 real, qint16 imag)
+	{
+		// oldest sample first
+		const qint16 (*samples)[2] = &m_even[m_evenPtr];
 
-		// go through samples in buffer
+		// go through samples in buffer, pairing the oldest with the newest one
 		qint32 iAcc = 0;
 		qint32 qAcc = 0;
 		for(int i = 0; i < HB_FILTERORDER / 4; i++) {
 			// do multiply-accumulate
-			qint32 iTmp = m_samples[a][0] + m_samples[b][0];
-			qint32 qTmp = m_samples[a][1] + m_samples[b][1];
-			iAcc += iTmp * COEFF[i];
-			qAcc += qTmp * COEFF[i];
-
-			// update read-pointer
-			a = (a + 2) % (HB_FILTERORDER + 1);
-			b = (b + (HB_FILTERORDER - 1)) % (HB_FILTERORDER + 1);
+			qint32 iTmp = samples[i][0] + samples[HB_EVENTAPS - 1 - i][0];
+			qint32 qTmp = samples[i][1] + samples[HB_EVENTAPS - 1 - i][1];
+			iAcc += iTmp * HB_COEFF[i];
+			qAcc += qTmp * HB_COEFF[i];
 		}
 
-		a = (a + HB_FILTERORDER) % (HB_FILTERORDER + 1);
-		iAcc += m_samples[a][0] * (qint32)(0.5 * (1 << HB_SHIFT));
-		qAcc += m_samples[a][1] * (qint32)(0.5 * (1 << HB_SHIFT));
+		iAcc += m_odd[m_oddPtr][0] * (qint32)(0.5 * (1 << HB_SHIFT));
+		qAcc += m_odd[m_oddPtr][1] * (qint32)(0.5 * (1 << HB_SHIFT));
+
+		// the new sample becomes the center tap HB_CENTERDELAY outputs from now
+		m_odd[m_oddPtr][0] = real;
+		m_odd[m_oddPtr][1] = imag;
+		if(++m_oddPtr == HB_CENTERDELAY)
+			m_oddPtr = 0;
 
 		// done, save result
 		sample->setReal((iAcc + (qint32)(0.5 * (1 << HB_SHIFT))) >> HB_SHIFT);
 		sample->setImag((qAcc + (qint32)(0.5 * (1 << HB_SHIFT))) >> HB_SHIFT);
 	}
+
+	// move the delay lines into the block buffers and back
+	void beginBlock();
+	void endBlock(int count);
 };
 
 #endif // INCLUDE_INTHALFBANDFILTER_H
@@ -0,0 +1,60 @@
+#ifndef INCLUDE_IQCORRECTION_H
+#define INCLUDE_IQCORRECTION_H
+
+#include "dsp/dsptypes.h"
+#include "util/export.h"
+
+// DC offset and IQ imbalance (amplitude and phase) correction in a single pass over each block.
+// The statistics of a block are gathered while the correction estimated from the blocks before is
+// applied, so the corrected output lags the estimate by one block.
+class SDRANGELOVE_API IQCorrection {
+public:
+	struct Correction {
+		float m_iOffset;
+		float m_qOffset;
+		float m_gain; // Q is scaled by this...
+		float m_cross; // ...and this much of I is added to undo the phase error
+	};
+
+	struct Statistics {
+		float m_i;
+		float m_q;
+		float m_ii;
+		float m_qq;
+		float m_iq;
+	};
+
+	typedef void (*Kernel)(Sample* samples, int count, const Correction& correction, Statistics* statistics);
+
+	IQCorrection();
+
+	void configure(bool dcOffsetCorrection, bool iqImbalanceCorrection);
+	bool isEnabled() const { return m_dcOffsetCorrection || m_iqImbalanceCorrection; }
+	void reset();
+
+	void process(Sample* samples, int count);
+
+private:
+	enum {
+		ChunkSize = 4096, // float sums stay accurate enough for this many samples
+		DCTimeConstant = 1 << 16, // samples
+		ImbalanceTimeConstant = 1 << 20 // samples
+	};
+
+	bool m_dcOffsetCorrection;
+	bool m_iqImbalanceCorrection;
+	Kernel m_kernel;
+	Correction m_correction;
+
+	// single pole lowpasses over the block statistics
+	double m_iMean;
+	double m_qMean;
+	double m_iVariance;
+	double m_qVariance;
+	double m_covariance;
+
+	static Kernel selectKernel();
+	void updateCorrection();
+};
+
+#endif // INCLUDE_IQCORRECTION_H
@@ -0,0 +1,98 @@
+#ifndef INCLUDE_IQRECORDER_H
+#define INCLUDE_IQRECORDER_H
+
+#include <vector>
+#include <QAtomicInt>
+#include <QDateTime>
+#include <QFile>
+#include <QMutex>
+#include <QQueue>
+#include <QWaitCondition>
+#include "dsp/samplesink.h"
+#include "util/export.h"
+
+class MessageQueue;
+class IQRecorderWriter;
+
+// records the samples it is fed into a SigMF data/meta file pair - the DSP thread only copies
+// into pooled buffers, a writer thread does the I/O. if the disk cannot keep up whole buffers
+// are dropped and marked as a new capture segment instead of blocking the caller
+class SDRANGELOVE_API IQRecorder : public SampleSink {
+public:
+	// reportQueue gets a DSPIQRecorderStopped when a recording ends without being asked to
+	IQRecorder(MessageQueue* reportQueue = NULL);
+	~IQRecorder();
+
+	// an empty file name stops recording
+	void configure(MessageQueue* msgQueue, const QString& fileName, quint64 centerFrequency, bool directIO = false);
+
+	// to be called from the thread that feeds the recorder
+	bool startRecording(const QString& fileName, int sampleRate, quint64 centerFrequency, bool directIO = false);
+	void stopRecording();
+	void setCenterFrequency(quint64 centerFrequency);
+
+	bool isRecording() const { return m_current != NULL; }
+	int getDroppedBuffers() const { return m_droppedBuffers.load(); }
+
+	void feed(SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst);
+	void start();
+	void stop();
+	bool handleMessage(Message* cmd);
+
+private:
+	friend class IQRecorderWriter;
+
+	enum {
+		BufferSize = 1 << 20, // bytes, a multiple of the O_DIRECT alignment
+		BufferCount = 16,
+		Alignment = 4096
+	};
+
+	struct Buffer {
+		char* m_data;
+		int m_fill;
+	};
+
+	// a new segment starts after every gap and frequency change
+	struct Capture {
+		qint64 m_sampleStart;
+		quint64 m_frequency;
+		QDateTime m_dateTime;
+	};
+	typedef std::vector<Capture> Captures;
+
+	MessageQueue* m_reportQueue;
+	int m_sampleRate;
+	qint64 m_frequencyOffset;
+
+	// shared with the writer thread
+	QMutex m_mutex;
+	QWaitCondition m_bufferQueued;
+	std::vector<char> m_memory;
+	std::vector<Buffer> m_buffers;
+	QQueue<Buffer*> m_freeBuffers;
+	QQueue<Buffer*> m_fullBuffers;
+	bool m_stopWriter;
+	QFile m_file;
+	bool m_writeError;
+	IQRecorderWriter* m_writer;
+
+	// only touched by the feeding thread
+	Buffer* m_current;
+	qint64 m_samplesQueued;
+	QString m_fileName;
+	QString m_metaFileName;
+	// stopped on its own - a late configure with this name must not truncate it
+	QString m_stoppedFileName;
+	quint64 m_centerFrequency;
+	Captures m_captures;
+	QAtomicInt m_droppedBuffers;
+
+	void queueBuffer();
+	void writeBuffers();
+	bool openDataFile(const QString& fileName, bool directIO);
+	void writeTail();
+	bool writeMeta();
+};
+
+#endif // INCLUDE_IQRECORDER_H
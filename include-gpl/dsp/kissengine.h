@@ -9,6 +9,9 @@ public:
 	void configure(int n, bool inverse);
 	void transform();
 
+	void reserve(int count, int stride);
+	void transformMany(int count, int stride);
+
 	Complex* in();
 	Complex* out();
 
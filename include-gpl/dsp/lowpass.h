@@ -3,13 +3,57 @@
 
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <algorithm>
 #include "dsp/dsptypes.h"
+#include "util/export.h"
 
-template <class Type> class Lowpass {
+// symmetric FIR kernels: count outputs, output j uses the nTaps samples starting at in + j * step.
+// taps holds the first half plus the center tap
+class SDRANGELOVE_API LowpassKernels {
 public:
-	Lowpass() { }
+	typedef void (*RealKernel)(const Real* in, int count, int step, const Real* taps, int nTaps, Real* out);
+	typedef void (*ComplexKernel)(const Complex* in, int count, int step, const Real* taps, int nTaps, Complex* out);
+
+	static void filter(const Real* in, int count, int step, const Real* taps, int nTaps, Real* out)
+	{
+		m_realKernel(in, count, step, taps, nTaps, out);
+	}
+	static void filter(const Complex* in, int count, int step, const Real* taps, int nTaps, Complex* out)
+	{
+		m_complexKernel(in, count, step, taps, nTaps, out);
+	}
+
+	// anything else, plain C++
+	template <class Type> static void filter(const Type* in, int count, int step, const Real* taps, int nTaps, Type* out)
+	{
+		for(int j = 0; j < count; j++) {
+			const Type* window = in + j * step;
+			Type acc = 0;
+			int i;
+			for(i = 0; i < nTaps / 2; i++)
+				acc += (window[i] + window[nTaps - 1 - i]) * taps[i];
+			out[j] = acc + window[i] * taps[i];
+		}
+	}
+
+private:
+	static const RealKernel m_realKernel;
+	static const ComplexKernel m_complexKernel;
+
+	static RealKernel selectRealKernel();
+	static ComplexKernel selectComplexKernel();
+};
 
-	void create(int nTaps, double sampleRate, double cutoff)
+template <class Type> class Lowpass {
+public:
+	Lowpass() :
+		m_end(0),
+		m_decimation(1),
+		m_skip(0)
+	{ }
+
+	// with decimation > 1 the block filter() only computes every decimation-th output
+	void create(int nTaps, double sampleRate, double cutoff, int decimation = 1)
 	{
 		double wc = 2.0 * M_PI * cutoff;
 		double Wc = wc / sampleRate;
@@ -21,11 +65,15 @@ public:
 			nTaps++;
 		}
 
-		// make room
-		m_samples.resize(nTaps);
-		for(int i = 0; i < nTaps; i++)
+		// make room - the delay line is linear and twice as long as the filter, the newest nTaps
+		// samples end at m_end and are moved to the front when it runs full
+		m_samples.resize(2 * nTaps);
+		for(int i = 0; i < 2 * nTaps; i++)
 			m_samples[i] = 0;
-		m_ptr = 0;
+		m_end = nTaps;
+		m_nTaps = nTaps;
+		m_decimation = (decimation > 1) ? decimation : 1;
+		m_skip = 0;
 		m_taps.resize(nTaps / 2 + 1);
 
 		// generate Sinc filter core
@@ -49,40 +97,59 @@ public:
 			m_taps[i] /= sum;
 	}
 
+	// one sample in, one out - decimation does not apply here
 	Type filter(Type sample)
 	{
-		Type acc = 0;
-		int a = m_ptr;
-		int b = a - 1;
-		int i;
+		Type acc;
 
-		m_samples[m_ptr] = sample;
+		reserve(1);
+		m_samples[m_end++] = sample;
+		LowpassKernels::filter(&m_samples[m_end - m_nTaps], 1, 1, &m_taps[0], m_nTaps, &acc);
 
-		while(b < 0)
-			b += m_samples.size();
+		return acc;
+	}
 
-		for(i = 0; i < (int)m_taps.size() - 1; i++) {
-			acc +=  (m_samples[a] + m_samples[b]) * m_taps[i];
-			a++;
-			while(a >= (int)m_samples.size())
-				a -= m_samples.size();
-			b--;
-			while(b < 0)
-				b += m_samples.size();
-		}
-		acc += m_samples[a] * m_taps[i];
+	// count samples in, count / decimation out (the phase carries over between blocks). returns the
+	// number of outputs, in place is fine
+	int filter(const Type* in, Type* out, int count)
+	{
+		if(count <= 0)
+			return 0;
 
-		m_ptr++;
-		while(m_ptr >= (int)m_samples.size())
-			m_ptr -= m_samples.size();
+		reserve(count);
+		std::copy(in, in + count, m_samples.begin() + m_end);
 
-		return acc;
+		// window j ends with input j, the first one kept is m_skip
+		int produced = 0;
+		if(m_skip < count) {
+			produced = (count - 1 - m_skip) / m_decimation + 1;
+			LowpassKernels::filter(&m_samples[m_end - m_nTaps + 1 + m_skip], produced, m_decimation, &m_taps[0], m_nTaps, out);
+		}
+		m_skip += produced * m_decimation - count;
+		m_end += count;
+
+		return produced;
 	}
 
 private:
 	std::vector<Real> m_taps;
 	std::vector<Type> m_samples;
-	int m_ptr;
+	int m_end;
+	int m_nTaps;
+	int m_decimation;
+	int m_skip; // inputs to go until the next kept output
+
+	// room for count more samples behind the newest
+	void reserve(int count)
+	{
+		if(m_end + count <= (int)m_samples.size())
+			return;
+
+		std::copy(m_samples.begin() + m_end - m_nTaps, m_samples.begin() + m_end, m_samples.begin());
+		m_end = m_nTaps;
+		if(m_end + count > (int)m_samples.size())
+			m_samples.resize(m_end + count);
+	}
 };
 
 #endif // INCLUDE_LOWPASS_H
@@ -21,25 +21,59 @@
 #include "dsp/dsptypes.h"
 #include "util/export.h"
 
+// the phase is a 32 bit accumulator, so the frequency resolution is sampleRate / 2^32. next() and
+// nextIQ() look the phasor up in a 4096 entry table (spurs around -72 dBc), mix() turns a whole block
+// in one go - either from the same table or, in ModeOscillator, from a recursive oscillator that is
+// re-seeded from the accumulator every few hundred samples (spurs below -100 dBc)
 class SDRANGELOVE_API NCO {
-private:
+public:
 	enum {
-		TableSize = (1 << 12),
+		TableBits = 12,
+		TableSize = (1 << TableBits)
 	};
-	static Real m_table[TableSize];
-	static bool m_tableInitialized;
 
-	static void initTable();
+	enum Mode {
+		ModeTable,
+		ModeOscillator
+	};
 
-	int m_phaseIncrement;
-	int m_phase;
+	// four consecutive phasors, real and imaginary parts kept apart for the SIMD kernels
+	struct Phasors {
+		float m_re[4];
+		float m_im[4];
+	};
+
+	typedef void (*TableKernel)(const Complex* in, Complex* out, int count, const Real* table, quint32* phase, quint32 phaseIncrement);
+	typedef void (*OscillatorKernel)(const Complex* in, Complex* out, int count, const Phasors& start, float stepRe, float stepIm);
 
-public:
 	NCO();
 
 	void setFreq(Real freq, Real sampleRate);
+	void setMode(Mode mode) { m_mode = mode; }
+	Mode getMode() const { return m_mode; }
+
 	Real next();
 	Complex nextIQ();
+	// out[i] = in[i] * nextIQ() for count samples, in place is fine
+	void mix(const Complex* in, Complex* out, int count);
+
+private:
+	enum {
+		ReseedInterval = 1024 // samples, the oscillator drifts by about one float ulp per step of 4
+	};
+	static Real m_table[TableSize];
+	static bool m_tableInitialized;
+
+	static const TableKernel m_tableKernel;
+	static const OscillatorKernel m_oscillatorKernel;
+
+	static void initTable();
+	static TableKernel selectTableKernel();
+	static OscillatorKernel selectOscillatorKernel();
+
+	quint32 m_phaseIncrement;
+	quint32 m_phase;
+	Mode m_mode;
 };
 
 #endif // INCLUDE_NCO_H
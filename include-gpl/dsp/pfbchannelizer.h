@@ -0,0 +1,81 @@
+#ifndef INCLUDE_PFBCHANNELIZER_H
+#define INCLUDE_PFBCHANNELIZER_H
+
+#include <vector>
+#include "dsp/dsptypes.h"
+#include "util/export.h"
+
+class SampleSink;
+class FFTEngine;
+
+// 2x oversampled polyphase filterbank shared by all narrow channels - one FFT every
+// m_nChannels / 2 input samples splits the whole input into bins sampleRate / m_nChannels apart,
+// no matter how many channels are subscribed. A channel gets the bin closest to its center
+// frequency and is told the remaining offset, just like the output of a Channelizer. The bins
+// go out as Complex through feedComplex(), in blocks of up to OutputBlockSize samples.
+class SDRANGELOVE_API PFBChannelizer {
+public:
+	PFBChannelizer();
+	~PFBChannelizer();
+
+	void configure(int sampleRate);
+
+	void addChannel(SampleSink* sampleSink);
+	void removeChannel(SampleSink* sampleSink);
+	void configureChannel(SampleSink* sampleSink, int bandwidth, int centerFrequency);
+	bool hasChannels() const { return !m_channels.empty(); }
+
+	void feed(SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst);
+	void start();
+	void stop();
+
+private:
+	enum {
+		MinChannels = 4,
+		MaxChannels = 1024,
+		TapsPerBranch = 12,
+		OutputBlockSize = 1024
+	};
+
+	struct Channel {
+		SampleSink* m_sampleSink;
+		int m_bandwidth;
+		int m_centerFrequency;
+		int m_bin;
+		ComplexVector m_sampleBuffer;
+
+		Channel(SampleSink* sampleSink) :
+			m_sampleSink(sampleSink),
+			m_bandwidth(0),
+			m_centerFrequency(0),
+			m_bin(0),
+			m_sampleBuffer(OutputBlockSize)
+		{ }
+	};
+	typedef std::vector<Channel*> Channels;
+
+	Channels m_channels;
+	int m_sampleRate;
+	int m_nChannels;
+	int m_decimation;
+	FFTEngine* m_fft;
+
+	// prototype lowpass (symmetric, so it lines up with the input history as it is)
+	std::vector<Real> m_taps;
+	// input history, stored twice so the last m_taps.size() samples are always contiguous
+	std::vector<Complex> m_history;
+	int m_historyPtr;
+	int m_phase;
+	bool m_oddBlock;
+	// samples in every channel's m_sampleBuffer - all of them get one per FFT
+	int m_outputFill;
+	bool m_firstOfBurst;
+
+	void createFilterbank();
+	void assignChannel(Channel* channel);
+	void notifyChannel(Channel* channel);
+	void analyze();
+	void flush();
+};
+
+#endif // INCLUDE_PFBCHANNELIZER_H
@@ -0,0 +1,49 @@
+#ifndef INCLUDE_SAMPLECONVERTER_H
+#define INCLUDE_SAMPLECONVERTER_H
+
+#include "dsp/dsptypes.h"
+#include "util/export.h"
+
+// unpacks interleaved unsigned 8 bit I/Q (RTL-SDR and most cheap receivers) to Sample. The offset
+// binary bytes become the high byte of each component: (b - 128) << 8
+class SDRANGELOVE_API SampleConverter {
+public:
+	// count samples (2 * count bytes) from in to out
+	static void convertU8(const quint8* in, int count, Sample* out);
+	// 2 * count samples, the even ones go to even, the odd ones to odd - this is how the
+	// half-band decimators split their input
+	static void deinterleaveU8(const quint8* in, int count, Sample* even, Sample* odd);
+	// count samples of interleaved float I/Q (gr_complex, std::complex<float>) scaled by scale,
+	// rounded to nearest and saturated to the 16 bit range
+	static void convertFloat(const float* in, int count, float scale, Sample* out);
+
+	// between the int16 and the float pipeline, full scale is 32768 <-> 1.0
+	static void toComplex(const Sample* in, int count, Complex* out);
+	static void fromComplex(const Complex* in, int count, Sample* out)
+	{
+		convertFloat((const float*)in, count, 32768.0f, out);
+	}
+
+	static Sample fromU8(const quint8* in)
+	{
+		return Sample((qint16)((in[0] ^ 0x80) << 8), (qint16)((in[1] ^ 0x80) << 8));
+	}
+
+private:
+	typedef void (*ConvertKernel)(const quint8* in, int count, Sample* out);
+	typedef void (*DeinterleaveKernel)(const quint8* in, int count, Sample* even, Sample* odd);
+	typedef void (*FloatKernel)(const float* in, int count, float scale, Sample* out);
+	typedef void (*ComplexKernel)(const Sample* in, int count, Complex* out);
+
+	static const ConvertKernel m_convertKernel;
+	static const DeinterleaveKernel m_deinterleaveKernel;
+	static const FloatKernel m_floatKernel;
+	static const ComplexKernel m_complexKernel;
+
+	static ConvertKernel selectConvertKernel();
+	static DeinterleaveKernel selectDeinterleaveKernel();
+	static FloatKernel selectFloatKernel();
+	static ComplexKernel selectComplexKernel();
+};
+
+#endif // INCLUDE_SAMPLECONVERTER_H
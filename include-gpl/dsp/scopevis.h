@@ -7,7 +7,7 @@
 class GLScope;
 class MessageQueue;
 
-class SDRANGELOVE_API ScopeVis : public SampleSink {
+class SDRANGELOVE_API ScopeVis : public ComplexSampleSink {
 public:
 	enum TriggerChannel {
 		TriggerFreeRun,
@@ -19,7 +19,7 @@ public:
 
 	void configure(MessageQueue* msgQueue, TriggerChannel triggerChannel, Real triggerLevelHigh, Real triggerLevelLow);
 
-	void feed(SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst);
+	void feedComplex(ComplexVector::const_iterator begin, ComplexVector::const_iterator end, bool firstOfBurst);
 	void start();
 	void stop();
 	bool handleMessage(Message* message);
@@ -36,8 +36,8 @@ private:
 	uint m_fill;
 	TriggerState m_triggerState;
 	TriggerChannel m_triggerChannel;
-	FixReal m_triggerLevelHigh;
-	FixReal m_triggerLevelLow;
+	Real m_triggerLevelHigh;
+	Real m_triggerLevelLow;
 	int m_sampleRate;
 };
 
@@ -1,22 +1,46 @@
 #ifndef INCLUDE_SPECTRUMVIS_H
 #define INCLUDE_SPECTRUMVIS_H
 
+#include <QElapsedTimer>
 #include "dsp/samplesink.h"
 #include "dsp/fftengine.h"
 #include "fftwindow.h"
 #include "util/export.h"
 
-class GLSpectrum;
+class GLSpectrumInterface;
 class MessageQueue;
 
-class SDRANGELOVE_API SpectrumVis : public SampleSink {
+class SDRANGELOVE_API SpectrumVis : public ComplexSampleSink {
 public:
-	SpectrumVis(GLSpectrum* glSpectrum = NULL);
+	// how the power of a bin is turned into dB: log2f() or a polynomial on the mantissa that is
+	// off by at most 0.003 dB
+	enum LogAccuracy {
+		LogExact,
+		LogFast
+	};
+
+	// what happens to the FFTs between two frames when the frame rate is limited: nothing (they
+	// are not even computed), or the bins are averaged (linear power) or held at their maximum
+	// or minimum
+	enum Averaging {
+		AvgNone,
+		AvgLinear,
+		AvgPeakHold,
+		AvgMinHold
+	};
+
+	// count bins to mult * log2(|in|^2) + ofs
+	typedef void (*LogPowerKernel)(const Complex* in, int count, Real mult, Real ofs, Real* out);
+
+	SpectrumVis(GLSpectrumInterface* glSpectrum = NULL);
 	~SpectrumVis();
 
-	void configure(MessageQueue* msgQueue, int fftSize, int overlapPercent, FFTWindow::Function window);
+	void configure(MessageQueue* msgQueue, int fftSize, int overlapPercent, FFTWindow::Function window, LogAccuracy logAccuracy = LogFast);
+	// at most frameRate spectra per second go to the display, 0 sends every FFT
+	void configureFrames(MessageQueue* msgQueue, int frameRate, Averaging averaging);
 
 	void feed(SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst);
+	void feedComplex(ComplexVector::const_iterator begin, ComplexVector::const_iterator end, bool firstOfBurst);
 	void start();
 	void stop();
 	bool handleMessage(Message* message);
@@ -27,16 +51,40 @@ private:
 
 	std::vector<Complex> m_fftBuffer;
 	std::vector<Real> m_logPowerSpectrum;
+	std::vector<Real> m_powerSpectrum; // accumulated, in FFT order
+	int m_powerSpectrumCount;
+	std::vector<Real> m_displaySpectrum; // reduced to the display width
 
 	size_t m_fftSize;
 	size_t m_overlapPercent;
 	size_t m_overlapSize;
 	size_t m_refillSize;
 	size_t m_fftBufferFill;
+	SampleVector m_sampleBuffer; // the same for int16 input
+	size_t m_sampleBufferFill;
+	size_t m_bufferSize;
+	int m_batch;
+	LogAccuracy m_logAccuracy;
+	LogPowerKernel m_logPower;
+
+	int m_frameRate;
+	Averaging m_averaging;
+	QElapsedTimer m_frameTimer;
+	qint64 m_nextFrame; // nanoseconds on m_frameTimer
+
+	GLSpectrumInterface* m_glSpectrum;
 
-	GLSpectrum* m_glSpectrum;
+	static const LogPowerKernel m_logPowerFast;
+	static LogPowerKernel selectLogPowerFast();
 
-	void handleConfigure(int fftSize, int overlapPercent, FFTWindow::Function window);
+	void handleConfigure(int fftSize, int overlapPercent, FFTWindow::Function window, LogAccuracy logAccuracy);
+	void handleConfigureFrames(int frameRate, Averaging averaging);
+	template<typename T> void feedFrames(std::vector<T>* buffer, size_t* fill, const T* begin, const T* end);
+	template<typename T> void processFrames(const T* buffer, int frames);
+	bool frameDue();
+	void accumulate(const Complex* fftOut);
+	void logAccumulated(Real mult, Real ofs);
+	void sendSpectrum();
 };
 
 #endif // INCLUDE_SPECTRUMVIS_H
@@ -21,12 +21,14 @@
 #include <QGLWidget>
 #include <QTimer>
 #include <QMutex>
+#include <QAtomicInt>
 #include "dsp/dsptypes.h"
 #include "gui/scaleengine.h"
 #include "dsp/channelmarker.h"
+#include "dsp/glspectruminterface.h"
 #include "util/export.h"
 
-class SDRANGELOVE_API GLSpectrum : public QGLWidget {
+class SDRANGELOVE_API GLSpectrum : public QGLWidget, public GLSpectrumInterface {
 	Q_OBJECT
 
 public:
@@ -48,6 +50,7 @@ public:
 	void removeChannelMarker(ChannelMarker* channelMarker);
 
 	void newSpectrum(const std::vector<Real>& spectrum, int fftSize);
+	int getDisplayWidth() const { return m_displayWidth.load(); }
 
 private:
 	struct ChannelMarkerState {
@@ -85,6 +88,7 @@ private:
 	quint32 m_sampleRate;
 
 	int m_fftSize;
+	QAtomicInt m_displayWidth; // read by SpectrumVis in the DSP thread
 
 	bool m_displayGrid;
 	bool m_invertedWaterfall;
@@ -4,6 +4,7 @@
 #include <QDialog>
 
 class Preferences;
+class QTreeWidgetItem;
 
 namespace Ui {
 	class PreferencesDialog;
@@ -23,6 +24,7 @@ private:
 
 private slots:
 	void accept();
+	void on_configTree_currentItemChanged(QTreeWidgetItem* current, QTreeWidgetItem* previous);
 };
 
 #endif // INCLUDE_PREFERENCESDIALOG_H
@@ -31,6 +31,7 @@ class DSPEngine;
 class Indicator;
 class ScopeWindow;
 class SpectrumVis;
+class IQRecorder;
 class SampleSource;
 class PluginAPI;
 class PluginGUI;
@@ -74,6 +75,8 @@ private:
 	Settings m_settings;
 
 	SpectrumVis* m_spectrumVis;
+	IQRecorder* m_iqRecorder;
+	QString m_recordFileName;
 
 	DSPEngine* m_dspEngine;
 
@@ -117,6 +120,7 @@ private slots:
 	void on_action_Stop_triggered();
 	void on_dcOffset_toggled(bool checked);
 	void on_iqImbalance_toggled(bool checked);
+	void on_record_toggled(bool checked);
 	void on_action_View_Fullscreen_toggled(bool checked);
 	void on_actionOsmoSDR_Firmware_Upgrade_triggered();
 	void on_presetSave_clicked();
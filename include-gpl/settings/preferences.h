@@ -17,9 +17,13 @@ public:
 	void setAudioOutputRate(quint32 value) { m_audioOutputRate = value; }
 	uint getAudioOutputRate() const { return m_audioOutputRate; }
 
+	void setSinkThreads(int value) { m_sinkThreads = value; }
+	int getSinkThreads() const { return m_sinkThreads; }
+
 protected:
 	QString m_audioOutput;
 	uint m_audioOutputRate;
+	int m_sinkThreads;
 };
 
 #endif // INCLUDE_PREFERENCES_H
@@ -50,5 +50,6 @@ struct Sample {
 #pragma pack(pop)
 
 typedef std::vector<Sample> SampleVector;
+typedef std::vector<Complex> ComplexVector;
 
 #endif // INCLUDE_DSPTYPES_H
@@ -0,0 +1,20 @@
+#ifndef INCLUDE_GLSPECTRUMINTERFACE_H
+#define INCLUDE_GLSPECTRUMINTERFACE_H
+
+#include <vector>
+#include "dsp/dsptypes.h"
+#include "util/export.h"
+
+// what SpectrumVis needs from a display - keeps the DSP side free of OpenGL widgets
+class SDRANGELOVE_API GLSpectrumInterface {
+public:
+	GLSpectrumInterface() { }
+	virtual ~GLSpectrumInterface() { }
+
+	virtual void newSpectrum(const std::vector<Real>& spectrum, int fftSize) = 0;
+	// larger spectra are reduced to about that many bins, 0 takes them as they are. called from
+	// the DSP thread
+	virtual int getDisplayWidth() const { return 0; }
+};
+
+#endif // INCLUDE_GLSPECTRUMINTERFACE_H
@@ -19,7 +19,7 @@
 #define INCLUDE_SAMPLEFIFO_H
 
 #include <QObject>
-#include <QMutex>
+#include <QAtomicInt>
 #include <QTime>
 #include "dsp/dsptypes.h"
 #include "util/export.h"
@@ -28,18 +28,24 @@ class SDRANGELOVE_API SampleFifo : public QObject {
 	Q_OBJECT
 
 private:
-	QMutex m_mutex;
 	QTime m_msgRateTimer;
 	int m_suppressed;
 
-	SampleVector m_data;
+	// single producer / single consumer ring buffer
+	// the storage is mapped twice back to back, so every block starting
+	// inside the ring can be accessed as one contiguous span
+	Sample* m_data;
+	void* m_mapping;
+	bool m_mirrored;
 
 	uint m_size;
-	uint m_fill;
-	uint m_head;
-	uint m_tail;
+	QAtomicInt m_fill;
+	uint m_head; // only touched by the consumer
+	uint m_tail; // only touched by the producer
 
 	void create(uint s);
+	void destroy();
+	void mirror(uint pos, uint count);
 
 public:
 	SampleFifo(QObject* parent = NULL);
@@ -47,16 +53,20 @@ public:
 	~SampleFifo();
 
 	bool setSize(int size);
-	inline uint fill() const { return m_fill; }
+	inline uint size() const { return m_size; }
+	inline uint fill() const { return m_fill.loadAcquire(); }
 
 	uint write(const quint8* data, uint count);
 	uint write(SampleVector::const_iterator begin, SampleVector::const_iterator end);
 
+	// zero-copy producer side: [begin, end) is free space inside the ring (at most count samples,
+	// less if the FIFO is nearly full). fill it, then publish the first n samples with writeCommit(n)
+	uint writeBegin(uint count, SampleVector::iterator* begin, SampleVector::iterator* end);
+	uint writeCommit(uint count);
+
 	uint read(SampleVector::iterator begin, SampleVector::iterator end);
 
-	uint readBegin(uint count,
-		SampleVector::iterator* part1Begin, SampleVector::iterator* part1End,
-		SampleVector::iterator* part2Begin, SampleVector::iterator* part2End);
+	uint readBegin(uint count, SampleVector::iterator* begin, SampleVector::iterator* end);
 	uint readCommit(uint count);
 
 signals:
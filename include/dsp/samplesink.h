@@ -13,9 +13,25 @@ public:
 	virtual ~SampleSink();
 
 	virtual void feed(SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst) = 0;
+	// float samples scaled to [-1, 1) - sinks working on int16 get a converted copy
+	virtual void feedComplex(ComplexVector::const_iterator begin, ComplexVector::const_iterator end, bool firstOfBurst);
 	virtual void start() = 0;
 	virtual void stop() = 0;
 	virtual bool handleMessage(Message* cmd) = 0;
+
+private:
+	SampleVector m_convertBuffer;
+};
+
+// a sink working on Complex: int16 input is converted once on entry, float producers hand
+// their blocks over without a round trip through int16
+class SDRANGELOVE_API ComplexSampleSink : public SampleSink {
+public:
+	void feed(SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst);
+	virtual void feedComplex(ComplexVector::const_iterator begin, ComplexVector::const_iterator end, bool firstOfBurst) = 0;
+
+private:
+	ComplexVector m_complexBuffer;
 };
 
 #endif // INCLUDE_SAMPLESINK_H
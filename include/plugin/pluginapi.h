@@ -40,6 +40,12 @@ public:
 	void setSampleSource(SampleSource* sampleSource);
 	void addSampleSink(SampleSink* sampleSink);
 	void removeSampleSink(SampleSink* sampleSink);
+	void addPFBSink(SampleSink* sampleSink);
+	void removePFBSink(SampleSink* sampleSink);
+	void configurePFBSink(SampleSink* sampleSink, int bandwidth, int centerFrequency);
+	void addChannelizerSink(SampleSink* sampleSink);
+	void removeChannelizerSink(SampleSink* sampleSink);
+	void configureChannelizerSink(SampleSink* sampleSink, int sampleRate, int centerFrequency);
 	MessageQueue* getDSPEngineMessageQueue();
 	void addAudioSource(AudioFifo* audioFifo);
 	void removeAudioSource(AudioFifo* audioFifo);
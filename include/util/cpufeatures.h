@@ -0,0 +1,41 @@
+#ifndef INCLUDE_CPUFEATURES_H
+#define INCLUDE_CPUFEATURES_H
+
+#include "util/export.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CPUFEATURES_X86
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define CPUFEATURES_NEON
+#endif
+
+// GCC and clang compile single functions for a newer instruction set than the rest of the build,
+// MSVC accepts all intrinsics anyway
+#if defined(CPUFEATURES_X86) && (defined(__GNUC__) || defined(__clang__))
+#define CPUFEATURES_TARGET(isa) __attribute__((target(isa)))
+#else
+#define CPUFEATURES_TARGET(isa)
+#endif
+
+// instruction sets usable on the machine we are running on (detected on first use)
+class SDRANGELOVE_API CPUFeatures {
+public:
+	enum Feature {
+		SSE2 = 0x01,
+		SSSE3 = 0x02,
+		SSE41 = 0x04,
+		AVX = 0x08,
+		AVX2 = 0x10,
+		FMA = 0x20,
+		NEON = 0x40
+	};
+
+	static bool has(Feature feature);
+
+private:
+	static int detect();
+};
+
+#endif // INCLUDE_CPUFEATURES_H
@@ -18,6 +18,8 @@
 #include <QTime>
 #include <stdio.h>
 #include <complex.h>
+#include <string.h>
+#include <algorithm>
 #include "nfmdemod.h"
 #include "audio/audiooutput.h"
 #include "dsp/dspcommands.h"
@@ -55,41 +57,8 @@ void NFMDemod::configure(MessageQueue* messageQueue, Real rfBandwidth, Real afBa
 	cmd->submit(messageQueue, this);
 }
 
-float arctan2(Real y, Real x)
+void NFMDemod::feedComplex(ComplexVector::const_iterator begin, ComplexVector::const_iterator end, bool firstOfBurst)
 {
-	Real coeff_1 = M_PI / 4;
-	Real coeff_2 = 3 * coeff_1;
-	Real abs_y = fabs(y) + 1e-10;      // kludge to prevent 0/0 condition
-	Real angle;
-	if( x>= 0) {
-		Real r = (x - abs_y) / (x + abs_y);
-		angle = coeff_1 - coeff_1 * r;
-	} else {
-		Real r = (x + abs_y) / (abs_y - x);
-		angle = coeff_2 - coeff_1 * r;
-	}
-	if(y < 0)
-		return(-angle);
-	else return(angle);
-}
-
-Real angleDist(Real a, Real b)
-{
-	Real dist = b - a;
-
-	while(dist <= M_PI)
-		dist += 2 * M_PI;
-	while(dist >= M_PI)
-		dist -= 2 * M_PI;
-
-	return dist;
-}
-
-void NFMDemod::feed(SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst)
-{
-	Complex ci;
-	bool consumed;
-
 	if(m_audioFifo->size() <= 0)
 		return;
 
@@ -121,83 +90,111 @@ void NFMDemod::feed(SampleVector::const_iterator begin, SampleVector::const_iter
 		m_interpolatorDistance = m_interpolatorRegulation * (Real)m_running.m_inputSampleRate / (Real)m_running.m_audioSampleRate;
 	}
 
-	for(SampleVector::const_iterator it = begin; it != end; ++it) {
-		Complex c(it->real() / 32768.0, it->imag() / 32768.0);
-		c *= m_nco.nextIQ();
-
-		consumed = false;
-		while(!consumed) {
-			if(m_interpolator.interpolate(&m_interpolatorDistanceRemain, c, &consumed, &ci)) {
-				m_sampleBuffer.push_back(Sample(ci.real() * 32767.0, ci.imag() * 32767.0));
-
-				m_movingAverage.feed(ci.real() * ci.real() + ci.imag() * ci.imag());
-				if(m_movingAverage.average() >= m_squelchLevel)
-					m_squelchState = m_running.m_audioSampleRate/ 20;
-
-				qint16 sample;
-
-				m_squelchState = 999;
-				if(m_squelchState > 0) {
-					m_squelchState--;
-					/*
-					Real argument = arg(ci);
-					Real demod = argument - m_lastArgument;
-					m_lastArgument = argument;
-					*/
-
-					Complex d = conj(m_lastSample) * ci;
-					m_lastSample = ci;
-					Real demod = atan2(d.imag(), d.real());
-					//Real demod = arctan2(d.imag(), d.real());
-/*
-					Real argument1 = arg(ci);//atan2(ci.imag(), ci.real());
-					Real argument2 = m_lastSample.real();
-					Real demod = angleDist(argument2, argument1);
-					m_lastSample = Complex(argument1, 0);
-*/
-
-
-					demod /= M_PI;
-
-					demod = m_lowpass.filter(demod);
-
-					if(demod < -1)
-						demod = -1;
-					else if(demod > 1)
-						demod = 1;
-
-					demod *= m_running.m_volume;
-					sample = demod * 32700;
-
-				} else {
-					sample = 0;
-					qDebug("!!!");
-				}
-
-				m_audioBuffer[m_audioBufferFill].l = sample;
-				m_audioBuffer[m_audioBufferFill].r = sample;
-				++m_audioBufferFill;
-				if(m_audioBufferFill >= m_audioBuffer.size()) {
-					uint res = m_audioFifo->write((const quint8*)&m_audioBuffer[0], m_audioBufferFill, 1);
-					if(res != m_audioBufferFill)
-						qDebug("lost %u audio samples", m_audioBufferFill - res);
-					m_audioBufferFill = 0;
-				}
-
-				m_interpolatorDistanceRemain += m_interpolatorDistance;
+	int count = end - begin;
+	if(count <= 0)
+		return;
+
+	// shift the whole block down to baseband first
+	if((int)m_mixBuffer.size() < count)
+		m_mixBuffer.resize(count);
+	m_nco.mix(&(*begin), &m_mixBuffer[0], count);
+
+	// down to audio rate, the spectrum gets the same samples
+	int maxCount = Interpolator::maxOutput(count, m_interpolatorDistance);
+	if((int)m_sampleBuffer.size() < maxCount)
+		m_sampleBuffer.resize(maxCount);
+	int produced = m_interpolator.resample(&m_interpolatorDistanceRemain, m_interpolatorDistance, &m_mixBuffer[0], count, &m_sampleBuffer[0]);
+
+	// the squelch splits the block into runs - open ones go through the discriminator and the
+	// audio lowpass in one go, closed ones are written as silence
+	if((int)m_demodBuffer.size() < produced)
+		m_demodBuffer.resize(produced);
+
+	int i = 0;
+	bool open = (produced > 0) && squelch(m_sampleBuffer[0]);
+	while(i < produced) {
+		int j = i + 1;
+		bool next = open;
+		while(j < produced) {
+			next = squelch(m_sampleBuffer[j]);
+			if(next != open)
+				break;
+			j++;
+		}
+
+		if(open) {
+			m_discriminator.demod(&m_sampleBuffer[i], j - i, &m_demodBuffer[0]);
+			m_lowpass.filter(&m_demodBuffer[0], &m_demodBuffer[0], j - i);
+			writeAudio(&m_demodBuffer[0], j - i);
+		} else {
+			// keep the discriminator in step for when the squelch opens again
+			m_discriminator.setLast(m_sampleBuffer[j - 1]);
+			writeAudio(NULL, j - i);
+		}
+
+		i = j;
+		open = next;
+	}
+	flushAudio();
+
+	if(m_sampleSink != NULL)
+		m_sampleSink->feedComplex(m_sampleBuffer.begin(), m_sampleBuffer.begin() + produced, firstOfBurst);
+}
+
+bool NFMDemod::squelch(const Complex& sample)
+{
+	m_movingAverage.feed(sample.real() * sample.real() + sample.imag() * sample.imag());
+	if(m_movingAverage.average() >= m_squelchLevel)
+		m_squelchState = m_running.m_audioSampleRate / 20;
+
+	if(m_squelchState > 0) {
+		m_squelchState--;
+		return true;
+	} else {
+		return false;
+	}
+}
+
+// demod == NULL writes silence
+void NFMDemod::writeAudio(const Real* demod, int count)
+{
+	Real gain = m_running.m_volume * 32700;
+
+	while(count > 0) {
+		int todo = std::min(count, (int)(m_audioBuffer.size() - m_audioBufferFill));
+		AudioSample* dst = &m_audioBuffer[m_audioBufferFill];
+
+		if(demod == NULL) {
+			memset(dst, 0, todo * sizeof(AudioSample));
+		} else {
+			for(int i = 0; i < todo; i++) {
+				Real v = demod[i];
+				if(v < -1)
+					v = -1;
+				else if(v > 1)
+					v = 1;
+				qint16 sample = v * gain;
+				dst[i].l = sample;
+				dst[i].r = sample;
 			}
+			demod += todo;
 		}
+
+		m_audioBufferFill += todo;
+		count -= todo;
+		if(m_audioBufferFill >= m_audioBuffer.size())
+			flushAudio();
 	}
+}
+
+void NFMDemod::flushAudio()
+{
 	if(m_audioBufferFill > 0) {
 		uint res = m_audioFifo->write((const quint8*)&m_audioBuffer[0], m_audioBufferFill, 1);
 		if(res != m_audioBufferFill)
-			qDebug("lost %u samples", m_audioBufferFill - res);
+			qDebug("lost %u audio samples", m_audioBufferFill - res);
 		m_audioBufferFill = 0;
 	}
-
-	if(m_sampleSink != NULL)
-		m_sampleSink->feed(m_sampleBuffer.begin(), m_sampleBuffer.end(), firstOfBurst);
-	m_sampleBuffer.clear();
 }
 
 void NFMDemod::start()
@@ -208,7 +205,7 @@ void NFMDemod::start()
 	m_interpolatorRegulation = 0.9999;
 	m_interpolatorDistance = 1.0;
 	m_interpolatorDistanceRemain = 0.0;
-	m_lastSample = 0;
+	m_discriminator.setLast(0);
 }
 
 void NFMDemod::stop()
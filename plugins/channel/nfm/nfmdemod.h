@@ -23,20 +23,21 @@
 #include "dsp/nco.h"
 #include "dsp/interpolator.h"
 #include "dsp/lowpass.h"
+#include "dsp/fmdiscriminator.h"
 #include "dsp/movingaverage.h"
 #include "audio/audiofifo.h"
 #include "util/message.h"
 
 class AudioFifo;
 
-class NFMDemod : public SampleSink {
+class NFMDemod : public ComplexSampleSink {
 public:
 	NFMDemod(AudioFifo* audioFifo, SampleSink* sampleSink);
 	~NFMDemod();
 
 	void configure(MessageQueue* messageQueue, Real rfBandwidth, Real afBandwidth, Real volume, Real squelch);
 
-	void feed(SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst);
+	void feedComplex(ComplexVector::const_iterator begin, ComplexVector::const_iterator end, bool firstOfBurst);
 	void start();
 	void stop();
 	bool handleMessage(Message* cmd);
@@ -106,17 +107,18 @@ private:
 	Config m_running;
 
 	NCO m_nco;
+	ComplexVector m_mixBuffer;
 	Real m_interpolatorRegulation;
 	Interpolator m_interpolator;
 	Real m_interpolatorDistance;
 	Real m_interpolatorDistanceRemain;
 	Lowpass<Real> m_lowpass;
+	std::vector<Real> m_demodBuffer;
 
 	Real m_squelchLevel;
 	int m_squelchState;
 
-	Real m_lastArgument;
-	Complex m_lastSample;
+	FMDiscriminator m_discriminator;
 	MovingAverage m_movingAverage;
 
 	AudioVector m_audioBuffer;
@@ -124,9 +126,12 @@ private:
 	AudioFifo* m_audioFifo;
 
 	SampleSink* m_sampleSink;
-	SampleVector m_sampleBuffer;
+	ComplexVector m_sampleBuffer;
 
 	void apply();
+	bool squelch(const Complex& sample);
+	void writeAudio(const Real* demod, int count);
+	void flushAudio();
 };
 
 #endif // INCLUDE_NFMDEMOD_H
@@ -5,7 +5,6 @@
 #include "nfmdemodgui.h"
 #include "ui_nfmdemodgui.h"
 #include "dsp/threadedsamplesink.h"
-#include "dsp/channelizer.h"
 #include "nfmdemod.h"
 #include "dsp/spectrumvis.h"
 #include "gui/glspectrum.h"
@@ -158,10 +157,9 @@ NFMDemodGUI::NFMDemodGUI(PluginAPI* pluginAPI, QWidget* parent) :
 	m_audioFifo = new AudioFifo(4, 48000);
 	m_spectrumVis = new SpectrumVis(ui->glSpectrum);
 	m_nfmDemod = new NFMDemod(m_audioFifo, m_spectrumVis);
-	m_channelizer = new Channelizer(m_nfmDemod);
-	m_threadedSampleSink = new ThreadedSampleSink(m_channelizer);
+	m_threadedSampleSink = new ThreadedSampleSink(m_nfmDemod);
 	m_pluginAPI->addAudioSource(m_audioFifo);
-	m_pluginAPI->addSampleSink(m_threadedSampleSink);
+	m_pluginAPI->addPFBSink(m_threadedSampleSink);
 
 	ui->glSpectrum->setCenterFrequency(0);
 	ui->glSpectrum->setSampleRate(48000);
@@ -186,9 +184,8 @@ NFMDemodGUI::~NFMDemodGUI()
 {
 	m_pluginAPI->removeChannelInstance(this);
 	m_pluginAPI->removeAudioSource(m_audioFifo);
-	m_pluginAPI->removeSampleSink(m_threadedSampleSink);
+	m_pluginAPI->removePFBSink(m_threadedSampleSink);
 	delete m_threadedSampleSink;
-	delete m_channelizer;
 	delete m_nfmDemod;
 	delete m_spectrumVis;
 	delete m_audioFifo;
@@ -199,8 +196,8 @@ NFMDemodGUI::~NFMDemodGUI()
 void NFMDemodGUI::applySettings()
 {
 	setTitleColor(m_channelMarker->getColor());
-	m_channelizer->configure(m_threadedSampleSink->getMessageQueue(),
-		48000,
+	m_pluginAPI->configurePFBSink(m_threadedSampleSink,
+		m_rfBW[ui->rfBW->value()],
 		m_channelMarker->getCenterFrequency());
 	m_nfmDemod->configure(m_threadedSampleSink->getMessageQueue(),
 		m_rfBW[ui->rfBW->value()],
@@ -9,7 +9,6 @@ class ChannelMarker;
 
 class AudioFifo;
 class ThreadedSampleSink;
-class Channelizer;
 class NFMDemod;
 class SpectrumVis;
 
@@ -49,7 +48,6 @@ private:
 
 	AudioFifo* m_audioFifo;
 	ThreadedSampleSink* m_threadedSampleSink;
-	Channelizer* m_channelizer;
 	NFMDemod* m_nfmDemod;
 	SpectrumVis* m_spectrumVis;
 
@@ -4,6 +4,7 @@
 #include "tcpsrc.h"
 #include "tcpsrcgui.h"
 #include "dsp/dspcommands.h"
+#include "dsp/sampleconverter.h"
 
 MESSAGE_CLASS_DEFINITION(TCPSrc::MsgTCPSrcConfigure, Message)
 MESSAGE_CLASS_DEFINITION(TCPSrc::MsgTCPSrcConnection, Message)
@@ -43,24 +44,32 @@ void TCPSrc::setSpectrum(MessageQueue* messageQueue, bool enabled)
 	cmd->submit(messageQueue, this);
 }
 
-void TCPSrc::feed(SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst)
+void TCPSrc::feedComplex(ComplexVector::const_iterator begin, ComplexVector::const_iterator end, bool firstOfBurst)
 {
-	Complex ci;
-	bool consumed;
+	int count = end - begin;
+	if(count <= 0)
+		return;
 
-	for(SampleVector::const_iterator it = begin; it < end; ++it) {
-		Complex c(it->real() / 32768.0, it->imag() / 32768.0);
-		c *= m_nco.nextIQ();
+	// shift the whole block down to baseband first
+	if((int)m_mixBuffer.size() < count)
+		m_mixBuffer.resize(count);
+	m_nco.mix(&(*begin), &m_mixBuffer[0], count);
 
-		consumed = false;
-		if(m_interpolator.interpolate(&m_sampleDistanceRemain, c, &consumed, &ci)) {
-			m_sampleBuffer.push_back(Sample(ci.real() * 32768.0, ci.imag() * 32768.0));
-			m_sampleDistanceRemain += m_inputSampleRate / m_outputSampleRate;
-		}
-	}
+	Real step = m_inputSampleRate / m_outputSampleRate;
+	int maxCount = Interpolator::maxOutput(count, step);
+	if((int)m_complexBuffer.size() < maxCount)
+		m_complexBuffer.resize(maxCount);
+	int produced = m_interpolator.resample(&m_sampleDistanceRemain, step, &m_mixBuffer[0], count, &m_complexBuffer[0]);
 
 	if((m_spectrum != NULL) && (m_spectrumEnabled))
-		m_spectrum->feed(m_sampleBuffer.begin(), m_sampleBuffer.end(), firstOfBurst);
+		m_spectrum->feedComplex(m_complexBuffer.begin(), m_complexBuffer.begin() + produced, firstOfBurst);
+
+	// the network formats are int16 and int8 - only convert if someone is listening
+	if((m_s16leSockets.count() > 0) || (m_s8Sockets.count() > 0)) {
+		m_sampleBuffer.resize(produced);
+		if(produced > 0)
+			SampleConverter::fromComplex(&m_complexBuffer[0], produced, &m_sampleBuffer[0]);
+	}
 
 	for(int i = 0; i < m_s16leSockets.count(); i++)
 		m_s16leSockets[i].socket->write((const char*)&m_sampleBuffer[0], m_sampleBuffer.size() * 4);
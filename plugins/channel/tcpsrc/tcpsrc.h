@@ -11,7 +11,7 @@ class QTcpServer;
 class QTcpSocket;
 class TCPSrcGUI;
 
-class TCPSrc : public SampleSink {
+class TCPSrc : public ComplexSampleSink {
 	Q_OBJECT
 
 public:
@@ -26,7 +26,7 @@ public:
 	void configure(MessageQueue* messageQueue, SampleFormat sampleFormat, Real outputSampleRate, Real rfBandwidth, int tcpPort);
 	void setSpectrum(MessageQueue* messageQueue, bool enabled);
 
-	void feed(SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst);
+	void feedComplex(ComplexVector::const_iterator begin, ComplexVector::const_iterator end, bool firstOfBurst);
 	void start();
 	void stop();
 	bool handleMessage(Message* cmd);
@@ -120,9 +120,11 @@ protected:
 	int m_tcpPort;
 
 	NCO m_nco;
+	ComplexVector m_mixBuffer;
 	Interpolator m_interpolator;
 	Real m_sampleDistanceRemain;
 
+	ComplexVector m_complexBuffer;
 	SampleVector m_sampleBuffer;
 	std::vector<qint8> m_sampleBufferS8;
 	SampleSink* m_spectrum;
@@ -1,7 +1,6 @@
 #include "tcpsrcgui.h"
 #include "plugin/pluginapi.h"
 #include "tcpsrc.h"
-#include "dsp/channelizer.h"
 #include "dsp/spectrumvis.h"
 #include "dsp/threadedsamplesink.h"
 #include "util/simpleserializer.h"
@@ -130,9 +129,8 @@ TCPSrcGUI::TCPSrcGUI(PluginAPI* pluginAPI, QWidget* parent) :
 
 	m_spectrumVis = new SpectrumVis(ui->glSpectrum);
 	m_tcpSrc = new TCPSrc(m_pluginAPI->getMainWindowMessageQueue(), this, m_spectrumVis);
-	m_channelizer = new Channelizer(m_tcpSrc);
-	m_threadedSampleSink = new ThreadedSampleSink(m_channelizer);
-	m_pluginAPI->addSampleSink(m_threadedSampleSink);
+	m_threadedSampleSink = new ThreadedSampleSink(m_tcpSrc);
+	m_pluginAPI->addChannelizerSink(m_threadedSampleSink);
 
 	ui->glSpectrum->setCenterFrequency(0);
 	ui->glSpectrum->setSampleRate(ui->sampleRate->text().toInt());
@@ -155,9 +153,8 @@ TCPSrcGUI::TCPSrcGUI(PluginAPI* pluginAPI, QWidget* parent) :
 TCPSrcGUI::~TCPSrcGUI()
 {
 	m_pluginAPI->removeChannelInstance(this);
-	m_pluginAPI->removeSampleSink(m_threadedSampleSink);
+	m_pluginAPI->removeChannelizerSink(m_threadedSampleSink);
 	delete m_threadedSampleSink;
-	delete m_channelizer;
 	delete m_tcpSrc;
 	delete m_spectrumVis;
 	delete m_channelMarker;
@@ -187,7 +184,7 @@ void TCPSrcGUI::applySettings()
 	connect(m_channelMarker, SIGNAL(changed()), this, SLOT(channelMarkerChanged()));
 	ui->glSpectrum->setSampleRate(outputSampleRate);
 
-	m_channelizer->configure(m_threadedSampleSink->getMessageQueue(),
+	m_pluginAPI->configureChannelizerSink(m_threadedSampleSink,
 		outputSampleRate,
 		m_channelMarker->getCenterFrequency());
 
@@ -9,7 +9,6 @@
 class PluginAPI;
 class ChannelMarker;
 class ThreadedSampleSink;
-class Channelizer;
 class TCPSrc;
 class SpectrumVis;
 
@@ -56,7 +55,6 @@ private:
 
 	// RF path
 	ThreadedSampleSink* m_threadedSampleSink;
-	Channelizer* m_channelizer;
 	TCPSrc* m_tcpSrc;
 	SpectrumVis* m_spectrumVis;
 
@@ -15,14 +15,11 @@
 // along with this program. If not, see <http://www.gnu.org/licenses/>.          //
 ///////////////////////////////////////////////////////////////////////////////////
 
-#include <stdio.h>
 #include "tetrademod.h"
 #include "dsp/dspcommands.h"
 
 MessageRegistrator TetraDemod::MsgConfigureTetraDemod::ID("MsgConfigureTetraDemod");
 
-static FILE* f = NULL;
-
 TetraDemod::TetraDemod(SampleSink* sampleSink) :
 	m_sampleSink(sampleSink)
 {
@@ -44,32 +41,27 @@ void TetraDemod::configure(MessageQueue* messageQueue)
 	cmd->submit(messageQueue, this);
 }
 
-void TetraDemod::feed(SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst)
+void TetraDemod::feedComplex(ComplexVector::const_iterator begin, ComplexVector::const_iterator end, bool firstOfBurst)
 {
-	size_t count = end - begin;
-
-	Complex ci;
-	bool consumed;
+	int count = end - begin;
+	if(count <= 0)
+		return;
 
-	for(SampleVector::const_iterator it = begin; it < end; ++it) {
-		Complex c(it->real() / 32768.0, it->imag() / 32768.0);
-		c *= m_nco.nextIQ();
+	// shift the whole block down to baseband first
+	if((int)m_mixBuffer.size() < count)
+		m_mixBuffer.resize(count);
+	m_nco.mix(&(*begin), &m_mixBuffer[0], count);
 
-		consumed = false;
-		if(m_interpolator.interpolate(&m_sampleDistanceRemain, c, &consumed, &ci)) {
-			m_sampleBuffer.push_back(Sample(ci.real() * 32768.0, ci.imag() * 32768.0));
+	Real step = (Real)m_sampleRate / 36000.0;
+	int maxCount = Interpolator::maxOutput(count, step);
+	if((int)m_sampleBuffer.size() < maxCount)
+		m_sampleBuffer.resize(maxCount);
+	int produced = m_interpolator.resample(&m_sampleDistanceRemain, step, &m_mixBuffer[0], count, &m_sampleBuffer[0]);
 
-			m_sampleDistanceRemain += (Real)m_sampleRate / 36000.0;
-		}
-	}
-
-	if(f != NULL) {
-		fwrite(&m_sampleBuffer[0], m_sampleBuffer.size(), sizeof(m_sampleBuffer[0]), f);
-	}
+	m_recorder.feedComplex(m_sampleBuffer.begin(), m_sampleBuffer.begin() + produced, firstOfBurst);
 
 	if(m_sampleSink != NULL)
-		m_sampleSink->feed(m_sampleBuffer.begin(), m_sampleBuffer.end(), firstOfBurst);
-	m_sampleBuffer.clear();
+		m_sampleSink->feedComplex(m_sampleBuffer.begin(), m_sampleBuffer.begin() + produced, firstOfBurst);
 }
 
 void TetraDemod::start()
@@ -92,14 +84,11 @@ bool TetraDemod::handleMessage(Message* cmd)
 		cmd->completed();
 		return true;
 	} else if(cmd->id() == MsgConfigureTetraDemod::ID()) {
-		if(f == NULL) {
-			f = fopen("/tmp/tetra.iq", "wb");
-			qDebug("started writing samples");
-		} else {
-			fclose(f);
-			f = NULL;
-			qDebug("stopped writing samples");
-		}
+		if(!m_recorder.isRecording())
+			m_recorder.startRecording("/tmp/tetra", 36000, 0);
+		else m_recorder.stopRecording();
+		cmd->completed();
+		return true;
 	} else {
 		return false;
 	}
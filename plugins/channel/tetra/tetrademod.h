@@ -21,18 +21,19 @@
 #include "dsp/samplesink.h"
 #include "dsp/nco.h"
 #include "dsp/interpolator.h"
+#include "dsp/iqrecorder.h"
 #include "util/message.h"
 
 class MessageQueue;
 
-class TetraDemod : public SampleSink {
+class TetraDemod : public ComplexSampleSink {
 public:
 	TetraDemod(SampleSink* sampleSink);
 	~TetraDemod();
 
 	void configure(MessageQueue* messageQueue);
 
-	void feed(SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst);
+	void feedComplex(ComplexVector::const_iterator begin, ComplexVector::const_iterator end, bool firstOfBurst);
 	void start();
 	void stop();
 	bool handleMessage(Message* cmd);
@@ -57,11 +58,13 @@ private:
 	int m_frequency;
 
 	NCO m_nco;
+	ComplexVector m_mixBuffer;
 	Interpolator m_interpolator;
 	Real m_sampleDistanceRemain;
 
 	SampleSink* m_sampleSink;
-	SampleVector m_sampleBuffer;
+	ComplexVector m_sampleBuffer;
+	IQRecorder m_recorder;
 };
 
 #endif // INCLUDE_TETRADEMOD_H
@@ -0,0 +1,168 @@
+#include <QFileDialog>
+#include "filesourcegui.h"
+#include "ui_filesourcegui.h"
+#include "plugin/pluginapi.h"
+
+FileSourceGui::FileSourceGui(PluginAPI* pluginAPI, QWidget* parent) :
+	QWidget(parent),
+	ui(new Ui::FileSourceGui),
+	m_pluginAPI(pluginAPI),
+	m_settings(),
+	m_sampleSource(NULL)
+{
+	ui->setupUi(this);
+	ui->centerFrequency->setValueRange(7, 0U, 9999999U);
+	connect(&m_updateTimer, SIGNAL(timeout()), this, SLOT(updateHardware()));
+	displaySettings();
+
+	m_sampleSource = new FileSourceInput(m_pluginAPI->getMainWindowMessageQueue());
+	m_pluginAPI->setSampleSource(m_sampleSource);
+}
+
+FileSourceGui::~FileSourceGui()
+{
+	delete ui;
+}
+
+void FileSourceGui::destroy()
+{
+	delete this;
+}
+
+void FileSourceGui::setName(const QString& name)
+{
+	setObjectName(name);
+}
+
+void FileSourceGui::resetToDefaults()
+{
+	m_generalSettings.resetToDefaults();
+	m_settings.resetToDefaults();
+	displaySettings();
+	sendSettings();
+}
+
+QByteArray FileSourceGui::serializeGeneral() const
+{
+	return m_generalSettings.serialize();
+}
+
+bool FileSourceGui::deserializeGeneral(const QByteArray&data)
+{
+	if(m_generalSettings.deserialize(data)) {
+		displaySettings();
+		sendSettings();
+		return true;
+	} else {
+		resetToDefaults();
+		return false;
+	}
+}
+
+quint64 FileSourceGui::getCenterFrequency() const
+{
+	return m_generalSettings.m_centerFrequency;
+}
+
+QByteArray FileSourceGui::serialize() const
+{
+	return m_settings.serialize();
+}
+
+bool FileSourceGui::deserialize(const QByteArray& data)
+{
+	if(m_settings.deserialize(data)) {
+		displaySettings();
+		sendSettings();
+		return true;
+	} else {
+		resetToDefaults();
+		return false;
+	}
+}
+
+bool FileSourceGui::handleMessage(Message* message)
+{
+	if(FileSourceInput::MsgReportFileSource::match(message)) {
+		FileSourceInput::MsgReportFileSource* report = (FileSourceInput::MsgReportFileSource*)message;
+		double seconds = (double)report->getSampleCount() / report->getSampleRate();
+		ui->info->setText(tr("%1 kS/s, %2:%3")
+			.arg(report->getSampleRate() / 1000.0, 0, 'f', 1)
+			.arg((int)seconds / 60)
+			.arg(seconds - 60 * ((int)seconds / 60), 4, 'f', 1, QChar('0')));
+		// a frequency from the file wins over the dial
+		if(report->getCenterFrequency() != 0) {
+			m_generalSettings.m_centerFrequency = report->getCenterFrequency();
+			displaySettings();
+		}
+		message->completed();
+		return true;
+	} else {
+		return false;
+	}
+}
+
+void FileSourceGui::displaySettings()
+{
+	ui->centerFrequency->setValue(m_generalSettings.m_centerFrequency / 1000);
+	ui->fileName->setText(m_settings.m_fileName);
+	ui->format->setCurrentIndex(m_settings.m_format);
+	ui->sampleRate->setValue(m_settings.m_sampleRate);
+	ui->realTime->setChecked(m_settings.m_realTime);
+	ui->loop->setChecked(m_settings.m_loop);
+}
+
+void FileSourceGui::sendSettings()
+{
+	if(!m_updateTimer.isActive())
+		m_updateTimer.start(100);
+}
+
+void FileSourceGui::on_centerFrequency_changed(quint64 value)
+{
+	m_generalSettings.m_centerFrequency = value * 1000;
+	sendSettings();
+}
+
+void FileSourceGui::on_browse_clicked()
+{
+	QString fileName = QFileDialog::getOpenFileName(this, tr("Open IQ file"), m_settings.m_fileName,
+		tr("IQ files (*.wav *.sigmf-meta *.sigmf-data *.raw *.iq *.bin *.cu8 *.u8 *.cs8 *.s8 *.cs16);;All files (*)"));
+	if(fileName.isEmpty())
+		return;
+	m_settings.m_fileName = fileName;
+	ui->fileName->setText(fileName);
+	ui->info->setText(tr("---"));
+	sendSettings();
+}
+
+void FileSourceGui::on_format_currentIndexChanged(int index)
+{
+	m_settings.m_format = index;
+	sendSettings();
+}
+
+void FileSourceGui::on_sampleRate_valueChanged(int value)
+{
+	m_settings.m_sampleRate = value;
+	sendSettings();
+}
+
+void FileSourceGui::on_realTime_toggled(bool checked)
+{
+	m_settings.m_realTime = checked;
+	sendSettings();
+}
+
+void FileSourceGui::on_loop_toggled(bool checked)
+{
+	m_settings.m_loop = checked;
+	sendSettings();
+}
+
+void FileSourceGui::updateHardware()
+{
+	FileSourceInput::MsgConfigureFileSource* message = FileSourceInput::MsgConfigureFileSource::create(m_generalSettings, m_settings);
+	message->submit(m_pluginAPI->getDSPEngineMessageQueue());
+	m_updateTimer.stop();
+}
@@ -0,0 +1,55 @@
+#ifndef INCLUDE_FILESOURCEGUI_H
+#define INCLUDE_FILESOURCEGUI_H
+
+#include <QTimer>
+#include "plugin/plugingui.h"
+#include "filesourceinput.h"
+
+class PluginAPI;
+
+namespace Ui {
+	class FileSourceGui;
+}
+
+class FileSourceGui : public QWidget, public PluginGUI {
+	Q_OBJECT
+
+public:
+	explicit FileSourceGui(PluginAPI* pluginAPI, QWidget* parent = NULL);
+	~FileSourceGui();
+	void destroy();
+
+	void setName(const QString& name);
+
+	void resetToDefaults();
+	QByteArray serializeGeneral() const;
+	bool deserializeGeneral(const QByteArray&data);
+	quint64 getCenterFrequency() const;
+	QByteArray serialize() const;
+	bool deserialize(const QByteArray& data);
+	bool handleMessage(Message* message);
+
+private:
+	Ui::FileSourceGui* ui;
+
+	PluginAPI* m_pluginAPI;
+	SampleSource::GeneralSettings m_generalSettings;
+	FileSourceInput::Settings m_settings;
+	QTimer m_updateTimer;
+	SampleSource* m_sampleSource;
+
+	void displaySettings();
+	void sendSettings();
+
+private slots:
+	void on_centerFrequency_changed(quint64 value);
+	void on_browse_clicked();
+	void on_format_currentIndexChanged(int index);
+	void on_sampleRate_valueChanged(int value);
+	void on_realTime_toggled(bool checked);
+	void on_loop_toggled(bool checked);
+
+	void updateHardware();
+};
+
+#endif // INCLUDE_FILESOURCEGUI_H
@@ -0,0 +1,377 @@
+#include <string.h>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtEndian>
+#include "filesourceinput.h"
+#include "filesourcethread.h"
+#include "util/simpleserializer.h"
+
+MESSAGE_CLASS_DEFINITION(FileSourceInput::MsgConfigureFileSource, Message)
+MESSAGE_CLASS_DEFINITION(FileSourceInput::MsgReportFileSource, Message)
+
+// finds the PCM format and the sample data inside a RIFF/WAVE file - an SDR# "auxi" chunk also
+// yields the center frequency
+static bool parseWAV(const quint8* data, qint64 size, qint64* dataOffset, qint64* dataSize, int* format, int* sampleRate, quint64* centerFrequency)
+{
+	if((size < 12) || (memcmp(data, "RIFF", 4) != 0) || (memcmp(data + 8, "WAVE", 4) != 0)) {
+		qCritical("FileSourceInput: not a WAV file");
+		return false;
+	}
+
+	bool haveFormat = false;
+	int channels = 0;
+	int bits = 0;
+	*dataOffset = -1;
+
+	qint64 pos = 12;
+	while(pos + 8 <= size) {
+		const quint8* chunk = data + pos;
+		qint64 chunkSize = qFromLittleEndian<quint32>(chunk + 4);
+		qint64 body = pos + 8;
+
+		if((memcmp(chunk, "fmt ", 4) == 0) && (chunkSize >= 16) && (body + 16 <= size)) {
+			int tag = qFromLittleEndian<quint16>(chunk + 8);
+			// plain PCM or WAVE_FORMAT_EXTENSIBLE
+			if((tag != 1) && (tag != 0xfffe)) {
+				qCritical("FileSourceInput: WAV format tag %d is not PCM", tag);
+				return false;
+			}
+			channels = qFromLittleEndian<quint16>(chunk + 10);
+			*sampleRate = qFromLittleEndian<quint32>(chunk + 12);
+			bits = qFromLittleEndian<quint16>(chunk + 22);
+			haveFormat = true;
+		} else if((memcmp(chunk, "auxi", 4) == 0) && (chunkSize >= 36) && (body + 36 <= size)) {
+			// two SYSTEMTIME structs, then the center frequency in Hz
+			*centerFrequency = qFromLittleEndian<quint32>(chunk + 8 + 32);
+		} else if(memcmp(chunk, "data", 4) == 0) {
+			*dataOffset = body;
+			*dataSize = qMin(chunkSize, size - body);
+		}
+
+		pos = body + chunkSize + (chunkSize & 1);
+	}
+
+	if(!haveFormat || (*dataOffset < 0)) {
+		qCritical("FileSourceInput: WAV file without format or data chunk");
+		return false;
+	}
+	if(channels != 2) {
+		qCritical("FileSourceInput: WAV file has %d channels, need 2 for IQ", channels);
+		return false;
+	}
+	if(bits == 16) {
+		*format = FileSourceInput::FormatS16LE;
+	} else if(bits == 8) {
+		*format = FileSourceInput::FormatU8;
+	} else {
+		qCritical("FileSourceInput: %d bit WAV files are not supported", bits);
+		return false;
+	}
+	return true;
+}
+
+static bool parseSigMF(const QString& metaFileName, int* format, int* sampleRate, quint64* centerFrequency)
+{
+	QFile file(metaFileName);
+	if(!file.open(QIODevice::ReadOnly)) {
+		qCritical("FileSourceInput: could not open %s", qPrintable(metaFileName));
+		return false;
+	}
+
+	QJsonParseError error;
+	QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+	if(!doc.isObject()) {
+		qCritical("FileSourceInput: %s: %s", qPrintable(metaFileName), qPrintable(error.errorString()));
+		return false;
+	}
+
+	QJsonObject global = doc.object()["global"].toObject();
+	QString datatype = global["core:datatype"].toString();
+	if(datatype == "ci16_le") {
+		*format = FileSourceInput::FormatS16LE;
+	} else if(datatype == "cu8") {
+		*format = FileSourceInput::FormatU8;
+	} else if(datatype == "ci8") {
+		*format = FileSourceInput::FormatS8;
+	} else {
+		qCritical("FileSourceInput: SigMF datatype \"%s\" is not supported", qPrintable(datatype));
+		return false;
+	}
+	*sampleRate = (int)global["core:sample_rate"].toDouble();
+
+	QJsonArray captures = doc.object()["captures"].toArray();
+	if(!captures.isEmpty())
+		*centerFrequency = (quint64)captures[0].toObject()["core:frequency"].toDouble();
+	return true;
+}
+
+FileSourceInput::Settings::Settings() :
+	m_fileName(),
+	m_format(FormatAuto),
+	m_sampleRate(2000000),
+	m_realTime(true),
+	m_loop(true)
+{
+}
+
+void FileSourceInput::Settings::resetToDefaults()
+{
+	m_fileName.clear();
+	m_format = FormatAuto;
+	m_sampleRate = 2000000;
+	m_realTime = true;
+	m_loop = true;
+}
+
+QByteArray FileSourceInput::Settings::serialize() const
+{
+	SimpleSerializer s(1);
+	s.writeString(1, m_fileName);
+	s.writeS32(2, m_format);
+	s.writeS32(3, m_sampleRate);
+	s.writeBool(4, m_realTime);
+	s.writeBool(5, m_loop);
+	return s.final();
+}
+
+bool FileSourceInput::Settings::deserialize(const QByteArray& data)
+{
+	SimpleDeserializer d(data);
+
+	if(!d.isValid()) {
+		resetToDefaults();
+		return false;
+	}
+
+	if(d.getVersion() == 1) {
+		d.readString(1, &m_fileName);
+		d.readS32(2, &m_format, FormatAuto);
+		d.readS32(3, &m_sampleRate, 2000000);
+		d.readBool(4, &m_realTime, true);
+		d.readBool(5, &m_loop, true);
+		return true;
+	} else {
+		resetToDefaults();
+		return false;
+	}
+}
+
+FileSourceInput::FileSourceInput(MessageQueue* msgQueueToGUI) :
+	SampleSource(msgQueueToGUI),
+	m_settings(),
+	m_fileSourceThread(NULL),
+	m_deviceDescription(),
+	m_file(),
+	m_data(NULL),
+	m_sampleCount(0),
+	m_fileFormat(FormatS16LE),
+	m_fileSampleRate(0),
+	m_fileCenterFrequency(0)
+{
+}
+
+FileSourceInput::~FileSourceInput()
+{
+	stopInput();
+}
+
+bool FileSourceInput::startInput(int device)
+{
+	Q_UNUSED(device);
+	QMutexLocker mutexLocker(&m_mutex);
+
+	stopThread();
+	closeFile();
+
+	if(!m_sampleFifo.setSize(524288)) {
+		qCritical("Could not allocate SampleFifo");
+		return false;
+	}
+
+	if(!openFile())
+		return false;
+	if(!startThread()) {
+		closeFile();
+		return false;
+	}
+
+	qDebug("FileSourceInput: start");
+	return true;
+}
+
+void FileSourceInput::stopInput()
+{
+	QMutexLocker mutexLocker(&m_mutex);
+
+	stopThread();
+	closeFile();
+	m_deviceDescription.clear();
+}
+
+const QString& FileSourceInput::getDeviceDescription() const
+{
+	return m_deviceDescription;
+}
+
+int FileSourceInput::getSampleRate() const
+{
+	if(m_data != NULL)
+		return m_fileSampleRate;
+	else return m_settings.m_sampleRate;
+}
+
+quint64 FileSourceInput::getCenterFrequency() const
+{
+	if((m_data != NULL) && (m_fileCenterFrequency != 0))
+		return m_fileCenterFrequency;
+	else return m_generalSettings.m_centerFrequency;
+}
+
+bool FileSourceInput::handleMessage(Message* message)
+{
+	if(MsgConfigureFileSource::match(message)) {
+		MsgConfigureFileSource* conf = (MsgConfigureFileSource*)message;
+		if(!applySettings(conf->getGeneralSettings(), conf->getSettings(), false))
+			qDebug("FileSource config error");
+		message->completed();
+		return true;
+	} else {
+		return false;
+	}
+}
+
+bool FileSourceInput::openFile()
+{
+	if(m_settings.m_fileName.isEmpty()) {
+		qCritical("FileSourceInput: no file selected");
+		return false;
+	}
+
+	QFileInfo info(m_settings.m_fileName);
+	QString suffix = info.suffix().toLower();
+	QString dataFileName = m_settings.m_fileName;
+	int format = m_settings.m_format;
+	int sampleRate = m_settings.m_sampleRate;
+	quint64 centerFrequency = 0;
+
+	// a SigMF recording is a pair of files, either of them may have been picked
+	if((suffix == "sigmf-meta") || (suffix == "sigmf-data")) {
+		QString baseName = info.path() + "/" + info.completeBaseName();
+		if(!parseSigMF(baseName + ".sigmf-meta", &format, &sampleRate, &centerFrequency))
+			return false;
+		dataFileName = baseName + ".sigmf-data";
+	}
+
+	m_file.setFileName(dataFileName);
+	if(!m_file.open(QIODevice::ReadOnly)) {
+		qCritical("FileSourceInput: could not open %s: %s", qPrintable(dataFileName), qPrintable(m_file.errorString()));
+		return false;
+	}
+
+	// the whole file is mapped - the OS pages it in on demand and nothing is copied twice
+	qint64 size = m_file.size();
+	const quint8* data = (size > 0) ? m_file.map(0, size) : NULL;
+	if(data == NULL) {
+		qCritical("FileSourceInput: could not map %s: %s", qPrintable(dataFileName), qPrintable(m_file.errorString()));
+		m_file.close();
+		return false;
+	}
+
+	if(suffix == "wav") {
+		qint64 dataOffset;
+		if(!parseWAV(data, size, &dataOffset, &size, &format, &sampleRate, &centerFrequency)) {
+			closeFile();
+			return false;
+		}
+		data += dataOffset;
+	} else if(format == FormatAuto) {
+		if((suffix == "cu8") || (suffix == "u8"))
+			format = FormatU8;
+		else if((suffix == "cs8") || (suffix == "s8"))
+			format = FormatS8;
+		else format = FormatS16LE;
+	}
+
+	m_data = data;
+	m_sampleCount = size / (format == FormatS16LE ? 4 : 2);
+	m_fileFormat = format;
+	m_fileSampleRate = sampleRate;
+	m_fileCenterFrequency = centerFrequency;
+
+	if((m_sampleCount <= 0) || (m_fileSampleRate <= 0)) {
+		qCritical("FileSourceInput: %s has no samples or no sample rate", qPrintable(dataFileName));
+		closeFile();
+		return false;
+	}
+
+	m_deviceDescription = info.fileName();
+	qDebug("FileSourceInput: %s: %lld samples at %d S/s", qPrintable(dataFileName), m_sampleCount, m_fileSampleRate);
+	MsgReportFileSource::create(m_fileSampleRate, m_fileCenterFrequency, m_sampleCount, m_fileFormat)->submit(m_guiMessageQueue);
+	return true;
+}
+
+void FileSourceInput::closeFile()
+{
+	// closing also drops the mapping
+	m_file.close();
+	m_data = NULL;
+	m_sampleCount = 0;
+}
+
+bool FileSourceInput::startThread()
+{
+	if((m_fileSourceThread = new FileSourceThread(m_data, m_sampleCount, m_fileFormat, m_fileSampleRate, &m_sampleFifo)) == NULL) {
+		qFatal("out of memory");
+		return false;
+	}
+	m_fileSourceThread->setRealTime(m_settings.m_realTime);
+	m_fileSourceThread->setLoop(m_settings.m_loop);
+	m_fileSourceThread->startWork();
+	return true;
+}
+
+void FileSourceInput::stopThread()
+{
+	if(m_fileSourceThread != NULL) {
+		m_fileSourceThread->stopWork();
+		delete m_fileSourceThread;
+		m_fileSourceThread = NULL;
+	}
+}
+
+bool FileSourceInput::applySettings(const GeneralSettings& generalSettings, const Settings& settings, bool force)
+{
+	QMutexLocker mutexLocker(&m_mutex);
+
+	m_generalSettings.m_centerFrequency = generalSettings.m_centerFrequency;
+
+	if((m_settings.m_fileName != settings.m_fileName) || (m_settings.m_format != settings.m_format) ||
+		(m_settings.m_sampleRate != settings.m_sampleRate) || force) {
+		m_settings.m_fileName = settings.m_fileName;
+		m_settings.m_format = settings.m_format;
+		m_settings.m_sampleRate = settings.m_sampleRate;
+		m_settings.m_realTime = settings.m_realTime;
+		m_settings.m_loop = settings.m_loop;
+		// only reopen while running - the DSP engine picks up the new rate after this message
+		if(m_fileSourceThread != NULL) {
+			stopThread();
+			closeFile();
+			if(!openFile())
+				return false;
+			return startThread();
+		}
+	}
+	if((m_settings.m_realTime != settings.m_realTime) || force) {
+		m_settings.m_realTime = settings.m_realTime;
+		if(m_fileSourceThread != NULL)
+			m_fileSourceThread->setRealTime(m_settings.m_realTime);
+	}
+	if((m_settings.m_loop != settings.m_loop) || force) {
+		m_settings.m_loop = settings.m_loop;
+		if(m_fileSourceThread != NULL)
+			m_fileSourceThread->setLoop(m_settings.m_loop);
+	}
+	return true;
+}
@@ -0,0 +1,117 @@
+#ifndef INCLUDE_FILESOURCEINPUT_H
+#define INCLUDE_FILESOURCEINPUT_H
+
+#include <QFile>
+#include <QString>
+#include "dsp/samplesource/samplesource.h"
+
+class FileSourceThread;
+
+// replays recorded IQ from a memory mapped file - raw int16/uint8/int8 pairs, stereo WAV or SigMF
+class FileSourceInput : public SampleSource {
+public:
+	enum Format {
+		FormatAuto,
+		FormatS16LE,
+		FormatU8,
+		FormatS8
+	};
+
+	struct Settings {
+		QString m_fileName;
+		qint32 m_format;
+		qint32 m_sampleRate; // only used for raw files, WAV and SigMF carry their own
+		bool m_realTime;
+		bool m_loop;
+
+		Settings();
+		void resetToDefaults();
+		QByteArray serialize() const;
+		bool deserialize(const QByteArray& data);
+	};
+
+	class MsgConfigureFileSource : public Message {
+		MESSAGE_CLASS_DECLARATION(MsgConfigureFileSource)
+
+	public:
+		const GeneralSettings& getGeneralSettings() const { return m_generalSettings; }
+		const Settings& getSettings() const { return m_settings; }
+
+		static MsgConfigureFileSource* create(const GeneralSettings& generalSettings, const Settings& settings)
+		{
+			return new MsgConfigureFileSource(generalSettings, settings);
+		}
+
+	private:
+		GeneralSettings m_generalSettings;
+		Settings m_settings;
+
+		MsgConfigureFileSource(const GeneralSettings& generalSettings, const Settings& settings) :
+			Message(),
+			m_generalSettings(generalSettings),
+			m_settings(settings)
+		{ }
+	};
+
+	class MsgReportFileSource : public Message {
+		MESSAGE_CLASS_DECLARATION(MsgReportFileSource)
+
+	public:
+		int getSampleRate() const { return m_sampleRate; }
+		quint64 getCenterFrequency() const { return m_centerFrequency; }
+		qint64 getSampleCount() const { return m_sampleCount; }
+		int getFormat() const { return m_format; }
+
+		static MsgReportFileSource* create(int sampleRate, quint64 centerFrequency, qint64 sampleCount, int format)
+		{
+			return new MsgReportFileSource(sampleRate, centerFrequency, sampleCount, format);
+		}
+
+	protected:
+		int m_sampleRate;
+		quint64 m_centerFrequency; // 0 if the file does not say
+		qint64 m_sampleCount;
+		int m_format;
+
+		MsgReportFileSource(int sampleRate, quint64 centerFrequency, qint64 sampleCount, int format) :
+			Message(),
+			m_sampleRate(sampleRate),
+			m_centerFrequency(centerFrequency),
+			m_sampleCount(sampleCount),
+			m_format(format)
+		{ }
+	};
+
+	FileSourceInput(MessageQueue* msgQueueToGUI);
+	~FileSourceInput();
+
+	bool startInput(int device);
+	void stopInput();
+
+	const QString& getDeviceDescription() const;
+	int getSampleRate() const;
+	quint64 getCenterFrequency() const;
+
+	bool handleMessage(Message* message);
+
+private:
+	QMutex m_mutex;
+	Settings m_settings;
+	FileSourceThread* m_fileSourceThread;
+	QString m_deviceDescription;
+
+	QFile m_file;
+	const quint8* m_data;
+	qint64 m_sampleCount;
+	int m_fileFormat;
+	int m_fileSampleRate;
+	quint64 m_fileCenterFrequency;
+
+	bool openFile();
+	void closeFile();
+	bool startThread();
+	void stopThread();
+	bool applySettings(const GeneralSettings& generalSettings, const Settings& settings, bool force);
+};
+
+#endif // INCLUDE_FILESOURCEINPUT_H
@@ -0,0 +1,50 @@
+#include <QtPlugin>
+#include "plugin/pluginapi.h"
+#include "filesourceplugin.h"
+#include "filesourcegui.h"
+
+const PluginDescriptor FileSourcePlugin::m_pluginDescriptor = {
+	QString("IQ File Input"),
+	QString("---"),
+	QString("(c) maintech GmbH (written by Christian Daniel)"),
+	QString("http://www.maintech.de"),
+	true,
+	QString("http://www.maintech.de")
+};
+
+FileSourcePlugin::FileSourcePlugin(QObject* parent) :
+	QObject(parent)
+{
+}
+
+const PluginDescriptor& FileSourcePlugin::getPluginDescriptor() const
+{
+	return m_pluginDescriptor;
+}
+
+void FileSourcePlugin::initPlugin(PluginAPI* pluginAPI)
+{
+	m_pluginAPI = pluginAPI;
+
+	m_pluginAPI->registerSampleSource("de.maintech.sdrangelove.samplesource.file", this);
+}
+
+PluginInterface::SampleSourceDevices FileSourcePlugin::enumSampleSources()
+{
+	SampleSourceDevices result;
+	result.append(SampleSourceDevice("IQ File", "de.maintech.sdrangelove.samplesource.file", QByteArray()));
+	return result;
+}
+
+PluginGUI* FileSourcePlugin::createSampleSource(const QString& sourceName, const QByteArray& address)
+{
+	Q_UNUSED(address);
+
+	if(sourceName == "de.maintech.sdrangelove.samplesource.file") {
+		FileSourceGui* gui = new FileSourceGui(m_pluginAPI);
+		m_pluginAPI->setInputGUI(gui);
+		return gui;
+	} else {
+		return NULL;
+	}
+}
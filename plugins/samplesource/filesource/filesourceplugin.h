@@ -0,0 +1,27 @@
+#ifndef INCLUDE_FILESOURCEPLUGIN_H
+#define INCLUDE_FILESOURCEPLUGIN_H
+
+#include <QObject>
+#include "plugin/plugininterface.h"
+
+class FileSourcePlugin : public QObject, PluginInterface {
+	Q_OBJECT
+	Q_INTERFACES(PluginInterface)
+	Q_PLUGIN_METADATA(IID "de.maintech.sdrangelove.samplesource.file")
+
+public:
+	explicit FileSourcePlugin(QObject* parent = NULL);
+
+	const PluginDescriptor& getPluginDescriptor() const;
+	void initPlugin(PluginAPI* pluginAPI);
+
+	SampleSourceDevices enumSampleSources();
+	PluginGUI* createSampleSource(const QString& sourceName, const QByteArray& address);
+
+private:
+	static const PluginDescriptor m_pluginDescriptor;
+
+	PluginAPI* m_pluginAPI;
+};
+
+#endif // INCLUDE_FILESOURCEPLUGIN_H
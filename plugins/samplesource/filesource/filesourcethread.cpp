@@ -0,0 +1,147 @@
+#include <string.h>
+#include <QElapsedTimer>
+#include <QtEndian>
+#include "filesourcethread.h"
+#include "filesourceinput.h"
+#include "dsp/sampleconverter.h"
+
+#define BLOCKSIZE 16384
+
+FileSourceThread::FileSourceThread(const quint8* data, qint64 sampleCount, int format, int sampleRate, SampleFifo* sampleFifo, QObject* parent) :
+	QThread(parent),
+	m_running(false),
+	m_data(data),
+	m_sampleCount(sampleCount),
+	m_format(format),
+	m_sampleRate(sampleRate),
+	m_position(0),
+	m_realTime(true),
+	m_loop(true),
+	m_sampleFifo(sampleFifo)
+{
+}
+
+FileSourceThread::~FileSourceThread()
+{
+	stopWork();
+}
+
+void FileSourceThread::startWork()
+{
+	m_startWaitMutex.lock();
+	start();
+	while(!m_running)
+		m_startWaiter.wait(&m_startWaitMutex, 100);
+	m_startWaitMutex.unlock();
+}
+
+void FileSourceThread::stopWork()
+{
+	m_running = false;
+	wait();
+}
+
+void FileSourceThread::setRealTime(bool realTime)
+{
+	m_realTime = realTime;
+}
+
+void FileSourceThread::setLoop(bool loop)
+{
+	m_loop = loop;
+}
+
+void FileSourceThread::run()
+{
+	QElapsedTimer timer;
+	qint64 sent = 0;
+	bool realTime = !m_realTime;
+	// at most 10ms worth of samples
+	qint64 minChunk = qMax(1, qMin(BLOCKSIZE / 4, m_sampleRate / 100));
+
+	m_running = true;
+	m_startWaiter.wakeAll();
+
+	while(m_running) {
+		qint64 count;
+
+		if(realTime != m_realTime) {
+			realTime = m_realTime;
+			timer.start();
+			sent = 0;
+		}
+
+		if(realTime) {
+			// whatever is due by now according to the wall clock
+			count = (qint64)(timer.nsecsElapsed() * 1e-9 * m_sampleRate) - sent;
+			// the consumer stalled for more than a second - drop the backlog instead of flooding the FIFO
+			if(count > m_sampleRate) {
+				sent += count - BLOCKSIZE;
+				count = BLOCKSIZE;
+			}
+		} else {
+			// as fast as possible
+			count = BLOCKSIZE;
+		}
+
+		// convert straight into the FIFO, never more than it can take
+		SampleVector::iterator begin;
+		SampleVector::iterator end;
+		count = qMin(count, qMin((qint64)BLOCKSIZE, m_sampleCount - m_position));
+		// wait for a reasonable chunk instead of spinning on the few samples due in the meantime
+		if(realTime && (count < minChunk) && (count < m_sampleCount - m_position)) {
+			msleep(qMax((qint64)1, ((minChunk - count) * 1000) / qMax(1, m_sampleRate)));
+			continue;
+		}
+		if(count > 0)
+			count = m_sampleFifo->writeBegin(count, &begin, &end);
+		if(count <= 0) {
+			msleep(1);
+			continue;
+		}
+
+		convert(m_position, count, &(*begin));
+		m_sampleFifo->writeCommit(count);
+		m_position += count;
+		sent += count;
+
+		if(m_position >= m_sampleCount) {
+			if(m_loop) {
+				m_position = 0;
+			} else {
+				qDebug("FileSourceThread: end of file");
+				break;
+			}
+		}
+	}
+
+	m_running = false;
+}
+
+void FileSourceThread::convert(qint64 position, int count, Sample* dst)
+{
+	switch(m_format) {
+		case FileSourceInput::FormatU8:
+			SampleConverter::convertU8(m_data + position * 2, count, dst);
+			break;
+
+		case FileSourceInput::FormatS8: {
+			const qint8* src = (const qint8*)m_data + position * 2;
+			for(int i = 0; i < count; i++)
+				dst[i] = Sample(src[2 * i] << 8, src[2 * i + 1] << 8);
+			break;
+		}
+
+		default: {
+			const quint8* src = m_data + position * 4;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+			// same layout as Sample - the mapping may be unaligned, so copy bytes
+			memcpy((void*)dst, src, count * sizeof(Sample));
+#else
+			for(int i = 0; i < count; i++)
+				dst[i] = Sample(qFromLittleEndian<qint16>(src + 4 * i), qFromLittleEndian<qint16>(src + 4 * i + 2));
+#endif
+			break;
+		}
+	}
+}
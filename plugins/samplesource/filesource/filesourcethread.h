@@ -0,0 +1,42 @@
+#ifndef INCLUDE_FILESOURCETHREAD_H
+#define INCLUDE_FILESOURCETHREAD_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include "dsp/samplefifo.h"
+
+class FileSourceThread : public QThread {
+	Q_OBJECT
+
+public:
+	FileSourceThread(const quint8* data, qint64 sampleCount, int format, int sampleRate, SampleFifo* sampleFifo, QObject* parent = NULL);
+	~FileSourceThread();
+
+	void startWork();
+	void stopWork();
+
+	void setRealTime(bool realTime);
+	void setLoop(bool loop);
+
+private:
+	QMutex m_startWaitMutex;
+	QWaitCondition m_startWaiter;
+	bool m_running;
+
+	const quint8* m_data;
+	qint64 m_sampleCount;
+	int m_format;
+	int m_sampleRate;
+	qint64 m_position;
+
+	bool m_realTime;
+	bool m_loop;
+
+	SampleFifo* m_sampleFifo;
+
+	void run();
+	void convert(qint64 position, int count, Sample* dst);
+};
+
+#endif // INCLUDE_FILESOURCETHREAD_H
@@ -20,6 +20,7 @@
 #include <errno.h>
 #include "gnuradiothread.h"
 #include "dsp/samplefifo.h"
+#include "dsp/sampleconverter.h"
 
 #include <gnuradio/sync_block.h>
 #include <gnuradio/io_signature.h>
@@ -29,12 +30,12 @@ class gr_adaptor;
 
 typedef boost::shared_ptr< gr_adaptor > gr_adaptor_sptr;
 
-gr_adaptor_sptr make_gr_adaptor (SampleFifo* sampleFifo);
+gr_adaptor_sptr make_gr_adaptor (SampleFifo* sampleFifo, QAtomicInt* overruns);
 
 class gr_adaptor : public gr::sync_block
 {
 public:
-	gr_adaptor (SampleFifo* sampleFifo);
+	gr_adaptor (SampleFifo* sampleFifo, QAtomicInt* overruns);
 	~gr_adaptor ();
 
 	int work (int noutput_items,
@@ -43,19 +44,23 @@ public:
 
 private:
 	SampleFifo *m_sampleFifo;
+	QAtomicInt *m_overruns;
+	// only used when the fifo is about to overflow
+	SampleVector m_buffer;
 };
 
 gr_adaptor_sptr
-make_gr_adaptor (SampleFifo *sampleFifo)
+make_gr_adaptor (SampleFifo *sampleFifo, QAtomicInt *overruns)
 {
-	return gr_adaptor_sptr (new gr_adaptor (sampleFifo));
+	return gr_adaptor_sptr (new gr_adaptor (sampleFifo, overruns));
 }
 
-gr_adaptor::gr_adaptor (SampleFifo *sampleFifo)
+gr_adaptor::gr_adaptor (SampleFifo *sampleFifo, QAtomicInt *overruns)
 	: gr::sync_block("gr_adaptor",
 			 gr::io_signature::make(1, 1, sizeof (gr_complex)),
 			 gr::io_signature::make(0, 0, 0)),
-	  m_sampleFifo(sampleFifo)
+	  m_sampleFifo(sampleFifo),
+	  m_overruns(overruns)
 {
 }
 
@@ -68,20 +73,25 @@ gr_adaptor::work (int noutput_items,
 		  gr_vector_const_void_star &input_items,
 		  gr_vector_void_star &output_items)
 {
-	const gr_complex *in = (const gr_complex *) input_items[0];
+	const float *in = (const float *) input_items[0];
+	SampleVector::iterator begin;
+	SampleVector::iterator end;
 
-	std::vector<qint16> buffer(noutput_items * 2, 0);
-	std::vector<qint16>::iterator it = buffer.begin();
-
-	for (int i = 0; i < noutput_items; i++)
+	// convert straight into the fifo
+	if (m_sampleFifo->writeBegin(noutput_items, &begin, &end) == (uint)noutput_items)
 	{
-		*it++ = in[i].real() * 32000;
-		*it++ = in[i].imag() * 32000;
+		SampleConverter::convertFloat(in, noutput_items, 32000.0f, &(*begin));
+		m_sampleFifo->writeCommit(noutput_items);
+	}
+	else
+	{
+		// overrun - write() drops and reports whatever does not fit
+		if ((int)m_buffer.size() < noutput_items)
+			m_buffer.resize(noutput_items);
+		SampleConverter::convertFloat(in, noutput_items, 32000.0f, &m_buffer[0]);
+		m_sampleFifo->write(m_buffer.begin(), m_buffer.begin() + noutput_items);
+		m_overruns->ref();
 	}
-
-	// we must push at least 4 bytes into the fifo
-	m_sampleFifo->write((const quint8*)buffer.data(),
-			    (it - buffer.begin()) * sizeof(qint16));
 
 	// Tell runtime system how many input items we consumed on
 	// each input stream.
@@ -96,7 +106,8 @@ GnuradioThread::GnuradioThread(QString args, SampleFifo* sampleFifo, QObject* pa
 	QThread(parent),
 	m_running(false),
 	m_args(args),
-	m_sampleFifo(sampleFifo)
+	m_sampleFifo(sampleFifo),
+	m_overruns(0)
 {
 }
 
@@ -123,6 +134,9 @@ void GnuradioThread::stopWork()
 	m_top->stop();
 
 	wait();
+
+	if (m_overruns.load() > 0)
+		qDebug("GnuradioThread: %d overruns", m_overruns.load());
 }
 
 void GnuradioThread::run()
@@ -135,7 +149,7 @@ void GnuradioThread::run()
 	m_running = true;
 	m_startWaiter.wakeAll();
 
-	gr_adaptor_sptr adaptor = make_gr_adaptor(m_sampleFifo);
+	gr_adaptor_sptr adaptor = make_gr_adaptor(m_sampleFifo, &m_overruns);
 	m_top->connect(m_src, 0, adaptor, 0);
 
 	m_top->run();
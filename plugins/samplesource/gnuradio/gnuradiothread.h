@@ -22,6 +22,7 @@
 #include <QThread>
 #include <QMutex>
 #include <QWaitCondition>
+#include <QAtomicInt>
 
 #include <gnuradio/top_block.h>
 #include <osmosdr/source.h>
@@ -39,6 +40,8 @@ public:
 	void stopWork();
 
 	osmosdr::source::sptr radio() { return m_src; }
+	// number of times the sample fifo was too full to take a whole block
+	int getOverruns() const { return m_overruns.load(); }
 
 private:
 #pragma pack(push, 1)
@@ -54,6 +57,7 @@ private:
 
 	QString m_args;
 	SampleFifo* m_sampleFifo;
+	QAtomicInt m_overruns;
 
 	gr::top_block_sptr m_top;
 	osmosdr::source::sptr m_src;
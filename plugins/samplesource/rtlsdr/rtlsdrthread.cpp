@@ -19,6 +19,7 @@
 #include <errno.h>
 #include "rtlsdrthread.h"
 #include "dsp/samplefifo.h"
+#include "dsp/sampleconverter.h"
 
 #define BLOCKSIZE 16384
 
@@ -74,92 +75,39 @@ void RTLSDRThread::run()
 	m_running = false;
 }
 
-void RTLSDRThread::decimate2(SampleVector::iterator* it, const quint8* buf, qint32 len)
-{
-	for(int pos = 0; pos < len; pos += 2) {
-		Sample s((((qint8)buf[pos]) - 128) << 8, (((qint8)buf[pos + 1]) - 128) << 8);
-		if(m_decimator2.workDecimateCenter(&s)) {
-			**it = s;
-			++(*it);
-		}
-	}
-}
-
-void RTLSDRThread::decimate4(SampleVector::iterator* it, const quint8* buf, qint32 len)
-{
-	for(int pos = 0; pos < len; pos += 2) {
-		Sample s((((qint8)buf[pos]) - 128) << 8, (((qint8)buf[pos + 1]) - 128) << 8);
-		if(m_decimator2.workDecimateCenter(&s)) {
-			if(m_decimator4.workDecimateCenter(&s)) {
-				**it = s;
-				++(*it);
-			}
-		}
-	}
-}
-
-void RTLSDRThread::decimate8(SampleVector::iterator* it, const quint8* buf, qint32 len)
-{
-	for(int pos = 0; pos < len; pos += 2) {
-		Sample s((((qint8)buf[pos]) - 128) << 8, (((qint8)buf[pos + 1]) - 128) << 8);
-		if(m_decimator2.workDecimateCenter(&s)) {
-			if(m_decimator4.workDecimateCenter(&s)) {
-				if(m_decimator8.workDecimateCenter(&s)) {
-					**it = s;
-					++(*it);
-				}
-			}
-		}
-	}
-}
-
-void RTLSDRThread::decimate16(SampleVector::iterator* it, const quint8* buf, qint32 len)
-{
-	for(int pos = 0; pos < len; pos += 2) {
-		Sample s((((qint8)buf[pos]) - 128) << 8, (((qint8)buf[pos + 1]) - 128) << 8);
-		if(m_decimator2.workDecimateCenter(&s)) {
-			if(m_decimator4.workDecimateCenter(&s)) {
-				if(m_decimator8.workDecimateCenter(&s)) {
-					if(m_decimator16.workDecimateCenter(&s)) {
-						**it = s;
-						++(*it);
-					}
-				}
-			}
-		}
-	}
-}
-
 void RTLSDRThread::callback(const quint8* buf, qint32 len)
 {
-	SampleVector::iterator it = m_convertBuffer.begin();
-
-	switch(m_decimation) {
-		case 0: // 1:1 = no decimation
-			for(int pos = 0; pos < len; pos += 2) {
-				*it = Sample((((qint8)buf[pos]) - 128) << 8, (((qint8)buf[pos + 1]) - 128) << 8);
-				++it;
-			}
-			break;
-
-		case 1: // 1:2
-			decimate2(&it, buf, len);
-			break;
-
-		case 2: // 1:4
-			decimate4(&it, buf, len);
-			break;
-
-		case 3: // 1:8
-			decimate8(&it, buf, len);
-			break;
-
-		case 4: // 1:16
-			decimate16(&it, buf, len);
-			break;
+	int count = qMin(len / 2, (qint32)m_convertBuffer.size());
+	// the first stage writes all of its output before the others shrink it in place, so the span
+	// has to hold that - a half-band stage may emit one sample more than half its input
+	uint needed = (m_decimation == 0) ? count : count / 2 + 1;
+	SampleVector::iterator begin;
+	SampleVector::iterator end;
+	Sample* out;
+
+	// produce straight into the FIFO - the staging buffer is only used when it is about to overflow
+	bool direct = m_sampleFifo->writeBegin(needed, &begin, &end) == needed;
+	if(direct)
+		out = &(*begin);
+	else out = &m_convertBuffer[0];
+
+	// the first stage converts while it splits its input, the others decimate in place
+	if(m_decimation == 0) {
+		SampleConverter::convertU8(buf, count, out);
+	} else {
+		count = m_decimator2.decimateCenterU8(buf, count, out);
+		if(m_decimation >= 2)
+			count = m_decimator4.decimateCenter(out, count, out);
+		if(m_decimation >= 3)
+			count = m_decimator8.decimateCenter(out, count, out);
+		if(m_decimation >= 4)
+			count = m_decimator16.decimateCenter(out, count, out);
 	}
 
-	m_sampleFifo->write(m_convertBuffer.begin(), it);
+	// only the final count is handed to the consumer
+	if(direct)
+		m_sampleFifo->writeCommit(count);
+	else m_sampleFifo->write(m_convertBuffer.begin(), m_convertBuffer.begin() + count);
 
 	if(!m_running)
 		rtlsdr_cancel_async(m_dev);
@@ -55,10 +55,6 @@ private:
 
 	void run();
 
-	void decimate2(SampleVector::iterator* it, const quint8* buf, qint32 len);
-	void decimate4(SampleVector::iterator* it, const quint8* buf, qint32 len);
-	void decimate8(SampleVector::iterator* it, const quint8* buf, qint32 len);
-	void decimate16(SampleVector::iterator* it, const quint8* buf, qint32 len);
 	void callback(const quint8* buf, qint32 len);
 
 	static void callbackHelper(unsigned char* buf, uint32_t len, void* ctx);
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "dsp/channelizer.h"
 #include "dsp/inthalfbandfilter.h"
 #include "dsp/dspcommands.h"
@@ -25,24 +26,41 @@ void Channelizer::configure(MessageQueue* messageQueue, int sampleRate, int cent
 
 void Channelizer::feed(SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst)
 {
-	for(SampleVector::const_iterator sample = begin; sample != end; ++sample) {
-		Sample s(*sample);
-		bool haveSample = true;
-		FilterStages::iterator stage = m_filterStages.begin();
+	if(m_sampleSink == NULL)
+		return;
+
+	int count = end - begin;
+
+	if(m_filterStages.empty() || (count <= 0)) {
+		m_sampleSink->feed(begin, end, firstOfBurst);
+		return;
+	}
+
+	// preallocated buffers only ever grow
+	if((int)m_sampleBuffer.size() < count / 2 + 1)
+		m_sampleBuffer.resize(count / 2 + 1);
+	if(m_stageBuffer.size() < ChunkSize / 2 + 1)
+		m_stageBuffer.resize(ChunkSize / 2 + 1);
+
+	const Sample* in = &*begin;
+	Sample* out = &m_sampleBuffer[0];
+	Sample* stageBuffer = &m_stageBuffer[0];
+
+	// run the whole chain chunk by chunk so intermediate stages stay in cache
+	for(int done = 0; done < count; done += ChunkSize) {
+		int n = std::min(count - done, (int)ChunkSize);
+		const Sample* src = in + done;
+		FilterStages::const_iterator stage = m_filterStages.begin();
 		while(stage != m_filterStages.end()) {
-			haveSample = (*stage)->work(&s);
-			if(!haveSample)
-				break;
-			++stage;
+			FilterStage* filterStage = *stage;
+			Sample* dst = (++stage == m_filterStages.end()) ? out : stageBuffer;
+			n = filterStage->work(src, n, dst);
+			src = dst;
 		}
-		if((stage == m_filterStages.end()) && haveSample)
-			m_sampleBuffer.push_back(s);
+		out += n;
 	}
 
-	if(m_sampleSink != NULL)
-		m_sampleSink->feed(m_sampleBuffer.begin(), m_sampleBuffer.end(), firstOfBurst);
-
-	m_sampleBuffer.clear();
+	m_sampleSink->feed(m_sampleBuffer.begin(), m_sampleBuffer.begin() + (out - &m_sampleBuffer[0]), firstOfBurst);
 }
 
 void Channelizer::start()
@@ -98,21 +116,21 @@ void Channelizer::applyConfiguration()
 	m_currentOutputSampleRate = m_inputSampleRate / (1 << m_filterStages.size());
 }
 
-Channelizer::FilterStage::FilterStage(Mode mode) :
+Channelizer::FilterStage::FilterStage(StageMode mode) :
 	m_filter(new IntHalfbandFilter),
 	m_workFunction(NULL)
 {
 	switch(mode) {
 		case ModeCenter:
-			m_workFunction = &IntHalfbandFilter::workDecimateCenter;
+			m_workFunction = &IntHalfbandFilter::decimateCenter;
 			break;
 
 		case ModeLowerHalf:
-			m_workFunction = &IntHalfbandFilter::workDecimateLowerHalf;
+			m_workFunction = &IntHalfbandFilter::decimateLowerHalf;
 			break;
 
 		case ModeUpperHalf:
-			m_workFunction = &IntHalfbandFilter::workDecimateUpperHalf;
+			m_workFunction = &IntHalfbandFilter::decimateUpperHalf;
 			break;
 	}
 }
@@ -122,7 +140,7 @@ Channelizer::FilterStage::~FilterStage()
 	delete m_filter;
 }
 
-bool Channelizer::signalContainsChannel(Real sigStart, Real sigEnd, Real chanStart, Real chanEnd) const
+bool Channelizer::signalContainsChannel(Real sigStart, Real sigEnd, Real chanStart, Real chanEnd)
 {
 	//qDebug("   testing signal [%f, %f], channel [%f, %f]", sigStart, sigEnd, chanStart, chanEnd);
 	if(sigEnd <= sigStart)
@@ -132,7 +150,7 @@ bool Channelizer::signalContainsChannel(Real sigStart, Real sigEnd, Real chanSta
 	return (sigStart <= chanStart) && (sigEnd >= chanEnd);
 }
 
-Real Channelizer::createFilterChain(Real sigStart, Real sigEnd, Real chanStart, Real chanEnd)
+Real Channelizer::planFilterChain(Real sigStart, Real sigEnd, Real chanStart, Real chanEnd, StageModes* stageModes)
 {
 	Real sigBw = sigEnd - sigStart;
 	Real safetyMargin = sigBw / 20;
@@ -145,22 +163,22 @@ Real Channelizer::createFilterChain(Real sigStart, Real sigEnd, Real chanStart,
 	// check if it fits into the left half
 	if(signalContainsChannel(sigStart + safetyMargin, sigStart + sigBw / 2.0 - safetyMargin, chanStart, chanEnd)) {
 		//qDebug("-> take left half (rotate by +1/4 and decimate by 2)");
-		m_filterStages.push_back(new FilterStage(FilterStage::ModeLowerHalf));
-		return createFilterChain(sigStart, sigStart + sigBw / 2.0, chanStart, chanEnd);
+		stageModes->push_back(ModeLowerHalf);
+		return planFilterChain(sigStart, sigStart + sigBw / 2.0, chanStart, chanEnd, stageModes);
 	}
 
 	// check if it fits into the right half
 	if(signalContainsChannel(sigEnd - sigBw / 2.0f + safetyMargin, sigEnd - safetyMargin, chanStart, chanEnd)) {
 		//qDebug("-> take right half (rotate by -1/4 and decimate by 2)");
-		m_filterStages.push_back(new FilterStage(FilterStage::ModeUpperHalf));
-		return createFilterChain(sigEnd - sigBw / 2.0f, sigEnd, chanStart, chanEnd);
+		stageModes->push_back(ModeUpperHalf);
+		return planFilterChain(sigEnd - sigBw / 2.0f, sigEnd, chanStart, chanEnd, stageModes);
 	}
 
 	// check if it fits into the center
 	if(signalContainsChannel(sigStart + rot + safetyMargin, sigStart + rot + sigBw / 2.0f - safetyMargin, chanStart, chanEnd)) {
 		//qDebug("-> take center half (decimate by 2)");
-		m_filterStages.push_back(new FilterStage(FilterStage::ModeCenter));
-		return createFilterChain(sigStart + rot, sigStart + sigBw / 2.0f + rot, chanStart, chanEnd);
+		stageModes->push_back(ModeCenter);
+		return planFilterChain(sigStart + rot, sigStart + sigBw / 2.0f + rot, chanStart, chanEnd, stageModes);
 	}
 #endif
 	Real ofs = ((chanEnd - chanStart) / 2.0 + chanStart) - ((sigEnd - sigStart) / 2.0 + sigStart);
@@ -168,6 +186,17 @@ Real Channelizer::createFilterChain(Real sigStart, Real sigEnd, Real chanStart,
 	return ofs;
 }
 
+Real Channelizer::createFilterChain(Real sigStart, Real sigEnd, Real chanStart, Real chanEnd)
+{
+	StageModes stageModes;
+	Real ofs = planFilterChain(sigStart, sigEnd, chanStart, chanEnd, &stageModes);
+
+	for(StageModes::const_iterator it = stageModes.begin(); it != stageModes.end(); ++it)
+		m_filterStages.push_back(new FilterStage(*it));
+
+	return ofs;
+}
+
 void Channelizer::freeFilterChain()
 {
 	for(FilterStages::iterator it = m_filterStages.begin(); it != m_filterStages.end(); ++it)
@@ -0,0 +1,230 @@
+#include <algorithm>
+#include "dsp/channelizertree.h"
+#include "dsp/inthalfbandfilter.h"
+#include "dsp/samplesink.h"
+#include "dsp/dspcommands.h"
+
+ChannelizerTree::Node::Node(Node* parent, Channelizer::StageMode mode) :
+	m_parent(parent),
+	m_mode(mode),
+	m_filter(NULL),
+	m_workFunction(NULL),
+	m_depth(0),
+	m_nChannels(0),
+	m_children(),
+	m_sampleBuffer(),
+	m_fill(0)
+{
+	// the root is the full rate input itself
+	if(parent == NULL)
+		return;
+
+	m_depth = parent->m_depth + 1;
+	m_filter = new IntHalfbandFilter;
+	switch(mode) {
+		case Channelizer::ModeCenter:
+			m_workFunction = &IntHalfbandFilter::decimateCenter;
+			break;
+
+		case Channelizer::ModeLowerHalf:
+			m_workFunction = &IntHalfbandFilter::decimateLowerHalf;
+			break;
+
+		case Channelizer::ModeUpperHalf:
+			m_workFunction = &IntHalfbandFilter::decimateUpperHalf;
+			break;
+	}
+}
+
+ChannelizerTree::Node::~Node()
+{
+	for(Nodes::iterator it = m_children.begin(); it != m_children.end(); ++it)
+		delete *it;
+	if(m_filter != NULL)
+		delete m_filter;
+}
+
+ChannelizerTree::ChannelizerTree() :
+	m_channels(),
+	m_root(new Node(NULL, Channelizer::ModeCenter)),
+	m_sampleRate(0)
+{
+}
+
+ChannelizerTree::~ChannelizerTree()
+{
+	for(Channels::iterator it = m_channels.begin(); it != m_channels.end(); ++it)
+		delete *it;
+	delete m_root;
+}
+
+void ChannelizerTree::configure(int sampleRate)
+{
+	if(sampleRate == m_sampleRate)
+		return;
+
+	m_sampleRate = sampleRate;
+
+	// every path depends on the input rate - start over
+	for(Channels::iterator it = m_channels.begin(); it != m_channels.end(); ++it)
+		(*it)->m_node = NULL;
+	delete m_root;
+	m_root = new Node(NULL, Channelizer::ModeCenter);
+
+	for(Channels::iterator it = m_channels.begin(); it != m_channels.end(); ++it) {
+		attachChannel(*it);
+		notifyChannel(*it);
+	}
+}
+
+void ChannelizerTree::addChannel(SampleSink* sampleSink)
+{
+	for(Channels::iterator it = m_channels.begin(); it != m_channels.end(); ++it) {
+		if((*it)->m_sampleSink == sampleSink)
+			return;
+	}
+	m_channels.push_back(new Channel(sampleSink));
+}
+
+void ChannelizerTree::removeChannel(SampleSink* sampleSink)
+{
+	for(Channels::iterator it = m_channels.begin(); it != m_channels.end(); ++it) {
+		if((*it)->m_sampleSink == sampleSink) {
+			releaseNode((*it)->m_node);
+			delete *it;
+			m_channels.erase(it);
+			return;
+		}
+	}
+}
+
+void ChannelizerTree::configureChannel(SampleSink* sampleSink, int sampleRate, int centerFrequency)
+{
+	for(Channels::iterator it = m_channels.begin(); it != m_channels.end(); ++it) {
+		Channel* channel = *it;
+		if(channel->m_sampleSink != sampleSink)
+			continue;
+
+		channel->m_sampleRate = sampleRate;
+		channel->m_centerFrequency = centerFrequency;
+		// attach first, so stages shared with the old path keep their state
+		Node* node = channel->m_node;
+		channel->m_node = NULL;
+		attachChannel(channel);
+		releaseNode(node);
+		notifyChannel(channel);
+		return;
+	}
+}
+
+void ChannelizerTree::feed(SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst)
+{
+	int count = end - begin;
+	if(count <= 0)
+		return;
+
+	// run the whole tree chunk by chunk so shared stages stay in cache
+	const Sample* in = &*begin;
+	for(int done = 0; done < count; done += ChunkSize) {
+		int n = std::min(count - done, (int)ChunkSize);
+		for(Nodes::const_iterator it = m_root->m_children.begin(); it != m_root->m_children.end(); ++it)
+			work(*it, in + done, n, done == 0);
+	}
+
+	for(Channels::const_iterator it = m_channels.begin(); it != m_channels.end(); ++it) {
+		Channel* channel = *it;
+		Node* node = channel->m_node;
+		if(node == NULL)
+			continue;
+		if(node == m_root)
+			channel->m_sampleSink->feed(begin, end, firstOfBurst);
+		else channel->m_sampleSink->feed(node->m_sampleBuffer.begin(), node->m_sampleBuffer.begin() + node->m_fill, firstOfBurst);
+	}
+}
+
+void ChannelizerTree::start()
+{
+	for(Channels::iterator it = m_channels.begin(); it != m_channels.end(); ++it)
+		(*it)->m_sampleSink->start();
+}
+
+void ChannelizerTree::stop()
+{
+	for(Channels::iterator it = m_channels.begin(); it != m_channels.end(); ++it)
+		(*it)->m_sampleSink->stop();
+}
+
+void ChannelizerTree::attachChannel(Channel* channel)
+{
+	// nothing to plan before both rates are known
+	if((m_sampleRate <= 0) || (channel->m_sampleRate <= 0))
+		return;
+
+	Channelizer::StageModes stageModes;
+	channel->m_offset = Channelizer::planFilterChain(
+		m_sampleRate / -2, m_sampleRate / 2,
+		channel->m_centerFrequency - channel->m_sampleRate / 2, channel->m_centerFrequency + channel->m_sampleRate / 2,
+		&stageModes);
+
+	Node* node = m_root;
+	for(Channelizer::StageModes::const_iterator mode = stageModes.begin(); mode != stageModes.end(); ++mode) {
+		Node* child = NULL;
+		for(Nodes::const_iterator it = node->m_children.begin(); it != node->m_children.end(); ++it) {
+			if((*it)->m_mode == *mode) {
+				child = *it;
+				break;
+			}
+		}
+		if(child == NULL) {
+			child = new Node(node, *mode);
+			node->m_children.push_back(child);
+		}
+		node = child;
+	}
+
+	node->m_nChannels++;
+	channel->m_node = node;
+}
+
+void ChannelizerTree::releaseNode(Node* node)
+{
+	if(node == NULL)
+		return;
+
+	node->m_nChannels--;
+
+	// drop stages nobody listens to anymore
+	while((node != m_root) && (node->m_nChannels == 0) && node->m_children.empty()) {
+		Node* parent = node->m_parent;
+		parent->m_children.erase(std::find(parent->m_children.begin(), parent->m_children.end(), node));
+		delete node;
+		node = parent;
+	}
+}
+
+void ChannelizerTree::notifyChannel(Channel* channel)
+{
+	if(channel->m_node == NULL)
+		return;
+
+	DSPSignalNotification* signal = DSPSignalNotification::create(m_sampleRate >> channel->m_node->m_depth, channel->m_offset);
+	if(!channel->m_sampleSink->handleMessage(signal))
+		signal->completed();
+}
+
+void ChannelizerTree::work(Node* node, const Sample* in, int count, bool restart)
+{
+	if(restart)
+		node->m_fill = 0;
+
+	// buffers only ever grow
+	if((int)node->m_sampleBuffer.size() < node->m_fill + count / 2 + 1)
+		node->m_sampleBuffer.resize(node->m_fill + count / 2 + 1 + ChunkSize);
+
+	Sample* out = &node->m_sampleBuffer[node->m_fill];
+	int n = (node->m_filter->*node->m_workFunction)(in, count, out);
+	node->m_fill += n;
+
+	for(Nodes::const_iterator it = node->m_children.begin(); it != node->m_children.end(); ++it)
+		work(*it, out, n, restart);
+}
@@ -9,12 +9,22 @@ MESSAGE_CLASS_DEFINITION(DSPGetErrorMessage, Message)
 MESSAGE_CLASS_DEFINITION(DSPSetSource, Message)
 MESSAGE_CLASS_DEFINITION(DSPAddSink, Message)
 MESSAGE_CLASS_DEFINITION(DSPRemoveSink, Message)
+MESSAGE_CLASS_DEFINITION(DSPAddPFBSink, Message)
+MESSAGE_CLASS_DEFINITION(DSPRemovePFBSink, Message)
+MESSAGE_CLASS_DEFINITION(DSPAddChannelizerSink, Message)
+MESSAGE_CLASS_DEFINITION(DSPRemoveChannelizerSink, Message)
 MESSAGE_CLASS_DEFINITION(DSPAddAudioSource, Message)
 MESSAGE_CLASS_DEFINITION(DSPRemoveAudioSource, Message)
 MESSAGE_CLASS_DEFINITION(DSPConfigureSpectrumVis, Message)
+MESSAGE_CLASS_DEFINITION(DSPConfigureSpectrumFrames, Message)
 MESSAGE_CLASS_DEFINITION(DSPConfigureCorrection, Message)
 MESSAGE_CLASS_DEFINITION(DSPConfigureAudioOutput, Message)
+MESSAGE_CLASS_DEFINITION(DSPConfigureSinkThreads, Message)
 MESSAGE_CLASS_DEFINITION(DSPEngineReport, Message)
 MESSAGE_CLASS_DEFINITION(DSPConfigureScopeVis, Message)
+MESSAGE_CLASS_DEFINITION(DSPConfigureIQRecorder, Message)
+MESSAGE_CLASS_DEFINITION(DSPIQRecorderStopped, Message)
 MESSAGE_CLASS_DEFINITION(DSPSignalNotification, Message)
 MESSAGE_CLASS_DEFINITION(DSPConfigureChannelizer, Message)
+MESSAGE_CLASS_DEFINITION(DSPConfigurePFBSink, Message)
+MESSAGE_CLASS_DEFINITION(DSPConfigureChannelizerSink, Message)
@@ -30,15 +30,12 @@ DSPEngine::DSPEngine(MessageQueue* reportQueue, QObject* parent) :
 	m_state(StNotStarted),
 	m_sampleSource(NULL),
 	m_sampleSinks(),
+	m_workerPool(),
+	m_pfbChannelizer(),
+	m_channelizerTree(),
 	m_sampleRate(0),
 	m_centerFrequency(0),
-	m_dcOffsetCorrection(false),
-	m_iqImbalanceCorrection(false),
-	m_iOffset(0),
-	m_qOffset(0),
-	m_iRange(1 << 16),
-	m_qRange(1 << 16),
-	m_imbalance(65536)
+	m_iqCorrection()
 {
 	moveToThread(this);
 }
@@ -91,6 +88,42 @@ void DSPEngine::removeSink(SampleSink* sink)
 	cmd.execute(&m_messageQueue);
 }
 
+void DSPEngine::addPFBSink(SampleSink* sink)
+{
+	DSPAddPFBSink cmd(sink);
+	cmd.execute(&m_messageQueue);
+}
+
+void DSPEngine::removePFBSink(SampleSink* sink)
+{
+	DSPRemovePFBSink cmd(sink);
+	cmd.execute(&m_messageQueue);
+}
+
+void DSPEngine::configurePFBSink(SampleSink* sink, int bandwidth, int centerFrequency)
+{
+	Message* cmd = DSPConfigurePFBSink::create(sink, bandwidth, centerFrequency);
+	cmd->submit(&m_messageQueue);
+}
+
+void DSPEngine::addChannelizerSink(SampleSink* sink)
+{
+	DSPAddChannelizerSink cmd(sink);
+	cmd.execute(&m_messageQueue);
+}
+
+void DSPEngine::removeChannelizerSink(SampleSink* sink)
+{
+	DSPRemoveChannelizerSink cmd(sink);
+	cmd.execute(&m_messageQueue);
+}
+
+void DSPEngine::configureChannelizerSink(SampleSink* sink, int sampleRate, int centerFrequency)
+{
+	Message* cmd = DSPConfigureChannelizerSink::create(sink, sampleRate, centerFrequency);
+	cmd->submit(&m_messageQueue);
+}
+
 void DSPEngine::addAudioSource(AudioFifo* audioFifo)
 {
 	DSPAddAudioSource cmd(audioFifo);
@@ -115,6 +148,12 @@ void DSPEngine::configureAudioOutput(const QString& audioOutput, quint32 audioOu
 	cmd->submit(&m_messageQueue);
 }
 
+void DSPEngine::configureSinkThreads(int sinkThreads)
+{
+	Message* cmd = DSPConfigureSinkThreads::create(sinkThreads);
+	cmd->submit(&m_messageQueue);
+}
+
 QString DSPEngine::errorMessage()
 {
 	DSPGetErrorMessage cmd;
@@ -139,68 +178,6 @@ void DSPEngine::run()
 	exec();
 }
 
-void DSPEngine::dcOffset(SampleVector::iterator begin, SampleVector::iterator end)
-{
-	int count = end - begin;
-	int io = 0;
-	int qo = 0;
-
-	// sum all sample components
-	for(SampleVector::iterator it = begin; it < end; it++) {
-		io += it->real();
-		qo += it->imag();
-	}
-
-	// build a sliding average (el cheapo style)
-	m_iOffset = (m_iOffset * 3 + io / count) >> 2;
-	m_qOffset = (m_qOffset * 3 + qo / count) >> 2;
-
-	// correct samples
-	Sample corr(m_iOffset, m_qOffset);
-	for(SampleVector::iterator it = begin; it < end; it++)
-		*it -= corr;
-}
-
-void DSPEngine::imbalance(SampleVector::iterator begin, SampleVector::iterator end)
-{
-	int iMin = 0;
-	int iMax = 0;
-	int qMin = 0;
-	int qMax = 0;
-
-	// find value ranges for both I and Q
-	// both intervals should be same same size (for a perfect circle)
-	for(SampleVector::iterator it = begin; it < end; it++) {
-		if(it != begin) {
-			if(it->real() < iMin)
-				iMin = it->real();
-			else if(it->real() > iMax)
-				iMax = it->real();
-			if(it->imag() < qMin)
-				qMin = it->imag();
-			else if(it->imag() > qMax)
-				qMax = it->imag();
-		} else {
-			iMin = it->real();
-			iMax = it->real();
-			qMin = it->imag();
-			qMax = it->imag();
-		}
-	}
-
-	// sliding average (el cheapo again)
-	m_iRange = (m_iRange * 15 + (iMax - iMin)) >> 4;
-	m_qRange = (m_qRange * 15 + (qMax - qMin)) >> 4;
-
-	// calculate imbalance as Q15.16
-	if(m_qRange != 0)
-		m_imbalance = ((uint)m_iRange << 16) / (uint)m_qRange;
-
-	// correct imbalance and convert back to signed int 16
-	for(SampleVector::iterator it = begin; it < end; it++)
-		it->m_imag = (it->m_imag * m_imbalance) >> 16;
-}
-
 void DSPEngine::work()
 {
 	SampleFifo* sampleFifo = m_sampleSource->getSampleFifo();
@@ -208,37 +185,21 @@ void DSPEngine::work()
 	bool firstOfBurst = true;
 
 	while((sampleFifo->fill() > 0) && (m_messageQueue.countPending() == 0) && (samplesDone < m_sampleRate / 2)) {
-		SampleVector::iterator part1begin;
-		SampleVector::iterator part1end;
-		SampleVector::iterator part2begin;
-		SampleVector::iterator part2end;
-
-		size_t count = sampleFifo->readBegin(sampleFifo->fill(), &part1begin, &part1end, &part2begin, &part2end);
-
-		// first part of FIFO data
-		if(part1begin != part1end) {
-			// correct stuff
-			if(m_dcOffsetCorrection)
-				dcOffset(part1begin, part1end);
-			if(m_iqImbalanceCorrection)
-				imbalance(part1begin, part1end);
-			// feed data to handlers
-			for(SampleSinks::const_iterator it = m_sampleSinks.begin(); it != m_sampleSinks.end(); ++it)
-				(*it)->feed(part1begin, part1end, firstOfBurst);
-			firstOfBurst = false;
-		}
-		// second part of FIFO data (used when block wraps around)
-		if(part2begin != part2end) {
-			// correct stuff
-			if(m_dcOffsetCorrection)
-				dcOffset(part2begin, part2end);
-			if(m_iqImbalanceCorrection)
-				imbalance(part2begin, part2end);
-			// feed data to handlers
-			for(SampleSinks::const_iterator it = m_sampleSinks.begin(); it != m_sampleSinks.end(); ++it)
-				(*it)->feed(part2begin, part2end, firstOfBurst);
-			firstOfBurst = false;
-		}
+		SampleVector::iterator readBegin;
+		SampleVector::iterator readEnd;
+
+		size_t count = sampleFifo->readBegin(sampleFifo->fill(), &readBegin, &readEnd);
+
+		// correct stuff
+		if(m_iqCorrection.isEnabled())
+			m_iqCorrection.process(&*readBegin, count);
+		// feed data to handlers - returns once all of them are done with the block
+		if(m_pfbChannelizer.hasChannels())
+			m_pfbChannelizer.feed(readBegin, readEnd, firstOfBurst);
+		if(m_channelizerTree.hasChannels())
+			m_channelizerTree.feed(readBegin, readEnd, firstOfBurst);
+		m_workerPool.feed(m_sampleSinks, readBegin, readEnd, firstOfBurst);
+		firstOfBurst = false;
 
 		// adjust FIFO pointers
 		sampleFifo->readCommit(count);
@@ -265,6 +226,8 @@ DSPEngine::State DSPEngine::gotoIdle()
 
 	for(SampleSinks::const_iterator it = m_sampleSinks.begin(); it != m_sampleSinks.end(); it++)
 		(*it)->stop();
+	m_pfbChannelizer.stop();
+	m_channelizerTree.stop();
 	m_sampleSource->stopInput();
 	m_deviceDescription.clear();
 	m_audioOutput.stop();
@@ -290,10 +253,7 @@ DSPEngine::State DSPEngine::gotoRunning()
 	if(m_sampleSource == NULL)
 		return gotoError("No sample source configured");
 
-	m_iOffset = 0;
-	m_qOffset = 0;
-	m_iRange = 1 << 16;
-	m_qRange = 1 << 16;
+	m_iqCorrection.reset();
 
 	if(!m_sampleSource->startInput(0))
 		return gotoError("Could not start sample source");
@@ -306,6 +266,8 @@ DSPEngine::State DSPEngine::gotoRunning()
 
 	for(SampleSinks::const_iterator it = m_sampleSinks.begin(); it != m_sampleSinks.end(); it++)
 		(*it)->start();
+	m_pfbChannelizer.start();
+	m_channelizerTree.start();
 	m_sampleRate = 0; // make sure, report is sent
 	generateReport();
 
@@ -352,6 +314,8 @@ void DSPEngine::generateReport()
 			DSPSignalNotification* signal = DSPSignalNotification::create(m_sampleRate, 0);
 			signal->submit(&m_messageQueue, *it);
 		}
+		m_pfbChannelizer.configure(m_sampleRate);
+		m_channelizerTree.configure(m_sampleRate);
 	}
 	if(centerFrequency != m_centerFrequency) {
 		m_centerFrequency = centerFrequency;
@@ -399,6 +363,7 @@ void DSPEngine::handleMessages()
 			message->completed(m_state);
 		} else if(DSPExit::match(message)) {
 			gotoIdle();
+			m_workerPool.setThreadCount(0);
 			m_state = StNotStarted;
 			exit();
 			message->completed(m_state);
@@ -434,6 +399,38 @@ void DSPEngine::handleMessages()
 				sink->stop();
 			m_sampleSinks.remove(sink);
 			message->completed();
+		} else if(DSPAddPFBSink::match(message)) {
+			SampleSink* sink = DSPAddPFBSink::cast(message)->getSampleSink();
+			if(m_state == StRunning)
+				sink->start();
+			m_pfbChannelizer.addChannel(sink);
+			message->completed();
+		} else if(DSPRemovePFBSink::match(message)) {
+			SampleSink* sink = DSPRemovePFBSink::cast(message)->getSampleSink();
+			if(m_state == StRunning)
+				sink->stop();
+			m_pfbChannelizer.removeChannel(sink);
+			message->completed();
+		} else if(DSPConfigurePFBSink::match(message)) {
+			DSPConfigurePFBSink* conf = DSPConfigurePFBSink::cast(message);
+			m_pfbChannelizer.configureChannel(conf->getSampleSink(), conf->getBandwidth(), conf->getCenterFrequency());
+			message->completed();
+		} else if(DSPAddChannelizerSink::match(message)) {
+			SampleSink* sink = DSPAddChannelizerSink::cast(message)->getSampleSink();
+			if(m_state == StRunning)
+				sink->start();
+			m_channelizerTree.addChannel(sink);
+			message->completed();
+		} else if(DSPRemoveChannelizerSink::match(message)) {
+			SampleSink* sink = DSPRemoveChannelizerSink::cast(message)->getSampleSink();
+			if(m_state == StRunning)
+				sink->stop();
+			m_channelizerTree.removeChannel(sink);
+			message->completed();
+		} else if(DSPConfigureChannelizerSink::match(message)) {
+			DSPConfigureChannelizerSink* conf = DSPConfigureChannelizerSink::cast(message);
+			m_channelizerTree.configureChannel(conf->getSampleSink(), conf->getSampleRate(), conf->getCenterFrequency());
+			message->completed();
 		} else if(DSPAddAudioSource::match(message)) {
 			m_audioOutput.addFifo(DSPAddAudioSource::cast(message)->getAudioFifo());
 			message->completed();
@@ -443,20 +440,12 @@ void DSPEngine::handleMessages()
 		} else if(DSPConfigureAudioOutput::match(message)) {
 			DSPConfigureAudioOutput* conf = DSPConfigureAudioOutput::cast(message);
 			m_audioOutput.configure(conf->getAudioOutputDevice(), conf->getAudioOutputRate());
+		} else if(DSPConfigureSinkThreads::match(message)) {
+			m_workerPool.setThreadCount(DSPConfigureSinkThreads::cast(message)->getSinkThreads());
+			message->completed();
 		} else if(DSPConfigureCorrection::match(message)) {
 			DSPConfigureCorrection* conf = DSPConfigureCorrection::cast(message);
-			m_iqImbalanceCorrection = conf->getIQImbalanceCorrection();
-			if(m_dcOffsetCorrection != conf->getDCOffsetCorrection()) {
-				m_dcOffsetCorrection = conf->getDCOffsetCorrection();
-				m_iOffset = 0;
-				m_qOffset = 0;
-			}
-			if(m_iqImbalanceCorrection != conf->getIQImbalanceCorrection()) {
-				m_iqImbalanceCorrection = conf->getIQImbalanceCorrection();
-				m_iRange = 1 << 16;
-				m_qRange = 1 << 16;
-				m_imbalance = 65536;
-			}
+			m_iqCorrection.configure(conf->getDCOffsetCorrection(), conf->getIQImbalanceCorrection());
 			message->completed();
 		} else {
 			if(!distributeMessage(message))
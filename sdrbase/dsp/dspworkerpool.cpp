@@ -0,0 +1,125 @@
+#include "dsp/dspworkerpool.h"
+#include "dsp/samplesink.h"
+
+DSPWorkerPool::DSPWorkerPool() :
+	m_workers(),
+	m_block(),
+	m_currentBlock(NULL),
+	m_generation(0),
+	m_quit(false)
+{
+}
+
+DSPWorkerPool::~DSPWorkerPool()
+{
+	stopWorkers();
+}
+
+void DSPWorkerPool::setThreadCount(int threadCount)
+{
+	if(threadCount < 0)
+		threadCount = 0;
+	if(threadCount == (int)m_workers.size())
+		return;
+
+	stopWorkers();
+
+	m_quit = false;
+	for(int i = 0; i < threadCount; i++) {
+		Worker* worker = new Worker(this);
+		m_workers.push_back(worker);
+		worker->start();
+	}
+	qDebug("DSPWorkerPool: %d worker threads", threadCount);
+}
+
+void DSPWorkerPool::feed(const SampleSinks& sinks, SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst)
+{
+	// nothing to gain from the pool
+	if(m_workers.empty() || (sinks.size() < 2)) {
+		for(SampleSinks::const_iterator it = sinks.begin(); it != sinks.end(); ++it)
+			(*it)->feed(begin, end, firstOfBurst);
+		return;
+	}
+
+	// the join below leaves nobody inside the block, it can be reused for every feed
+	Block* block = &m_block;
+	block->m_users = 0;
+	block->m_nextJob.store(0);
+	block->m_pendingJobs.store(sinks.size());
+	block->m_sinks.assign(sinks.begin(), sinks.end());
+	block->m_begin = begin;
+	block->m_end = end;
+	block->m_firstOfBurst = firstOfBurst;
+
+	m_mutex.lock();
+	m_currentBlock = block;
+	m_generation++;
+	m_workAvailable.wakeAll();
+	m_mutex.unlock();
+
+	// lend a hand instead of idling
+	runJobs(block);
+
+	// join - the samples must not be released before every sink is done with them and the
+	// block not be touched again before the last worker has left it
+	m_mutex.lock();
+	while((block->m_pendingJobs.loadAcquire() > 0) || (block->m_users > 0))
+		m_blockDone.wait(&m_mutex);
+	m_currentBlock = NULL;
+	m_mutex.unlock();
+}
+
+void DSPWorkerPool::workerLoop()
+{
+	uint generation = 0;
+
+	m_mutex.lock();
+	while(!m_quit) {
+		if((m_currentBlock == NULL) || (generation == m_generation)) {
+			m_workAvailable.wait(&m_mutex);
+			continue;
+		}
+
+		Block* block = m_currentBlock;
+		generation = m_generation;
+		block->m_users++;
+		m_mutex.unlock();
+
+		runJobs(block);
+
+		m_mutex.lock();
+		if(--block->m_users == 0)
+			m_blockDone.wakeAll();
+	}
+	m_mutex.unlock();
+}
+
+void DSPWorkerPool::runJobs(Block* block)
+{
+	int job;
+	int jobs = block->m_sinks.size();
+
+	while((job = block->m_nextJob.fetchAndAddRelaxed(1)) < jobs) {
+		block->m_sinks[job]->feed(block->m_begin, block->m_end, block->m_firstOfBurst);
+
+		if(block->m_pendingJobs.fetchAndAddRelease(-1) == 1) {
+			QMutexLocker mutexLocker(&m_mutex);
+			m_blockDone.wakeAll();
+		}
+	}
+}
+
+void DSPWorkerPool::stopWorkers()
+{
+	m_mutex.lock();
+	m_quit = true;
+	m_workAvailable.wakeAll();
+	m_mutex.unlock();
+
+	for(Workers::iterator it = m_workers.begin(); it != m_workers.end(); ++it) {
+		(*it)->wait();
+		delete *it;
+	}
+	m_workers.clear();
+}
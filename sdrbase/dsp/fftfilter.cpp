@@ -0,0 +1,223 @@
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <algorithm>
+#include "dsp/fftfilter.h"
+#include "dsp/fftengine.h"
+
+FFTFilter::FFTFilter() :
+	m_fft(NULL),
+	m_ifft(NULL),
+	m_fftSize(0),
+	m_hop(0),
+	m_decimation(1),
+	m_nTaps(0),
+	m_spectrum(),
+	m_window(),
+	m_fill(0),
+	m_rotation(0),
+	m_windowStart(0)
+{
+}
+
+FFTFilter::~FFTFilter()
+{
+	free();
+}
+
+bool FFTFilter::create(const std::vector<Complex>& taps, int decimation, int fftSize)
+{
+	free();
+
+	int nTaps = taps.size();
+	if((nTaps < 1) || (decimation < 1)) {
+		qCritical("FFTFilter: invalid filter (%d taps, decimation %d)", nTaps, decimation);
+		return false;
+	}
+
+	// a power of two times the decimation, so the inverse FFT is a power of two as well
+	if(fftSize <= 0) {
+		fftSize = decimation;
+		while(fftSize < 4 * nTaps)
+			fftSize *= 2;
+	}
+	if((fftSize % decimation) != 0) {
+		qCritical("FFTFilter: FFT size %d is no multiple of the decimation %d", fftSize, decimation);
+		return false;
+	}
+	// the hop has to be a multiple of the decimation to keep the output phase
+	int hop = ((fftSize - nTaps + 1) / decimation) * decimation;
+	if((nTaps > fftSize / 2) || (hop <= 0)) {
+		qCritical("FFTFilter: FFT size %d too small for %d taps", fftSize, nTaps);
+		return false;
+	}
+
+	m_fft = FFTEngine::create();
+	m_ifft = FFTEngine::create();
+	if((m_fft == NULL) || (m_ifft == NULL)) {
+		free();
+		return false;
+	}
+
+	m_fftSize = fftSize;
+	m_hop = hop;
+	m_decimation = decimation;
+	m_nTaps = nTaps;
+	// may have been set before create() or for another FFT size, process() needs it below m_fftSize
+	setRotation(m_rotation);
+
+	// taps spectrum
+	m_fft->configure(m_fftSize, false);
+	Complex* fftIn = m_fft->in();
+	std::fill(fftIn, fftIn + m_fftSize, Complex(0, 0));
+	std::copy(taps.begin(), taps.end(), fftIn);
+	m_fft->transform();
+	m_spectrum.resize(m_fftSize);
+	const Complex* fftOut = m_fft->out();
+	for(int i = 0; i < m_fftSize; i++)
+		m_spectrum[i] = fftOut[i] / (Real)m_fftSize;
+
+	m_ifft->configure(m_fftSize / m_decimation, true);
+
+	// the first window starts with the overlap, all zeros
+	m_window.assign(m_fftSize, Complex(0, 0));
+	m_fill = m_fftSize - m_hop;
+	m_windowStart = m_hop % m_fftSize;
+
+	qDebug("FFTFilter: %d taps, FFT size %d, %d samples per block, decimation %d", m_nTaps, m_fftSize, m_hop, m_decimation);
+	return true;
+}
+
+bool FFTFilter::createLowpass(int nTaps, double sampleRate, double cutoff, int decimation, int fftSize)
+{
+	if(!(nTaps & 1))
+		nTaps++;
+
+	std::vector<Complex> taps(nTaps);
+	double wc = 2.0 * M_PI * cutoff / sampleRate;
+	double sum = 0;
+	int center = (nTaps - 1) / 2;
+
+	// sinc with a Blackman window
+	for(int i = 0; i < nTaps; i++) {
+		int n = i - center;
+		double v;
+		if(n == 0)
+			v = wc / M_PI;
+		else v = sin(n * wc) / (n * M_PI);
+		v *= 0.42 - 0.5 * cos((2.0 * M_PI * i) / (nTaps - 1)) + 0.08 * cos((4.0 * M_PI * i) / (nTaps - 1));
+		taps[i] = Complex(v, 0);
+		sum += v;
+	}
+
+	// unity gain at DC
+	for(int i = 0; i < nTaps; i++)
+		taps[i] /= (Real)sum;
+
+	return create(taps, decimation, fftSize);
+}
+
+void FFTFilter::setRotation(int bins)
+{
+	if(m_fftSize > 0) {
+		bins %= m_fftSize;
+		if(bins < 0)
+			bins += m_fftSize;
+	}
+	m_rotation = bins;
+}
+
+int FFTFilter::binFor(double frequency, double sampleRate) const
+{
+	return (int)floor(frequency / sampleRate * m_fftSize + 0.5);
+}
+
+int FFTFilter::filter(const Complex* in, int count, Complex* out)
+{
+	if(m_fftSize == 0)
+		return 0;
+
+	int produced = 0;
+
+	while(count > 0) {
+		int todo = std::min(count, m_fftSize - m_fill);
+		std::copy(in, in + todo, m_window.begin() + m_fill);
+		m_fill += todo;
+		in += todo;
+		count -= todo;
+
+		if(m_fill == m_fftSize) {
+			process(out + produced);
+			produced += m_hop / m_decimation;
+
+			// the end of this window is the start of the next one
+			std::copy(m_window.begin() + m_hop, m_window.end(), m_window.begin());
+			m_fill = m_fftSize - m_hop;
+			m_windowStart = (m_windowStart + m_hop) % m_fftSize;
+		}
+	}
+
+	return produced;
+}
+
+int FFTFilter::maxOutput(int count) const
+{
+	if(m_fftSize == 0)
+		return 0;
+	return ((m_fill + count - (m_fftSize - m_hop)) / m_hop) * (m_hop / m_decimation);
+}
+
+void FFTFilter::free()
+{
+	if(m_fft != NULL) {
+		delete m_fft;
+		m_fft = NULL;
+	}
+	if(m_ifft != NULL) {
+		delete m_ifft;
+		m_ifft = NULL;
+	}
+	m_fftSize = 0;
+}
+
+void FFTFilter::process(Complex* out)
+{
+	std::copy(m_window.begin(), m_window.end(), m_fft->in());
+	m_fft->transform();
+
+	// rotate, apply the taps and fold the aliases on top of each other. output bin j collects
+	// the input bins j + k * m_fftSize / m_decimation (+ m_rotation)
+	const Complex* spectrum = m_fft->out();
+	Complex* folded = m_ifft->in();
+	int outSize = m_fftSize / m_decimation;
+
+	for(int j = 0; j < outSize; j++) {
+		Real re = 0;
+		Real im = 0;
+		for(int k = j; k < m_fftSize; k += outSize) {
+			int bin = k + m_rotation;
+			if(bin >= m_fftSize)
+				bin -= m_fftSize;
+			const Complex& x = spectrum[bin];
+			const Complex& h = m_spectrum[k];
+			re += x.real() * h.real() - x.imag() * h.imag();
+			im += x.real() * h.imag() + x.imag() * h.real();
+		}
+		folded[j] = Complex(re, im);
+	}
+
+	m_ifft->transform();
+
+	// the last m_hop samples of the window are valid, undo the phase the rotation left on them
+	const Complex* result = m_ifft->out() + (m_fftSize - m_hop) / m_decimation;
+	int n = m_hop / m_decimation;
+
+	if(m_rotation == 0) {
+		std::copy(result, result + n, out);
+	} else {
+		double phase = -2.0 * M_PI * (double)(((qint64)m_rotation * m_windowStart) % m_fftSize) / m_fftSize;
+		Real c = cos(phase);
+		Real s = sin(phase);
+		for(int i = 0; i < n; i++)
+			out[i] = Complex(result[i].real() * c - result[i].imag() * s, result[i].real() * s + result[i].imag() * c);
+	}
+}
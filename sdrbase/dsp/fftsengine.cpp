@@ -16,6 +16,7 @@ FFTSEngine::~FFTSEngine()
 
 void FFTSEngine::allocate(int n)
 {
+	m_size = n;
 	m_imem = malloc(n * sizeof(Real) * 2 + 15);
 	m_iptr = (void*)(((unsigned long)m_imem + 15) & (unsigned long)(~0x0f));
 	m_omem = malloc(n * sizeof(Real) * 2 + 15);
@@ -24,6 +25,8 @@ void FFTSEngine::allocate(int n)
 
 void FFTSEngine::configure(int n, bool inverse)
 {
+	// the buffers start at 8192 samples, users like FFTFilter go beyond that
+	reserve(1, n);
 	ffts_free(m_currentplan);
 	m_currentplan = ffts_init_1d(n, inverse ? 1 : -1);
 }
@@ -33,6 +36,24 @@ void FFTSEngine::transform()
 	ffts_execute(m_currentplan, m_iptr, m_optr);
 }
 
+void FFTSEngine::reserve(int count, int stride)
+{
+	if(count * stride > m_size) {
+		free(m_imem);
+		free(m_omem);
+		allocate(count * stride);
+	}
+}
+
+// FFTS wants 16 byte aligned frames, which an even stride keeps
+void FFTSEngine::transformMany(int count, int stride)
+{
+	Complex* in = reinterpret_cast<Complex*>(m_iptr);
+	Complex* out = reinterpret_cast<Complex*>(m_optr);
+	for(int i = 0; i < count; i++)
+		ffts_execute(m_currentplan, in + i * stride, out + i * stride);
+}
+
 Complex* FFTSEngine::in()
 {
 	return reinterpret_cast<Complex*>(m_iptr);
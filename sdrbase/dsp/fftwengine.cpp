@@ -1,9 +1,89 @@
 #include <QTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QStandardPaths>
 #include "dsp/fftwengine.h"
 
+#if defined(USE_FFTW_THREADS)
+#include <QThread>
+
+static const int threadedSize = 65536;
+#endif
+
+// FFTW_PATIENT up to that many samples, FFTW_MEASURE above - the largest spectrum FFTs would take
+// minutes otherwise
+static const int patientSize = 65536;
+// seconds, the planner holds the global lock and the thread pool waits for it at exit
+static const double plannerTimeLimit = 2.0;
+
+static unsigned planFlags(int size)
+{
+	return (size <= patientSize) ? FFTW_PATIENT : FFTW_MEASURE;
+}
+
+class FFTWEngine::PatientPlanner : public QRunnable {
+public:
+	PatientPlanner(int n, bool inverse, int count, int stride, PatientPlan* patient) :
+		m_n(n),
+		m_inverse(inverse),
+		m_count(count),
+		m_stride(stride),
+		m_patient(patient)
+	{ }
+
+	void run()
+	{
+		// the engine is gone or moved on already
+		if(m_patient->refCount.load() == 1) {
+			release(m_patient);
+			return;
+		}
+
+		// measuring overwrites the arrays, so not the ones the engine is using
+		int size = m_count * m_stride;
+		fftwf_complex* in = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * size);
+		fftwf_complex* out = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * size);
+
+		m_globalPlanMutex.lock();
+		QTime t;
+		t.start();
+		fftwf_set_timelimit(plannerTimeLimit);
+		fftwf_plan plan = makePlan(m_n, m_inverse, m_count, m_stride, in, out, planFlags(m_n * m_count));
+		fftwf_set_timelimit(FFTW_NO_TIMELIMIT);
+		int elapsed = t.elapsed();
+		saveWisdom();
+		destroyRetired();
+		m_globalPlanMutex.unlock();
+
+		fftwf_free(in);
+		fftwf_free(out);
+		qDebug("FFT: creating patient FFTW plan (n=%d,%s,%dx) took %dms", m_n, m_inverse ? "inverse" : "forward", m_count, elapsed);
+
+		m_patient->plan.storeRelease(plan);
+		release(m_patient);
+	}
+
+private:
+	int m_n;
+	bool m_inverse;
+	int m_count;
+	int m_stride;
+	PatientPlan* m_patient;
+};
+
 FFTWEngine::FFTWEngine() :
 	m_plans(),
-	m_currentPlan(NULL)
+	m_currentPlan(NULL),
+	m_batchPlan(NULL),
+	m_fallback(),
+	m_fallbackSize(0),
+	m_fallbackInverse(false),
+	m_in(NULL),
+	m_out(NULL),
+	m_size(0)
 {
 }
 
@@ -14,56 +94,284 @@ FFTWEngine::~FFTWEngine()
 
 void FFTWEngine::configure(int n, bool inverse)
 {
-	for(Plans::const_iterator it = m_plans.begin(); it != m_plans.end(); ++it) {
-		if(((*it)->n == n) && ((*it)->inverse == inverse)) {
-			m_currentPlan = *it;
-			return;
-		}
-	}
+	m_batchPlan = NULL;
+	allocate(n);
 
-	m_globalPlanMutex.lock();
-	m_currentPlan = new Plan;
-	m_currentPlan->n = n;
-	m_currentPlan->inverse = inverse;
-	m_currentPlan->in = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * n);
-	m_currentPlan->out = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * n);
-	QTime t;
-	t.start();
-	m_currentPlan->plan = fftwf_plan_dft_1d(n, m_currentPlan->in, m_currentPlan->out, inverse ? FFTW_BACKWARD : FFTW_FORWARD, FFTW_PATIENT);
-	m_globalPlanMutex.unlock();
-	qDebug("FFT: creating FFTW plan (n=%d,%s) took %dms", n, inverse ? "inverse" : "forward", t.elapsed());
-	m_plans.push_back(m_currentPlan);
+	m_currentPlan = findPlan(n, inverse, 1, n);
+	if(m_currentPlan == NULL)
+		m_currentPlan = createPlan(n, inverse, 1, n);
 }
 
 void FFTWEngine::transform()
 {
-	if(m_currentPlan != NULL)
-		fftwf_execute(m_currentPlan->plan);
+	if(m_currentPlan == NULL)
+		return;
+
+	if(m_currentPlan->deferred)
+		startPlan(m_currentPlan);
+	if(m_currentPlan->patient != NULL)
+		upgrade(m_currentPlan);
+	if(m_currentPlan->plan != NULL)
+		fftwf_execute_dft(m_currentPlan->plan, m_in, m_out);
+	else fallback(m_currentPlan->n, m_currentPlan->inverse, 1, 0);
+}
+
+void FFTWEngine::reserve(int count, int stride)
+{
+	if(m_currentPlan == NULL)
+		return;
+
+	allocate(count * stride);
+
+	m_batchPlan = NULL;
+	if(count > 1) {
+		m_batchPlan = findPlan(m_currentPlan->n, m_currentPlan->inverse, count, stride);
+		if(m_batchPlan == NULL)
+			m_batchPlan = createPlan(m_currentPlan->n, m_currentPlan->inverse, count, stride);
+	}
+}
+
+void FFTWEngine::transformMany(int count, int stride)
+{
+	if(m_currentPlan == NULL)
+		return;
+
+	Plan* batch = m_batchPlan;
+	if((batch != NULL) && (batch->count == count) && (batch->stride == stride)) {
+		if(batch->deferred)
+			startPlan(batch);
+		if(batch->patient != NULL)
+			upgrade(batch);
+		if(batch->plan != NULL) {
+			fftwf_execute_dft(batch->plan, m_in, m_out);
+			return;
+		}
+	}
+
+	// one frame after the other with the plain plan, the frames keep the alignment of the arrays
+	if(m_currentPlan->deferred)
+		startPlan(m_currentPlan);
+	if(m_currentPlan->patient != NULL)
+		upgrade(m_currentPlan);
+	if(m_currentPlan->plan == NULL) {
+		fallback(m_currentPlan->n, m_currentPlan->inverse, count, stride);
+		return;
+	}
+	for(int i = 0; i < count; i++)
+		fftwf_execute_dft(m_currentPlan->plan, m_in + i * stride, m_out + i * stride);
 }
 
 Complex* FFTWEngine::in()
 {
-	if(m_currentPlan != NULL)
-		return reinterpret_cast<Complex*>(m_currentPlan->in);
-	else return NULL;
+	return reinterpret_cast<Complex*>(m_in);
 }
 
 Complex* FFTWEngine::out()
 {
-	if(m_currentPlan != NULL)
-		return reinterpret_cast<Complex*>(m_currentPlan->out);
-	else return NULL;
+	return reinterpret_cast<Complex*>(m_out);
 }
 
 QMutex FFTWEngine::m_globalPlanMutex;
+bool FFTWEngine::m_initialized = false;
+QMutex FFTWEngine::m_retiredMutex;
+std::vector<fftwf_plan> FFTWEngine::m_retiredPlans;
+
+FFTWEngine::Plan* FFTWEngine::findPlan(int n, bool inverse, int count, int stride)
+{
+	for(Plans::const_iterator it = m_plans.begin(); it != m_plans.end(); ++it) {
+		if(((*it)->n == n) && ((*it)->inverse == inverse) && ((*it)->count == count) && ((*it)->stride == stride))
+			return *it;
+	}
+	return NULL;
+}
+
+FFTWEngine::Plan* FFTWEngine::createPlan(int n, bool inverse, int count, int stride)
+{
+	Plan* plan = new Plan;
+	plan->n = n;
+	plan->inverse = inverse;
+	plan->count = count;
+	plan->stride = stride;
+	plan->plan = NULL;
+	plan->estimate = NULL;
+	plan->patient = NULL;
+	plan->deferred = false;
+	m_plans.push_back(plan);
+
+	startPlan(plan);
+	return plan;
+}
 
+// a single transform gets an estimated plan to start with, a batch runs frame by frame until
+// its patient plan is there. the planner may be busy for seconds with a patient plan of another
+// size - the DSP thread does not wait for it but tries again with the next transform
+void FFTWEngine::startPlan(Plan* plan)
+{
+	if(!m_globalPlanMutex.tryLock()) {
+		if(!plan->deferred)
+			qDebug("FFT: FFTW planner busy, plan (n=%d,%s,%dx) deferred, KissFFT until then", plan->n, plan->inverse ? "inverse" : "forward", plan->count);
+		plan->deferred = true;
+		return;
+	}
+	plan->deferred = false;
+
+	initialize();
+	destroyRetired();
+	QTime t;
+	t.start();
+	// only succeeds when the wisdom already has this size
+	plan->plan = makePlan(plan->n, plan->inverse, plan->count, plan->stride, m_in, m_out, planFlags(plan->n * plan->count) | FFTW_WISDOM_ONLY);
+	if(plan->plan == NULL) {
+		if(plan->count == 1)
+			plan->plan = makePlan(plan->n, plan->inverse, plan->count, plan->stride, m_in, m_out, FFTW_ESTIMATE);
+		plan->patient = new PatientPlan;
+		QThreadPool::globalInstance()->start(new PatientPlanner(plan->n, plan->inverse, plan->count, plan->stride, plan->patient));
+	}
+	m_globalPlanMutex.unlock();
+	qDebug("FFT: creating FFTW plan (n=%d,%s,%dx) took %dms%s", plan->n, plan->inverse ? "inverse" : "forward", plan->count, t.elapsed(),
+		(plan->patient != NULL) ? ", patient plan follows" : "");
+}
+
+// the contents are not kept
+void FFTWEngine::allocate(int size)
+{
+	if(size <= m_size)
+		return;
+	if(m_in != NULL)
+		fftwf_free(m_in);
+	if(m_out != NULL)
+		fftwf_free(m_out);
+	m_in = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * size);
+	m_out = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * size);
+	m_size = size;
+}
+
+// without waiting for a planner that is still running
 void FFTWEngine::freeAll()
 {
 	for(Plans::iterator it = m_plans.begin(); it != m_plans.end(); ++it) {
-		fftwf_destroy_plan((*it)->plan);
-		fftwf_free((*it)->in);
-		fftwf_free((*it)->out);
+		if((*it)->plan != NULL)
+			destroyPlan((*it)->plan);
+		if((*it)->estimate != NULL)
+			destroyPlan((*it)->estimate);
+		// whoever is last frees the patient plan
+		if((*it)->patient != NULL)
+			release((*it)->patient);
 		delete *it;
 	}
 	m_plans.clear();
+	m_currentPlan = NULL;
+	m_batchPlan = NULL;
+
+	if(m_in != NULL)
+		fftwf_free(m_in);
+	if(m_out != NULL)
+		fftwf_free(m_out);
+	m_in = NULL;
+	m_out = NULL;
+	m_size = 0;
+}
+
+// with m_globalPlanMutex held
+fftwf_plan FFTWEngine::makePlan(int n, bool inverse, int count, int stride, fftwf_complex* in, fftwf_complex* out, unsigned flags)
+{
+#if defined(USE_FFTW_THREADS)
+	// below that the threads cost more than they bring
+	fftwf_plan_with_nthreads((n * count >= threadedSize) ? QThread::idealThreadCount() : 1);
+#endif
+	return fftwf_plan_many_dft(1, &n, count, in, NULL, 1, stride, out, NULL, 1, stride, inverse ? FFTW_BACKWARD : FFTW_FORWARD, flags);
+}
+
+// take over the patient plan if it is done, without waiting for the planner
+void FFTWEngine::upgrade(Plan* plan)
+{
+	fftwf_plan patient = plan->patient->plan.fetchAndStoreAcquire(NULL);
+	if(patient != NULL) {
+		plan->estimate = plan->plan;
+		plan->plan = patient;
+		release(plan->patient);
+		plan->patient = NULL;
+	}
+}
+
+void FFTWEngine::release(PatientPlan* patient)
+{
+	if(!patient->refCount.deref()) {
+		fftwf_plan plan = patient->plan.loadAcquire();
+		if(plan != NULL)
+			destroyPlan(plan);
+		delete patient;
+	}
+}
+
+// destroying needs the planner as well. when it is busy the plan is left to whoever has it next
+void FFTWEngine::destroyPlan(fftwf_plan plan)
+{
+	m_retiredMutex.lock();
+	m_retiredPlans.push_back(plan);
+	m_retiredMutex.unlock();
+
+	if(m_globalPlanMutex.tryLock()) {
+		destroyRetired();
+		m_globalPlanMutex.unlock();
+	}
+}
+
+// with m_globalPlanMutex held
+void FFTWEngine::destroyRetired()
+{
+	QMutexLocker mutexLocker(&m_retiredMutex);
+	for(size_t i = 0; i < m_retiredPlans.size(); i++)
+		fftwf_destroy_plan(m_retiredPlans[i]);
+	m_retiredPlans.clear();
+}
+
+// KissFFT on the same arrays for as long as FFTW has no plan for this size
+void FFTWEngine::fallback(int n, bool inverse, int count, int stride)
+{
+	if((m_fallbackSize != n) || (m_fallbackInverse != inverse)) {
+		m_fallback.configure(n, inverse);
+		m_fallbackSize = n;
+		m_fallbackInverse = inverse;
+	}
+
+	const Complex* in = reinterpret_cast<const Complex*>(m_in);
+	Complex* out = reinterpret_cast<Complex*>(m_out);
+	for(int i = 0; i < count; i++)
+		m_fallback.transform(in + i * stride, out + i * stride);
+}
+
+static QString wisdomFileName()
+{
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/fftw-wisdom";
+}
+
+// with m_globalPlanMutex held
+void FFTWEngine::initialize()
+{
+	if(m_initialized)
+		return;
+	m_initialized = true;
+
+#if defined(USE_FFTW_THREADS)
+	// has to come before anything else FFTW does
+	if(!fftwf_init_threads())
+		qWarning("FFT: could not initialize FFTW threads");
+#endif
+
+	QString fileName = wisdomFileName();
+	if(!QFile::exists(fileName))
+		return;
+	if(fftwf_import_wisdom_from_filename(QFile::encodeName(fileName).constData()))
+		qDebug("FFT: loaded FFTW wisdom from %s", qPrintable(fileName));
+	else qWarning("FFT: could not load FFTW wisdom from %s", qPrintable(fileName));
+}
+
+// with m_globalPlanMutex held
+void FFTWEngine::saveWisdom()
+{
+	QString fileName = wisdomFileName();
+	QDir().mkpath(QFileInfo(fileName).path());
+	if(!fftwf_export_wisdom_to_filename(QFile::encodeName(fileName).constData()))
+		qWarning("FFT: could not save FFTW wisdom to %s", qPrintable(fileName));
 }
@@ -16,6 +16,70 @@
 ///////////////////////////////////////////////////////////////////////////////////
 
 #include "dsp/fftwindow.h"
+#include "util/cpufeatures.h"
+
+#if defined(USE_SIMD) && defined(CPUFEATURES_X86)
+#include <emmintrin.h>
+#define FFTWINDOW_USE_SSE2
+#endif
+
+#if defined(CPUFEATURES_NEON)
+#include <arm_neon.h>
+#endif
+
+static void applySampleScalar(const Sample* in, int count, const float* window, Complex* out)
+{
+	for(int i = 0; i < count; i++)
+		out[i] = Complex(in[i].real() * window[2 * i], in[i].imag() * window[2 * i + 1]);
+}
+
+#if defined(FFTWINDOW_USE_SSE2)
+// unpacking a register with itself and shifting right by 16 sign extends without SSE4.1
+static void applySampleSSE2(const Sample* in, int count, const float* window, Complex* out)
+{
+	float* dst = (float*)out;
+
+	int i = 0;
+	for(; i + 4 <= count; i += 4) {
+		__m128i x = _mm_loadu_si128((const __m128i*)(in + i));
+		__m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+		__m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16));
+		_mm_storeu_ps(dst + 2 * i, _mm_mul_ps(lo, _mm_loadu_ps(window + 2 * i)));
+		_mm_storeu_ps(dst + 2 * i + 4, _mm_mul_ps(hi, _mm_loadu_ps(window + 2 * i + 4)));
+	}
+	applySampleScalar(in + i, count - i, window + 2 * i, out + i);
+}
+#endif
+
+#if defined(CPUFEATURES_NEON)
+static void applySampleNEON(const Sample* in, int count, const float* window, Complex* out)
+{
+	float* dst = (float*)out;
+
+	int i = 0;
+	for(; i + 4 <= count; i += 4) {
+		int16x8_t x = vld1q_s16((const qint16*)(in + i));
+		vst1q_f32(dst + 2 * i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), vld1q_f32(window + 2 * i)));
+		vst1q_f32(dst + 2 * i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), vld1q_f32(window + 2 * i + 4)));
+	}
+	applySampleScalar(in + i, count - i, window + 2 * i, out + i);
+}
+#endif
+
+const FFTWindow::SampleKernel FFTWindow::m_sampleKernel = FFTWindow::selectSampleKernel();
+
+FFTWindow::SampleKernel FFTWindow::selectSampleKernel()
+{
+#if defined(FFTWINDOW_USE_SSE2)
+	if(CPUFeatures::has(CPUFeatures::SSE2))
+		return applySampleSSE2;
+#endif
+#if defined(CPUFEATURES_NEON)
+	if(CPUFeatures::has(CPUFeatures::NEON))
+		return applySampleNEON;
+#endif
+	return applySampleScalar;
+}
 
 void FFTWindow::create(Function function, int n)
 {
@@ -52,6 +116,13 @@ void FFTWindow::create(Function function, int n)
 
 	for(int i = 0; i < n; i++)
 		m_window.push_back(wFunc(n, i));
+
+	// 1 / 32768 is a power of two, the int16 path gives the same floats as converting first
+	m_sampleWindow.resize(2 * n);
+	for(int i = 0; i < n; i++) {
+		m_sampleWindow[2 * i] = m_window[i] / 32768.0f;
+		m_sampleWindow[2 * i + 1] = m_window[i] / 32768.0f;
+	}
 }
 
 void FFTWindow::apply(const std::vector<Real>& in, std::vector<Real>* out)
@@ -71,3 +142,8 @@ void FFTWindow::apply(const Complex* in, Complex* out)
 	for(size_t i = 0; i < m_window.size(); i++)
 		out[i] = in[i] * m_window[i];
 }
+
+void FFTWindow::apply(const Sample* in, Complex* out)
+{
+	m_sampleKernel(in, m_window.size(), &m_sampleWindow[0], out);
+}
@@ -0,0 +1,183 @@
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include "dsp/fmdiscriminator.h"
+#include "util/cpufeatures.h"
+
+#if defined(USE_SIMD) && defined(CPUFEATURES_X86)
+#include <emmintrin.h>
+#define FMDISCRIMINATOR_USE_SSE2
+#endif
+
+#if defined(CPUFEATURES_NEON)
+#include <arm_neon.h>
+#endif
+
+// atan(a) / pi for 0 <= a <= 1, odd polynomial
+static const float atanC1 = 0.99997726f / M_PI;
+static const float atanC3 = -0.33262347f / M_PI;
+static const float atanC5 = 0.19354346f / M_PI;
+static const float atanC7 = -0.11643287f / M_PI;
+static const float atanC9 = 0.05265332f / M_PI;
+static const float atanC11 = -0.01172120f / M_PI;
+
+// atan2(y, x) / pi: the smaller of |x|, |y| over the larger, then moved to the right octant
+static inline Real atan2Scaled(Real y, Real x)
+{
+	Real ax = fabsf(x);
+	Real ay = fabsf(y);
+	Real mx = (ax > ay) ? ax : ay;
+	Real mn = (ax > ay) ? ay : ax;
+	Real a = (mx > 0) ? mn / mx : 0;
+	Real s = a * a;
+	Real r = a * (atanC1 + s * (atanC3 + s * (atanC5 + s * (atanC7 + s * (atanC9 + s * atanC11)))));
+
+	if(ay > ax)
+		r = 0.5f - r;
+	if(x < 0)
+		r = 1.0f - r;
+	if(y < 0)
+		r = -r;
+	return r;
+}
+
+static void demodScalar(const Complex* in, int count, Complex* last, Real* out)
+{
+	Real lr = last->real();
+	Real li = last->imag();
+
+	for(int i = 0; i < count; i++) {
+		Real cr = in[i].real();
+		Real ci = in[i].imag();
+		out[i] = atan2Scaled(lr * ci - li * cr, lr * cr + li * ci);
+		lr = cr;
+		li = ci;
+	}
+
+	*last = in[count - 1];
+}
+
+#if defined(FMDISCRIMINATOR_USE_SSE2)
+// four outputs per step, the previous samples are just the input one further back
+static void demodSSE2(const Complex* in, int count, Complex* last, Real* out)
+{
+	demodScalar(in, 1, last, out);
+
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+	const __m128 tiny = _mm_set1_ps(1e-30f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 one = _mm_set1_ps(1.0f);
+	int i = 1;
+
+	for(; i + 4 <= count; i += 4) {
+		const float* cur = (const float*)(in + i);
+		const float* prev = (const float*)(in + i - 1);
+		__m128 c0 = _mm_loadu_ps(cur);
+		__m128 c1 = _mm_loadu_ps(cur + 4);
+		__m128 p0 = _mm_loadu_ps(prev);
+		__m128 p1 = _mm_loadu_ps(prev + 4);
+		__m128 cr = _mm_shuffle_ps(c0, c1, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 ci = _mm_shuffle_ps(c0, c1, _MM_SHUFFLE(3, 1, 3, 1));
+		__m128 pr = _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 pi = _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(3, 1, 3, 1));
+
+		// conj(prev) * cur
+		__m128 x = _mm_add_ps(_mm_mul_ps(pr, cr), _mm_mul_ps(pi, ci));
+		__m128 y = _mm_sub_ps(_mm_mul_ps(pr, ci), _mm_mul_ps(pi, cr));
+
+		__m128 ax = _mm_and_ps(x, absMask);
+		__m128 ay = _mm_and_ps(y, absMask);
+		__m128 a = _mm_div_ps(_mm_min_ps(ax, ay), _mm_max_ps(_mm_max_ps(ax, ay), tiny));
+		__m128 s = _mm_mul_ps(a, a);
+		__m128 r = _mm_add_ps(_mm_mul_ps(s, _mm_set1_ps(atanC11)), _mm_set1_ps(atanC9));
+		r = _mm_add_ps(_mm_mul_ps(s, r), _mm_set1_ps(atanC7));
+		r = _mm_add_ps(_mm_mul_ps(s, r), _mm_set1_ps(atanC5));
+		r = _mm_add_ps(_mm_mul_ps(s, r), _mm_set1_ps(atanC3));
+		r = _mm_add_ps(_mm_mul_ps(s, r), _mm_set1_ps(atanC1));
+		r = _mm_mul_ps(a, r);
+
+		__m128 mask = _mm_cmpgt_ps(ay, ax);
+		r = _mm_or_ps(_mm_and_ps(mask, _mm_sub_ps(half, r)), _mm_andnot_ps(mask, r));
+		mask = _mm_cmplt_ps(x, _mm_setzero_ps());
+		r = _mm_or_ps(_mm_and_ps(mask, _mm_sub_ps(one, r)), _mm_andnot_ps(mask, r));
+		r = _mm_xor_ps(r, _mm_and_ps(y, signMask));
+
+		_mm_storeu_ps(out + i, r);
+	}
+
+	if(i < count) {
+		*last = in[i - 1];
+		demodScalar(in + i, count - i, last, out + i);
+	} else {
+		*last = in[count - 1];
+	}
+}
+#endif
+
+#if defined(CPUFEATURES_NEON)
+static void demodNEON(const Complex* in, int count, Complex* last, Real* out)
+{
+	demodScalar(in, 1, last, out);
+
+	int i = 1;
+
+	for(; i + 4 <= count; i += 4) {
+		float32x4x2_t cur = vld2q_f32((const float*)(in + i));
+		float32x4x2_t prev = vld2q_f32((const float*)(in + i - 1));
+
+		// conj(prev) * cur
+		float32x4_t x = vmlaq_f32(vmulq_f32(prev.val[0], cur.val[0]), prev.val[1], cur.val[1]);
+		float32x4_t y = vmlsq_f32(vmulq_f32(prev.val[0], cur.val[1]), prev.val[1], cur.val[0]);
+
+		float32x4_t ax = vabsq_f32(x);
+		float32x4_t ay = vabsq_f32(y);
+		float32x4_t mx = vmaxq_f32(vmaxq_f32(ax, ay), vdupq_n_f32(1e-30f));
+		// no divide on ARMv7: reciprocal estimate and two Newton steps
+		float32x4_t inv = vrecpeq_f32(mx);
+		inv = vmulq_f32(vrecpsq_f32(mx, inv), inv);
+		inv = vmulq_f32(vrecpsq_f32(mx, inv), inv);
+		float32x4_t a = vmulq_f32(vminq_f32(ax, ay), inv);
+		float32x4_t s = vmulq_f32(a, a);
+		float32x4_t r = vmlaq_n_f32(vdupq_n_f32(atanC9), s, atanC11);
+		r = vmlaq_f32(vdupq_n_f32(atanC7), s, r);
+		r = vmlaq_f32(vdupq_n_f32(atanC5), s, r);
+		r = vmlaq_f32(vdupq_n_f32(atanC3), s, r);
+		r = vmlaq_f32(vdupq_n_f32(atanC1), s, r);
+		r = vmulq_f32(a, r);
+
+		r = vbslq_f32(vcgtq_f32(ay, ax), vsubq_f32(vdupq_n_f32(0.5f), r), r);
+		r = vbslq_f32(vcltq_f32(x, vdupq_n_f32(0.0f)), vsubq_f32(vdupq_n_f32(1.0f), r), r);
+		uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(y), vdupq_n_u32(0x80000000));
+		r = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(r), sign));
+
+		vst1q_f32(out + i, r);
+	}
+
+	if(i < count) {
+		*last = in[i - 1];
+		demodScalar(in + i, count - i, last, out + i);
+	} else {
+		*last = in[count - 1];
+	}
+}
+#endif
+
+const FMDiscriminator::Kernel FMDiscriminator::m_kernel = FMDiscriminator::selectKernel();
+
+FMDiscriminator::Kernel FMDiscriminator::selectKernel()
+{
+#if defined(FMDISCRIMINATOR_USE_SSE2)
+	if(CPUFeatures::has(CPUFeatures::SSE2))
+		return demodSSE2;
+#endif
+#if defined(CPUFEATURES_NEON)
+	if(CPUFeatures::has(CPUFeatures::NEON))
+		return demodNEON;
+#endif
+	return demodScalar;
+}
+
+Real FMDiscriminator::atan2(Real y, Real x)
+{
+	return atan2Scaled(y, x) * M_PI;
+}
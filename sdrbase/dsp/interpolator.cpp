@@ -1,8 +1,22 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 #include <vector>
+#include <algorithm>
 #include "dsp/interpolator.h"
 
+#if defined(USE_SIMD) && defined(CPUFEATURES_X86)
+#include <emmintrin.h>
+#include <immintrin.h>
+#define INTERPOLATOR_USE_SSE2
+#if defined(_MSC_VER) || defined(__clang__) || (__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9))
+#define INTERPOLATOR_USE_AVX
+#endif
+#endif
+
+#if defined(CPUFEATURES_NEON)
+#include <arm_neon.h>
+#endif
+
 static std::vector<Real> createPolyphaseLowPass(
 	int phaseSteps,
 	double gain,
@@ -41,9 +55,103 @@ static std::vector<Real> createPolyphaseLowPass(
 	return taps;
 }
 
+static void filterScalar(const Complex* samples, const int* start, const int* phase, int count, const float* taps, int nTaps, Complex* out)
+{
+	for(int k = 0; k < count; k++) {
+		const Complex* src = samples + start[k];
+		const float* coeff = taps + phase[k] * nTaps * 2;
+		Real rAcc = 0;
+		Real iAcc = 0;
+
+		for(int i = 0; i < nTaps; i++) {
+			rAcc += coeff[2 * i] * src[i].real();
+			iAcc += coeff[2 * i] * src[i].imag();
+		}
+		out[k] = Complex(rAcc, iAcc);
+	}
+}
+
+#if defined(INTERPOLATOR_USE_SSE2)
+// two samples per register against the doubled taps, the halves are added up at the end
+static void filterSSE2(const Complex* samples, const int* start, const int* phase, int count, const float* taps, int nTaps, Complex* out)
+{
+	for(int k = 0; k < count; k++) {
+		const float* src = (const float*)(samples + start[k]);
+		const float* coeff = taps + phase[k] * nTaps * 2;
+		__m128 sum = _mm_setzero_ps();
+
+		for(int i = 0; i < nTaps / 2; i++)
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src + 4 * i), _mm_load_ps(coeff + 4 * i)));
+
+		_mm_storel_pi((__m64*)(out + k), _mm_add_ps(sum, _mm_movehl_ps(sum, sum)));
+	}
+}
+#endif
+
+#if defined(INTERPOLATOR_USE_AVX)
+// four samples per register, the tap count is always even so at most one SSE step is left over
+CPUFEATURES_TARGET("avx")
+static void filterAVX(const Complex* samples, const int* start, const int* phase, int count, const float* taps, int nTaps, Complex* out)
+{
+	for(int k = 0; k < count; k++) {
+		const float* src = (const float*)(samples + start[k]);
+		const float* coeff = taps + phase[k] * nTaps * 2;
+		__m256 sum256 = _mm256_setzero_ps();
+
+		int i = 0;
+		for(; i + 4 <= nTaps; i += 4)
+			sum256 = _mm256_add_ps(sum256, _mm256_mul_ps(_mm256_loadu_ps(src + 2 * i), _mm256_loadu_ps(coeff + 2 * i)));
+
+		__m128 sum = _mm_add_ps(_mm256_castps256_ps128(sum256), _mm256_extractf128_ps(sum256, 1));
+		if(i < nTaps)
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src + 2 * i), _mm_load_ps(coeff + 2 * i)));
+
+		_mm_storel_pi((__m64*)(out + k), _mm_add_ps(sum, _mm_movehl_ps(sum, sum)));
+	}
+}
+#endif
+
+#if defined(CPUFEATURES_NEON)
+static void filterNEON(const Complex* samples, const int* start, const int* phase, int count, const float* taps, int nTaps, Complex* out)
+{
+	for(int k = 0; k < count; k++) {
+		const float* src = (const float*)(samples + start[k]);
+		const float* coeff = taps + phase[k] * nTaps * 2;
+		float32x4_t sum = vdupq_n_f32(0.0f);
+
+		for(int i = 0; i < nTaps / 2; i++)
+			sum = vmlaq_f32(sum, vld1q_f32(src + 4 * i), vld1q_f32(coeff + 4 * i));
+
+		vst1_f32((float*)(out + k), vadd_f32(vget_low_f32(sum), vget_high_f32(sum)));
+	}
+}
+#endif
+
+const Interpolator::Kernel Interpolator::m_kernel = Interpolator::selectKernel();
+
+Interpolator::Kernel Interpolator::selectKernel()
+{
+#if defined(INTERPOLATOR_USE_AVX)
+	if(CPUFeatures::has(CPUFeatures::AVX))
+		return filterAVX;
+#endif
+#if defined(INTERPOLATOR_USE_SSE2)
+	if(CPUFeatures::has(CPUFeatures::SSE2))
+		return filterSSE2;
+#endif
+#if defined(CPUFEATURES_NEON)
+	if(CPUFeatures::has(CPUFeatures::NEON))
+		return filterNEON;
+#endif
+	return filterScalar;
+}
+
 Interpolator::Interpolator() :
 	m_taps(NULL),
-	m_alignedTaps(NULL)
+	m_alignedTaps(NULL),
+	m_end(0),
+	m_phaseSteps(1),
+	m_nTaps(0)
 {
 }
 
@@ -65,12 +173,10 @@ void Interpolator::create(int phaseSteps, double sampleRate, double cutoff)
 		20.0); // out of band attenuation
 
 	// init state
-	m_ptr = 0;
 	m_nTaps = taps.size() / phaseSteps;
 	m_phaseSteps = phaseSteps;
-	m_samples.resize(m_nTaps + 2);
-	for(int i = 0; i < m_nTaps + 2; i++)
-		m_samples[i] = 0;
+	m_samples.assign(2 * m_nTaps, Complex(0, 0));
+	m_end = m_nTaps;
 
 	// reorder into polyphase
 	std::vector<Real> polyphase(taps.size());
@@ -88,22 +194,17 @@ void Interpolator::create(int phaseSteps, double sampleRate, double cutoff)
 			polyphase[i] /= sum;
 	}
 
-	// move taps around to match sse storage requirements
+	// the history runs oldest first, so the taps of each phase are stored backwards - and twice,
+	// to match the I/Q layout of the samples
 	m_taps = new float[2 * taps.size() + 8];
 	for(int i = 0; i < 2 * taps.size() + 8; ++i)
 		m_taps[i] = 0;
 	m_alignedTaps = (float*)((((quint64)m_taps) + 15) & ~15);
-	for(int i = 0; i < taps.size(); ++i) {
-		m_alignedTaps[2 * i + 0] = polyphase[i];
-		m_alignedTaps[2 * i + 1] = polyphase[i];
-	}
-	m_taps2 = new float[2 * taps.size() + 8];
-	for(int i = 0; i < 2 * taps.size() + 8; ++i)
-		m_taps2[i] = 0;
-	m_alignedTaps2 = (float*)((((quint64)m_taps2) + 15) & ~15);
-	for(int i = 1; i < taps.size(); ++i) {
-		m_alignedTaps2[2 * (i - 1) + 0] = polyphase[i];
-		m_alignedTaps2[2 * (i - 1) + 1] = polyphase[i];
+	for(int phase = 0; phase < phaseSteps; phase++) {
+		for(int i = 0; i < m_nTaps; i++) {
+			m_alignedTaps[2 * (phase * m_nTaps + i) + 0] = polyphase[phase * m_nTaps + m_nTaps - 1 - i];
+			m_alignedTaps[2 * (phase * m_nTaps + i) + 1] = polyphase[phase * m_nTaps + m_nTaps - 1 - i];
+		}
 	}
 }
 
@@ -113,8 +214,85 @@ void Interpolator::free()
 		delete[] m_taps;
 		m_taps = NULL;
 		m_alignedTaps = NULL;
-		delete[] m_taps2;
-		m_taps2 = NULL;
-		m_alignedTaps2 = NULL;
 	}
 }
+
+// makes room for count more samples behind the history
+void Interpolator::reserve(int count)
+{
+	if(m_end + count <= (int)m_samples.size())
+		return;
+
+	std::copy(m_samples.begin() + m_end - m_nTaps, m_samples.begin() + m_end, m_samples.begin());
+	m_end = m_nTaps;
+	if(m_end + count > (int)m_samples.size())
+		m_samples.resize(m_end + count);
+}
+
+int Interpolator::resample(Real* distance, Real step, const Complex* in, int count, Complex* out)
+{
+	int maxCount = maxOutput(count, step);
+	if((int)m_start.size() < maxCount) {
+		m_start.resize(maxCount);
+		m_phase.resize(maxCount);
+	}
+
+	// the whole block goes behind the history at once, then the outputs are scheduled
+	reserve(count);
+	std::copy(in, in + count, m_samples.begin() + m_end);
+	int start = m_end - m_nTaps;
+	int end = start + count;
+	int produced = 0;
+
+	Real phaseSteps = m_phaseSteps;
+	Real scaledDistance = *distance * phaseSteps;
+	Real scaledStep = step * phaseSteps;
+
+	if(((m_phaseSteps & (m_phaseSteps - 1)) == 0) && (scaledStep == floor(scaledStep)) &&
+		(scaledDistance == floor(scaledDistance)) && (scaledStep > 0) && (scaledStep < (1 << 20))) {
+		// rational ratio - distance is a whole number of phase steps, count in integers.
+		// the power of two phase count keeps every intermediate exact in float as well
+		int d = (int)scaledDistance;
+		int s = (int)scaledStep;
+		for(;;) {
+			while(d >= m_phaseSteps) {
+				if(start == end)
+					goto done;
+				start++;
+				d -= m_phaseSteps;
+			}
+			if(produced >= maxCount)
+				break;
+			m_start[produced] = start;
+			m_phase[produced] = d;
+			produced++;
+			d += s;
+		}
+	done:
+		*distance = d / phaseSteps;
+	} else {
+		// the same arithmetic interpolate() does for every sample
+		Real d = *distance;
+		for(;;) {
+			while(d >= 1.0) {
+				if(start == end)
+					goto doneFractional;
+				start++;
+				d -= 1.0;
+			}
+			if(produced >= maxCount)
+				break;
+			m_start[produced] = start;
+			m_phase[produced] = (int)floor(d * phaseSteps);
+			produced++;
+			d += step;
+		}
+	doneFractional:
+		*distance = d;
+	}
+
+	m_kernel(&m_samples[0], &m_start[0], &m_phase[0], produced, m_alignedTaps, m_nTaps, out);
+	m_end += count;
+
+	return produced;
+}
@@ -1,11 +1,337 @@
+#include <algorithm>
 #include "dsp/inthalfbandfilter.h"
+#include "dsp/sampleconverter.h"
+#include "util/cpufeatures.h"
+
+#if defined(USE_SIMD) && defined(CPUFEATURES_X86)
+#include <emmintrin.h>
+#include <immintrin.h>
+#define HB_USE_SSE2
+#if ((HB_EVENTAPS % 16) == 0) && (defined(_MSC_VER) || defined(__clang__) || (__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9)))
+#define HB_USE_AVX2
+#endif
+#endif
+
+#if defined(CPUFEATURES_NEON)
+#include <arm_neon.h>
+#endif
+
+static inline void storeResult(Sample* out, qint32 iAcc, qint32 qAcc)
+{
+	out->setReal((iAcc + (qint32)(0.5 * (1 << HB_SHIFT))) >> HB_SHIFT);
+	out->setImag((qAcc + (qint32)(0.5 * (1 << HB_SHIFT))) >> HB_SHIFT);
+}
+
+static void firScalar(const Sample* even, const Sample* odd, int count, Sample* out)
+{
+	for(int j = 0; j < count; j++) {
+		const Sample* samples = even + j + 1;
+		qint32 iAcc = 0;
+		qint32 qAcc = 0;
+
+		for(int i = 0; i < HB_FILTERORDER / 4; i++) {
+			iAcc += (samples[i].real() + samples[HB_EVENTAPS - 1 - i].real()) * HB_COEFF[i];
+			qAcc += (samples[i].imag() + samples[HB_EVENTAPS - 1 - i].imag()) * HB_COEFF[i];
+		}
+
+		iAcc += odd[j].real() * (qint32)(0.5 * (1 << HB_SHIFT));
+		qAcc += odd[j].imag() * (qint32)(0.5 * (1 << HB_SHIFT));
+		storeResult(out + j, iAcc, qAcc);
+	}
+}
+
+#if defined(HB_USE_SSE2)
+// four samples per register: the one from the far end is reversed (pshufd) and interleaved with
+// the near one, pmaddwd then does two tap pairs at once - the 32 bit products and sums are exact
+static void firSSE2(const Sample* even, const Sample* odd, int count, Sample* out)
+{
+	__m128i coeff[HB_EVENTAPS / 4];
+	for(int k = 0; k < HB_EVENTAPS / 4; k++)
+		coeff[k] = _mm_set_epi16(HB_COEFF[2 * k + 1], HB_COEFF[2 * k + 1], HB_COEFF[2 * k + 1], HB_COEFF[2 * k + 1],
+			HB_COEFF[2 * k], HB_COEFF[2 * k], HB_COEFF[2 * k], HB_COEFF[2 * k]);
+
+	for(int j = 0; j < count; j++) {
+		const __m128i* s = (const __m128i*)(even + j + 1);
+		__m128i acc = _mm_setzero_si128();
+
+		for(int k = 0; k < HB_EVENTAPS / 8; k++) {
+			__m128i near = _mm_loadu_si128(s + k);
+			__m128i far = _mm_shuffle_epi32(_mm_loadu_si128(s + HB_EVENTAPS / 4 - 1 - k), _MM_SHUFFLE(0, 1, 2, 3));
+			acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi16(near, far), coeff[2 * k]));
+			acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpackhi_epi16(near, far), coeff[2 * k + 1]));
+		}
+
+		// lanes are I, Q, I, Q
+		acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+		qint32 iAcc = _mm_cvtsi128_si32(acc) + odd[j].real() * (qint32)(0.5 * (1 << HB_SHIFT));
+		qint32 qAcc = _mm_cvtsi128_si32(_mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 1, 1, 1))) + odd[j].imag() * (qint32)(0.5 * (1 << HB_SHIFT));
+		storeResult(out + j, iAcc, qAcc);
+	}
+}
+#endif
+
+#if defined(HB_USE_AVX2)
+// same as SSE2 with eight samples per register, the unpacking works per 128 bit lane
+CPUFEATURES_TARGET("avx2")
+static void firAVX2(const Sample* even, const Sample* odd, int count, Sample* out)
+{
+	const __m256i reverse = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i coeff[HB_EVENTAPS / 8];
+	for(int k = 0; k < HB_EVENTAPS / 16; k++) {
+		// low lane: pairs 8k...8k+3, high lane: pairs 8k+4...8k+7
+		coeff[2 * k] = _mm256_set_epi16(HB_COEFF[8 * k + 5], HB_COEFF[8 * k + 5], HB_COEFF[8 * k + 5], HB_COEFF[8 * k + 5],
+			HB_COEFF[8 * k + 4], HB_COEFF[8 * k + 4], HB_COEFF[8 * k + 4], HB_COEFF[8 * k + 4],
+			HB_COEFF[8 * k + 1], HB_COEFF[8 * k + 1], HB_COEFF[8 * k + 1], HB_COEFF[8 * k + 1],
+			HB_COEFF[8 * k], HB_COEFF[8 * k], HB_COEFF[8 * k], HB_COEFF[8 * k]);
+		coeff[2 * k + 1] = _mm256_set_epi16(HB_COEFF[8 * k + 7], HB_COEFF[8 * k + 7], HB_COEFF[8 * k + 7], HB_COEFF[8 * k + 7],
+			HB_COEFF[8 * k + 6], HB_COEFF[8 * k + 6], HB_COEFF[8 * k + 6], HB_COEFF[8 * k + 6],
+			HB_COEFF[8 * k + 3], HB_COEFF[8 * k + 3], HB_COEFF[8 * k + 3], HB_COEFF[8 * k + 3],
+			HB_COEFF[8 * k + 2], HB_COEFF[8 * k + 2], HB_COEFF[8 * k + 2], HB_COEFF[8 * k + 2]);
+	}
+
+	for(int j = 0; j < count; j++) {
+		const __m256i* s = (const __m256i*)(even + j + 1);
+		__m256i acc = _mm256_setzero_si256();
+
+		for(int k = 0; k < HB_EVENTAPS / 16; k++) {
+			__m256i near = _mm256_loadu_si256(s + k);
+			__m256i far = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(s + HB_EVENTAPS / 8 - 1 - k), reverse);
+			acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_unpacklo_epi16(near, far), coeff[2 * k]));
+			acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_unpackhi_epi16(near, far), coeff[2 * k + 1]));
+		}
+
+		__m128i acc128 = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+		acc128 = _mm_add_epi32(acc128, _mm_shuffle_epi32(acc128, _MM_SHUFFLE(1, 0, 3, 2)));
+		qint32 iAcc = _mm_cvtsi128_si32(acc128) + odd[j].real() * (qint32)(0.5 * (1 << HB_SHIFT));
+		qint32 qAcc = _mm_cvtsi128_si32(_mm_shuffle_epi32(acc128, _MM_SHUFFLE(1, 1, 1, 1))) + odd[j].imag() * (qint32)(0.5 * (1 << HB_SHIFT));
+		storeResult(out + j, iAcc, qAcc);
+	}
+}
+#endif
+
+#if defined(CPUFEATURES_NEON)
+// two tap pairs per step: widening add of the samples, then a 32 bit multiply-accumulate
+static void firNEON(const Sample* even, const Sample* odd, int count, Sample* out)
+{
+	for(int j = 0; j < count; j++) {
+		const qint16* s = (const qint16*)(even + j + 1);
+		int32x4_t acc = vdupq_n_s32(0);
+
+		for(int k = 0; k < HB_EVENTAPS / 4; k++) {
+			int16x4_t near = vld1_s16(s + 4 * k);
+			// the two samples at the far end in reverse order
+			int16x4_t far = vreinterpret_s16_s32(vrev64_s32(vreinterpret_s32_s16(vld1_s16(s + 2 * (HB_EVENTAPS - 2 - 2 * k)))));
+			int32x4_t coeff = vcombine_s32(vdup_n_s32(HB_COEFF[2 * k]), vdup_n_s32(HB_COEFF[2 * k + 1]));
+			acc = vmlaq_s32(acc, vaddl_s16(near, far), coeff);
+		}
+
+		int32x2_t sum = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+		qint32 iAcc = vget_lane_s32(sum, 0) + odd[j].real() * (qint32)(0.5 * (1 << HB_SHIFT));
+		qint32 qAcc = vget_lane_s32(sum, 1) + odd[j].imag() * (qint32)(0.5 * (1 << HB_SHIFT));
+		storeResult(out + j, iAcc, qAcc);
+	}
+}
+#endif
+
+IntHalfbandFilter::FIRKernel IntHalfbandFilter::selectKernel()
+{
+#if defined(HB_USE_AVX2)
+	if(CPUFeatures::has(CPUFeatures::AVX2))
+		return firAVX2;
+#endif
+#if defined(HB_USE_SSE2)
+	if(CPUFeatures::has(CPUFeatures::SSE2))
+		return firSSE2;
+#endif
+#if defined(CPUFEATURES_NEON)
+	if(CPUFeatures::has(CPUFeatures::NEON))
+		return firNEON;
+#endif
+	return firScalar;
+}
 
 IntHalfbandFilter::IntHalfbandFilter()
 {
-	for(int i = 0; i < HB_FILTERORDER + 1; i++) {
-		m_samples[i][0] = 0;
-		m_samples[i][1] = 0;
+	for(int i = 0; i < 2 * HB_EVENTAPS; i++) {
+		m_even[i][0] = 0;
+		m_even[i][1] = 0;
+	}
+	for(int i = 0; i < HB_CENTERDELAY; i++) {
+		m_odd[i][0] = 0;
+		m_odd[i][1] = 0;
 	}
-	m_ptr = 0;
+	m_evenPtr = 0;
+	m_oddPtr = 0;
 	m_state = 0;
+	m_firKernel = selectKernel();
+}
+
+void IntHalfbandFilter::beginBlock()
+{
+	for(int i = 0; i < HB_EVENTAPS; i++)
+		m_evenBlock[i] = Sample(m_even[m_evenPtr + i][0], m_even[m_evenPtr + i][1]);
+	for(int i = 0; i < HB_CENTERDELAY; i++) {
+		int ptr = (m_oddPtr + i) % HB_CENTERDELAY;
+		m_oddBlock[i] = Sample(m_odd[ptr][0], m_odd[ptr][1]);
+	}
+}
+
+void IntHalfbandFilter::endBlock(int count)
+{
+	for(int i = 0; i < HB_EVENTAPS; i++) {
+		m_even[i][0] = m_even[i + HB_EVENTAPS][0] = m_evenBlock[count + i].real();
+		m_even[i][1] = m_even[i + HB_EVENTAPS][1] = m_evenBlock[count + i].imag();
+	}
+	for(int i = 0; i < HB_CENTERDELAY; i++) {
+		m_odd[i][0] = m_oddBlock[count + i].real();
+		m_odd[i][1] = m_oddBlock[count + i].imag();
+	}
+	m_evenPtr = 0;
+	m_oddPtr = 0;
+}
+
+int IntHalfbandFilter::decimateCenter(const Sample* in, int count, Sample* out)
+{
+	Sample* o = out;
+	int i = 0;
+
+	// finish an odd sample left over from the last block
+	if((count > 0) && (m_state != 0)) {
+		Sample s(in[i++]);
+		if(workDecimateCenter(&s))
+			*o++ = s;
+	}
+
+	// split the input into the samples for the odd taps and the center tap, then filter the lot
+	while(count - i >= 2) {
+		int n = std::min((count - i) / 2, (int)BlockSize);
+		Sample* even = m_evenBlock + HB_EVENTAPS;
+		Sample* odd = m_oddBlock + HB_CENTERDELAY;
+
+		beginBlock();
+		for(int j = 0; j < n; j++, i += 2) {
+			even[j] = in[i];
+			odd[j] = in[i + 1];
+		}
+		m_firKernel(m_evenBlock, m_oddBlock, n, o);
+		endBlock(n);
+		o += n;
+	}
+
+	if(i < count) {
+		Sample s(in[i]);
+		if(workDecimateCenter(&s))
+			*o++ = s;
+	}
+
+	return o - out;
+}
+
+int IntHalfbandFilter::decimateCenterU8(const quint8* in, int count, Sample* out)
+{
+	Sample* o = out;
+	int i = 0;
+
+	if((count > 0) && (m_state != 0)) {
+		Sample s(SampleConverter::fromU8(in + 2 * i++));
+		if(workDecimateCenter(&s))
+			*o++ = s;
+	}
+
+	while(count - i >= 2) {
+		int n = std::min((count - i) / 2, (int)BlockSize);
+
+		beginBlock();
+		SampleConverter::deinterleaveU8(in + 2 * i, n, m_evenBlock + HB_EVENTAPS, m_oddBlock + HB_CENTERDELAY);
+		i += 2 * n;
+		m_firKernel(m_evenBlock, m_oddBlock, n, o);
+		endBlock(n);
+		o += n;
+	}
+
+	if(i < count) {
+		Sample s(SampleConverter::fromU8(in + 2 * i));
+		if(workDecimateCenter(&s))
+			*o++ = s;
+	}
+
+	return o - out;
+}
+
+int IntHalfbandFilter::decimateLowerHalf(const Sample* in, int count, Sample* out)
+{
+	Sample* o = out;
+	int i = 0;
+
+	// get back to the start of the rotation cycle
+	while((i < count) && (m_state != 0)) {
+		Sample s(in[i++]);
+		if(workDecimateLowerHalf(&s))
+			*o++ = s;
+	}
+
+	// one full rotation (by +1/4 per sample) per two output samples
+	while(count - i >= 4) {
+		int n = std::min((count - i) / 4 * 2, (int)BlockSize);
+		Sample* even = m_evenBlock + HB_EVENTAPS;
+		Sample* odd = m_oddBlock + HB_CENTERDELAY;
+
+		beginBlock();
+		for(int j = 0; j < n; j += 2, i += 4) {
+			even[j] = Sample(-in[i].imag(), in[i].real());
+			odd[j] = Sample(-in[i + 1].real(), -in[i + 1].imag());
+			even[j + 1] = Sample(in[i + 2].imag(), -in[i + 2].real());
+			odd[j + 1] = in[i + 3];
+		}
+		m_firKernel(m_evenBlock, m_oddBlock, n, o);
+		endBlock(n);
+		o += n;
+	}
+
+	while(i < count) {
+		Sample s(in[i++]);
+		if(workDecimateLowerHalf(&s))
+			*o++ = s;
+	}
+
+	return o - out;
+}
+
+int IntHalfbandFilter::decimateUpperHalf(const Sample* in, int count, Sample* out)
+{
+	Sample* o = out;
+	int i = 0;
+
+	// get back to the start of the rotation cycle
+	while((i < count) && (m_state != 0)) {
+		Sample s(in[i++]);
+		if(workDecimateUpperHalf(&s))
+			*o++ = s;
+	}
+
+	// one full rotation (by -1/4 per sample) per two output samples
+	while(count - i >= 4) {
+		int n = std::min((count - i) / 4 * 2, (int)BlockSize);
+		Sample* even = m_evenBlock + HB_EVENTAPS;
+		Sample* odd = m_oddBlock + HB_CENTERDELAY;
+
+		beginBlock();
+		for(int j = 0; j < n; j += 2, i += 4) {
+			even[j] = Sample(in[i].imag(), -in[i].real());
+			odd[j] = Sample(-in[i + 1].real(), -in[i + 1].imag());
+			even[j + 1] = Sample(-in[i + 2].imag(), in[i + 2].real());
+			odd[j + 1] = in[i + 3];
+		}
+		m_firKernel(m_evenBlock, m_oddBlock, n, o);
+		endBlock(n);
+		o += n;
+	}
+
+	while(i < count) {
+		Sample s(in[i++]);
+		if(workDecimateUpperHalf(&s))
+			*o++ = s;
+	}
+
+	return o - out;
 }
@@ -0,0 +1,235 @@
+#include <math.h>
+#include "dsp/iqcorrection.h"
+#include "util/cpufeatures.h"
+
+#if defined(USE_SIMD) && defined(CPUFEATURES_X86)
+#include <emmintrin.h>
+#define IQ_USE_SSE2
+#endif
+
+#if defined(CPUFEATURES_NEON)
+#include <arm_neon.h>
+#endif
+
+static inline FixReal saturate(float v)
+{
+	return qBound(-32768L, lrintf(v), 32767L);
+}
+
+static void correctScalar(Sample* samples, int count, const IQCorrection::Correction& correction, IQCorrection::Statistics* statistics)
+{
+	IQCorrection::Statistics s = *statistics;
+
+	for(int j = 0; j < count; j++) {
+		float i = samples[j].real();
+		float q = samples[j].imag();
+		s.m_i += i;
+		s.m_q += q;
+		s.m_ii += i * i;
+		s.m_qq += q * q;
+		s.m_iq += i * q;
+
+		i -= correction.m_iOffset;
+		q -= correction.m_qOffset;
+		samples[j].setReal(saturate(i));
+		samples[j].setImag(saturate(q * correction.m_gain + i * correction.m_cross));
+	}
+
+	*statistics = s;
+}
+
+#if defined(IQ_USE_SSE2)
+// four samples per step, lanes are I, Q, I, Q - the swapped copy puts I next to Q for the
+// cross terms. cvtps2dq rounds like lrintf() and packssdw saturates, so the scalar tail matches
+static void correctSSE2(Sample* samples, int count, const IQCorrection::Correction& correction, IQCorrection::Statistics* statistics)
+{
+	const __m128 offset = _mm_set_ps(correction.m_qOffset, correction.m_iOffset, correction.m_qOffset, correction.m_iOffset);
+	const __m128 gain = _mm_set_ps(correction.m_gain, 1.0f, correction.m_gain, 1.0f);
+	const __m128 cross = _mm_set_ps(correction.m_cross, 0.0f, correction.m_cross, 0.0f);
+	__m128 sum = _mm_setzero_ps();
+	__m128 sumSquares = _mm_setzero_ps();
+	__m128 sumCross = _mm_setzero_ps();
+
+	int j = 0;
+	for(; j + 4 <= count; j += 4) {
+		__m128i x = _mm_loadu_si128((const __m128i*)(samples + j));
+		__m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+		__m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16));
+		__m128 loSwapped = _mm_shuffle_ps(lo, lo, _MM_SHUFFLE(2, 3, 0, 1));
+		__m128 hiSwapped = _mm_shuffle_ps(hi, hi, _MM_SHUFFLE(2, 3, 0, 1));
+
+		sum = _mm_add_ps(sum, _mm_add_ps(lo, hi));
+		sumSquares = _mm_add_ps(sumSquares, _mm_add_ps(_mm_mul_ps(lo, lo), _mm_mul_ps(hi, hi)));
+		sumCross = _mm_add_ps(sumCross, _mm_add_ps(_mm_mul_ps(lo, loSwapped), _mm_mul_ps(hi, hiSwapped)));
+
+		lo = _mm_sub_ps(lo, offset);
+		hi = _mm_sub_ps(hi, offset);
+		loSwapped = _mm_shuffle_ps(lo, lo, _MM_SHUFFLE(2, 3, 0, 1));
+		hiSwapped = _mm_shuffle_ps(hi, hi, _MM_SHUFFLE(2, 3, 0, 1));
+		lo = _mm_add_ps(_mm_mul_ps(lo, gain), _mm_mul_ps(loSwapped, cross));
+		hi = _mm_add_ps(_mm_mul_ps(hi, gain), _mm_mul_ps(hiSwapped, cross));
+		_mm_storeu_si128((__m128i*)(samples + j), _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi)));
+	}
+
+	float s[4];
+	_mm_storeu_ps(s, sum);
+	statistics->m_i += s[0] + s[2];
+	statistics->m_q += s[1] + s[3];
+	_mm_storeu_ps(s, sumSquares);
+	statistics->m_ii += s[0] + s[2];
+	statistics->m_qq += s[1] + s[3];
+	// I * Q shows up in every lane
+	_mm_storeu_ps(s, sumCross);
+	statistics->m_iq += s[0] + s[2];
+
+	correctScalar(samples + j, count - j, correction, statistics);
+}
+#endif
+
+#if defined(CPUFEATURES_NEON)
+// vld2 deinterleaves, so I and Q end up in separate registers and no shuffling is needed
+static void correctNEON(Sample* samples, int count, const IQCorrection::Correction& correction, IQCorrection::Statistics* statistics)
+{
+	const float32x4_t iOffset = vdupq_n_f32(correction.m_iOffset);
+	const float32x4_t qOffset = vdupq_n_f32(correction.m_qOffset);
+	const float32x4_t half = vdupq_n_f32(0.5f);
+	float32x4_t sumI = vdupq_n_f32(0.0f);
+	float32x4_t sumQ = vdupq_n_f32(0.0f);
+	float32x4_t sumII = vdupq_n_f32(0.0f);
+	float32x4_t sumQQ = vdupq_n_f32(0.0f);
+	float32x4_t sumIQ = vdupq_n_f32(0.0f);
+
+	int j = 0;
+	for(; j + 4 <= count; j += 4) {
+		int16x4x2_t x = vld2_s16((const qint16*)(samples + j));
+		float32x4_t i = vcvtq_f32_s32(vmovl_s16(x.val[0]));
+		float32x4_t q = vcvtq_f32_s32(vmovl_s16(x.val[1]));
+
+		sumI = vaddq_f32(sumI, i);
+		sumQ = vaddq_f32(sumQ, q);
+		sumII = vmlaq_f32(sumII, i, i);
+		sumQQ = vmlaq_f32(sumQQ, q, q);
+		sumIQ = vmlaq_f32(sumIQ, i, q);
+
+		i = vsubq_f32(i, iOffset);
+		q = vsubq_f32(q, qOffset);
+		q = vmlaq_n_f32(vmulq_n_f32(q, correction.m_gain), i, correction.m_cross);
+		// vcvtq truncates - round half away from zero instead
+		i = vaddq_f32(i, vbslq_f32(vcltq_f32(i, vdupq_n_f32(0.0f)), vnegq_f32(half), half));
+		q = vaddq_f32(q, vbslq_f32(vcltq_f32(q, vdupq_n_f32(0.0f)), vnegq_f32(half), half));
+		int16x4x2_t y;
+		y.val[0] = vqmovn_s32(vcvtq_s32_f32(i));
+		y.val[1] = vqmovn_s32(vcvtq_s32_f32(q));
+		vst2_s16((qint16*)(samples + j), y);
+	}
+
+	statistics->m_i += vgetq_lane_f32(sumI, 0) + vgetq_lane_f32(sumI, 1) + vgetq_lane_f32(sumI, 2) + vgetq_lane_f32(sumI, 3);
+	statistics->m_q += vgetq_lane_f32(sumQ, 0) + vgetq_lane_f32(sumQ, 1) + vgetq_lane_f32(sumQ, 2) + vgetq_lane_f32(sumQ, 3);
+	statistics->m_ii += vgetq_lane_f32(sumII, 0) + vgetq_lane_f32(sumII, 1) + vgetq_lane_f32(sumII, 2) + vgetq_lane_f32(sumII, 3);
+	statistics->m_qq += vgetq_lane_f32(sumQQ, 0) + vgetq_lane_f32(sumQQ, 1) + vgetq_lane_f32(sumQQ, 2) + vgetq_lane_f32(sumQQ, 3);
+	statistics->m_iq += vgetq_lane_f32(sumIQ, 0) + vgetq_lane_f32(sumIQ, 1) + vgetq_lane_f32(sumIQ, 2) + vgetq_lane_f32(sumIQ, 3);
+
+	correctScalar(samples + j, count - j, correction, statistics);
+}
+#endif
+
+IQCorrection::Kernel IQCorrection::selectKernel()
+{
+#if defined(IQ_USE_SSE2)
+	if(CPUFeatures::has(CPUFeatures::SSE2))
+		return correctSSE2;
+#endif
+#if defined(CPUFEATURES_NEON)
+	if(CPUFeatures::has(CPUFeatures::NEON))
+		return correctNEON;
+#endif
+	return correctScalar;
+}
+
+IQCorrection::IQCorrection() :
+	m_dcOffsetCorrection(false),
+	m_iqImbalanceCorrection(false),
+	m_kernel(selectKernel())
+{
+	reset();
+}
+
+void IQCorrection::configure(bool dcOffsetCorrection, bool iqImbalanceCorrection)
+{
+	if((dcOffsetCorrection == m_dcOffsetCorrection) && (iqImbalanceCorrection == m_iqImbalanceCorrection))
+		return;
+
+	m_dcOffsetCorrection = dcOffsetCorrection;
+	m_iqImbalanceCorrection = iqImbalanceCorrection;
+	reset();
+}
+
+void IQCorrection::reset()
+{
+	m_iMean = 0;
+	m_qMean = 0;
+	m_iVariance = 0;
+	m_qVariance = 0;
+	m_covariance = 0;
+	updateCorrection();
+}
+
+void IQCorrection::process(Sample* samples, int count)
+{
+	if(count <= 0)
+		return;
+
+	double i = 0;
+	double q = 0;
+	double ii = 0;
+	double qq = 0;
+	double iq = 0;
+
+	for(int done = 0; done < count; done += ChunkSize) {
+		Statistics statistics = { 0, 0, 0, 0, 0 };
+		m_kernel(samples + done, qMin(count - done, (int)ChunkSize), m_correction, &statistics);
+		i += statistics.m_i;
+		q += statistics.m_q;
+		ii += statistics.m_ii;
+		qq += statistics.m_qq;
+		iq += statistics.m_iq;
+	}
+
+	i /= count;
+	q /= count;
+
+	// the time constants are in samples, so the smoothing does not depend on the block size
+	double dcAlpha = 1.0 - exp(-(double)count / DCTimeConstant);
+	m_iMean += dcAlpha * (i - m_iMean);
+	m_qMean += dcAlpha * (q - m_qMean);
+
+	double imbalanceAlpha = 1.0 - exp(-(double)count / ImbalanceTimeConstant);
+	m_iVariance += imbalanceAlpha * (ii / count - i * i - m_iVariance);
+	m_qVariance += imbalanceAlpha * (qq / count - q * q - m_qVariance);
+	m_covariance += imbalanceAlpha * (iq / count - i * q - m_covariance);
+
+	updateCorrection();
+}
+
+void IQCorrection::updateCorrection()
+{
+	m_correction.m_iOffset = 0;
+	m_correction.m_qOffset = 0;
+	m_correction.m_gain = 1;
+	m_correction.m_cross = 0;
+
+	if(m_dcOffsetCorrection) {
+		m_correction.m_iOffset = m_iMean;
+		m_correction.m_qOffset = m_qMean;
+	}
+
+	// I = a cos(t), Q = b sin(t + phi) gives var(I) = a^2 / 2, var(Q) = b^2 / 2 and
+	// cov(I, Q) = a b sin(phi) / 2 - then a sin(t) = (Q a / b - I sin(phi)) / cos(phi)
+	if(m_iqImbalanceCorrection && (m_iVariance > 0) && (m_qVariance > 0)) {
+		double sinPhi = m_covariance / sqrt(m_iVariance * m_qVariance);
+		sinPhi = qBound(-0.5, sinPhi, 0.5);
+		double cosPhi = sqrt(1.0 - sinPhi * sinPhi);
+		m_correction.m_gain = sqrt(m_iVariance / m_qVariance) / cosPhi;
+		m_correction.m_cross = -sinPhi / cosPhi;
+	}
+}
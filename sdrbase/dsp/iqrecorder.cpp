@@ -0,0 +1,328 @@
+#include <string.h>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include "dsp/iqrecorder.h"
+#include "dsp/dspcommands.h"
+#include "util/messagequeue.h"
+
+#if defined(Q_OS_LINUX)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+class IQRecorderWriter : public QThread {
+public:
+	IQRecorderWriter(IQRecorder* recorder) : m_recorder(recorder) { }
+
+protected:
+	void run() { m_recorder->writeBuffers(); }
+
+private:
+	IQRecorder* m_recorder;
+};
+
+IQRecorder::IQRecorder(MessageQueue* reportQueue) :
+	m_reportQueue(reportQueue),
+	m_sampleRate(0),
+	m_frequencyOffset(0),
+	m_stopWriter(false),
+	m_writeError(false),
+	m_writer(NULL),
+	m_current(NULL),
+	m_samplesQueued(0),
+	m_centerFrequency(0),
+	m_droppedBuffers(0)
+{
+}
+
+IQRecorder::~IQRecorder()
+{
+	stopRecording();
+}
+
+void IQRecorder::configure(MessageQueue* msgQueue, const QString& fileName, quint64 centerFrequency, bool directIO)
+{
+	Message* cmd = DSPConfigureIQRecorder::create(fileName, centerFrequency, directIO);
+	cmd->submit(msgQueue, this);
+}
+
+bool IQRecorder::startRecording(const QString& fileName, int sampleRate, quint64 centerFrequency, bool directIO)
+{
+	stopRecording();
+
+	QString baseName = fileName;
+	if(baseName.endsWith(".sigmf-data") || baseName.endsWith(".sigmf-meta"))
+		baseName.chop(11);
+
+	if(!openDataFile(baseName + ".sigmf-data", directIO)) {
+		qCritical("IQRecorder: could not create %s.sigmf-data: %s", qPrintable(baseName), qPrintable(m_file.errorString()));
+		return false;
+	}
+	m_fileName = fileName;
+	m_metaFileName = baseName + ".sigmf-meta";
+
+	// the pool is allocated with the first recording and kept
+	if(m_buffers.empty()) {
+		m_memory.resize(BufferCount * BufferSize + Alignment);
+		char* base = &m_memory[0] + (Alignment - ((quintptr)&m_memory[0] % Alignment)) % Alignment;
+		m_buffers.resize(BufferCount);
+		for(int i = 0; i < BufferCount; i++)
+			m_buffers[i].m_data = base + i * BufferSize;
+	}
+	m_freeBuffers.clear();
+	m_fullBuffers.clear();
+	for(int i = 0; i < BufferCount; i++) {
+		m_buffers[i].m_fill = 0;
+		m_freeBuffers.enqueue(&m_buffers[i]);
+	}
+	m_current = m_freeBuffers.dequeue();
+	m_stopWriter = false;
+	m_writeError = false;
+
+	m_sampleRate = sampleRate;
+	m_centerFrequency = centerFrequency;
+	m_samplesQueued = 0;
+	m_droppedBuffers = 0;
+	m_captures.clear();
+	Capture capture = { 0, m_centerFrequency + m_frequencyOffset, QDateTime::currentDateTimeUtc() };
+	m_captures.push_back(capture);
+
+	// written right away as well, so an aborted recording is still usable
+	writeMeta();
+
+	m_writer = new IQRecorderWriter(this);
+	m_writer->start();
+
+	qDebug("IQRecorder: recording to %s", qPrintable(baseName));
+	return true;
+}
+
+void IQRecorder::stopRecording()
+{
+	if(m_current == NULL)
+		return;
+
+	m_mutex.lock();
+	m_stopWriter = true;
+	m_bufferQueued.wakeAll();
+	m_mutex.unlock();
+	m_writer->wait();
+	delete m_writer;
+	m_writer = NULL;
+
+	writeTail();
+	m_samplesQueued += m_current->m_fill / sizeof(Sample);
+	m_current = NULL;
+	m_file.close();
+	writeMeta();
+
+	qDebug("IQRecorder: stopped after %lld samples, %d buffers dropped", m_samplesQueued, m_droppedBuffers.load());
+}
+
+void IQRecorder::setCenterFrequency(quint64 centerFrequency)
+{
+	if(centerFrequency == m_centerFrequency)
+		return;
+	m_centerFrequency = centerFrequency;
+	if(m_current == NULL)
+		return;
+
+	Capture capture = { m_samplesQueued + m_current->m_fill / (int)sizeof(Sample), m_centerFrequency + m_frequencyOffset, QDateTime::currentDateTimeUtc() };
+	if(m_captures.back().m_sampleStart == capture.m_sampleStart)
+		m_captures.back() = capture;
+	else m_captures.push_back(capture);
+}
+
+void IQRecorder::feed(SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst)
+{
+	Q_UNUSED(firstOfBurst);
+
+	if((m_current == NULL) || (begin >= end))
+		return;
+
+	const char* src = (const char*)&*begin;
+	qint64 bytes = (end - begin) * sizeof(Sample);
+
+	while(bytes > 0) {
+		int count = qMin(bytes, (qint64)(BufferSize - m_current->m_fill));
+		memcpy(m_current->m_data + m_current->m_fill, src, count);
+		m_current->m_fill += count;
+		src += count;
+		bytes -= count;
+		if(m_current->m_fill == BufferSize)
+			queueBuffer();
+	}
+}
+
+void IQRecorder::start()
+{
+}
+
+void IQRecorder::stop()
+{
+	stopRecording();
+}
+
+bool IQRecorder::handleMessage(Message* cmd)
+{
+	if(DSPSignalNotification::match(cmd)) {
+		DSPSignalNotification* signal = (DSPSignalNotification*)cmd;
+		// SigMF knows only one sample rate per recording
+		if((m_current != NULL) && (signal->getSampleRate() != m_sampleRate)) {
+			qDebug("IQRecorder: sample rate changed, recording stopped");
+			stopRecording();
+			m_stoppedFileName = m_fileName;
+			if(m_reportQueue != NULL) {
+				Message* rep = DSPIQRecorderStopped::create(m_fileName);
+				rep->submit(m_reportQueue);
+			}
+		}
+		m_sampleRate = signal->getSampleRate();
+		m_frequencyOffset = signal->getFrequencyOffset();
+		cmd->completed();
+		return true;
+	} else if(DSPConfigureIQRecorder::match(cmd)) {
+		DSPConfigureIQRecorder* conf = (DSPConfigureIQRecorder*)cmd;
+		if(conf->getFileName().isEmpty()) {
+			stopRecording();
+			m_stoppedFileName.clear();
+		} else if((m_current != NULL) && (conf->getFileName() == m_fileName)) {
+			setCenterFrequency(conf->getCenterFrequency());
+		} else if(conf->getFileName() == m_stoppedFileName) {
+			// sent before the GUI saw the stop
+			qDebug("IQRecorder: %s already finished, not overwritten", qPrintable(m_stoppedFileName));
+		} else {
+			m_stoppedFileName.clear();
+			startRecording(conf->getFileName(), m_sampleRate, conf->getCenterFrequency(), conf->getDirectIO());
+		}
+		cmd->completed();
+		return true;
+	} else {
+		return false;
+	}
+}
+
+void IQRecorder::queueBuffer()
+{
+	QMutexLocker mutexLocker(&m_mutex);
+
+	if(!m_freeBuffers.isEmpty()) {
+		m_fullBuffers.enqueue(m_current);
+		m_current = m_freeBuffers.dequeue();
+		m_bufferQueued.wakeOne();
+		m_samplesQueued += BufferSize / sizeof(Sample);
+		return;
+	}
+	mutexLocker.unlock();
+
+	// the disk does not keep up - drop the buffer rather than stall the DSP chain and start
+	// a new capture segment where the data continues
+	m_droppedBuffers.ref();
+	m_current->m_fill = 0;
+	Capture capture = { m_samplesQueued, m_captures.back().m_frequency, QDateTime::currentDateTimeUtc() };
+	if(m_captures.back().m_sampleStart == capture.m_sampleStart)
+		m_captures.back() = capture;
+	else m_captures.push_back(capture);
+}
+
+void IQRecorder::writeBuffers()
+{
+	QMutexLocker mutexLocker(&m_mutex);
+
+	while(true) {
+		while(m_fullBuffers.isEmpty() && !m_stopWriter)
+			m_bufferQueued.wait(&m_mutex);
+		if(m_fullBuffers.isEmpty())
+			break;
+
+		Buffer* buffer = m_fullBuffers.dequeue();
+		mutexLocker.unlock();
+		if(!m_writeError && (m_file.write(buffer->m_data, buffer->m_fill) != buffer->m_fill)) {
+			qCritical("IQRecorder: write error: %s", qPrintable(m_file.errorString()));
+			m_writeError = true;
+		}
+		mutexLocker.relock();
+
+		buffer->m_fill = 0;
+		m_freeBuffers.enqueue(buffer);
+	}
+}
+
+bool IQRecorder::openDataFile(const QString& fileName, bool directIO)
+{
+	m_file.setFileName(fileName);
+
+#if defined(Q_OS_LINUX) && defined(O_DIRECT)
+	// bypasses the page cache - all full buffers are aligned in memory and on disk
+	if(directIO) {
+		int fd = ::open(QFile::encodeName(fileName).constData(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+		if(fd >= 0) {
+			if(m_file.open(fd, QIODevice::WriteOnly | QIODevice::Unbuffered, QFileDevice::AutoCloseHandle))
+				return true;
+			::close(fd);
+		}
+		// tmpfs and some network file systems refuse it
+		qDebug("IQRecorder: O_DIRECT not available for %s", qPrintable(fileName));
+	}
+#else
+	Q_UNUSED(directIO);
+#endif
+
+	return m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered);
+}
+
+void IQRecorder::writeTail()
+{
+	if(m_writeError || (m_current->m_fill == 0))
+		return;
+
+#if defined(Q_OS_LINUX) && defined(O_DIRECT)
+	// the last buffer is only partially filled, which O_DIRECT does not allow
+	int flags = fcntl(m_file.handle(), F_GETFL);
+	if((flags != -1) && ((flags & O_DIRECT) != 0))
+		fcntl(m_file.handle(), F_SETFL, flags & ~O_DIRECT);
+#endif
+
+	if(m_file.write(m_current->m_data, m_current->m_fill) != m_current->m_fill)
+		qCritical("IQRecorder: write error: %s", qPrintable(m_file.errorString()));
+}
+
+bool IQRecorder::writeMeta()
+{
+	QJsonObject global;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+	global["core:datatype"] = QString("ci16_le");
+#else
+	global["core:datatype"] = QString("ci16_be");
+#endif
+	global["core:sample_rate"] = m_sampleRate;
+	global["core:version"] = QString("1.0.0");
+	global["core:num_channels"] = 1;
+	global["core:recorder"] = QString("SDRangelove");
+	if(m_droppedBuffers.load() > 0)
+		global["core:description"] = QString("%1 buffers of %2 samples were dropped").arg(m_droppedBuffers.load()).arg((int)(BufferSize / sizeof(Sample)));
+
+	QJsonArray captures;
+	for(Captures::const_iterator it = m_captures.begin(); it != m_captures.end(); ++it) {
+		QJsonObject capture;
+		capture["core:sample_start"] = (double)it->m_sampleStart;
+		capture["core:frequency"] = (double)it->m_frequency;
+		capture["core:datetime"] = it->m_dateTime.toString(Qt::ISODate);
+		captures.append(capture);
+	}
+
+	QJsonObject meta;
+	meta["global"] = global;
+	meta["captures"] = captures;
+	meta["annotations"] = QJsonArray();
+
+	QFile file(m_metaFileName);
+	QByteArray json = QJsonDocument(meta).toJson();
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || (file.write(json) != json.size())) {
+		qCritical("IQRecorder: could not write %s", qPrintable(m_metaFileName));
+		return false;
+	}
+	return true;
+}
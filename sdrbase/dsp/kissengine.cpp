@@ -14,6 +14,21 @@ void KissEngine::transform()
 	m_fft.transform(&m_in[0], &m_out[0]);
 }
 
+void KissEngine::reserve(int count, int stride)
+{
+	size_t size = count * stride;
+	if(size > m_in.size())
+		m_in.resize(size);
+	if(size > m_out.size())
+		m_out.resize(size);
+}
+
+void KissEngine::transformMany(int count, int stride)
+{
+	for(int i = 0; i < count; i++)
+		m_fft.transform(&m_in[i * stride], &m_out[i * stride]);
+}
+
 Complex* KissEngine::in()
 {
 	return &m_in[0];
@@ -4,3 +4,206 @@
 #include <math.h>
 #include <vector>
 #include "dsp/lowpass.h"
+#include "util/cpufeatures.h"
+
+#if defined(USE_SIMD) && defined(CPUFEATURES_X86)
+#include <emmintrin.h>
+#define LOWPASS_USE_SSE2
+#endif
+
+#if defined(CPUFEATURES_NEON)
+#include <arm_neon.h>
+#endif
+
+static void filterRealScalar(const Real* in, int count, int step, const Real* taps, int nTaps, Real* out)
+{
+	LowpassKernels::filter<Real>(in, count, step, taps, nTaps, out);
+}
+
+static void filterComplexScalar(const Complex* in, int count, int step, const Real* taps, int nTaps, Complex* out)
+{
+	LowpassKernels::filter<Complex>(in, count, step, taps, nTaps, out);
+}
+
+#if defined(LOWPASS_USE_SSE2)
+// without decimation four neighbouring outputs are done at once, one tap after the other. otherwise
+// four taps per step: the samples from the far end are loaded and reversed so they line up with the near ones
+static void filterRealSSE2(const Real* in, int count, int step, const Real* taps, int nTaps, Real* out)
+{
+	int half = nTaps / 2;
+	int j = 0;
+
+	if(step == 1) {
+		for(; j + 4 <= count; j += 4) {
+			const Real* window = in + j;
+			__m128 sum = _mm_mul_ps(_mm_loadu_ps(window + half), _mm_set1_ps(taps[half]));
+
+			for(int i = 0; i < half; i++)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(window + i), _mm_loadu_ps(window + nTaps - 1 - i)), _mm_set1_ps(taps[i])));
+
+			_mm_storeu_ps(out + j, sum);
+		}
+	}
+
+	for(; j < count; j++) {
+		const Real* window = in + j * step;
+		__m128 sum = _mm_setzero_ps();
+		int i = 0;
+
+		for(; i + 4 <= half; i += 4) {
+			__m128 far = _mm_loadu_ps(window + nTaps - 4 - i);
+			far = _mm_shuffle_ps(far, far, _MM_SHUFFLE(0, 1, 2, 3));
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(window + i), far), _mm_loadu_ps(taps + i)));
+		}
+
+		sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+		sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+		Real acc = _mm_cvtss_f32(sum);
+		for(; i < half; i++)
+			acc += (window[i] + window[nTaps - 1 - i]) * taps[i];
+		out[j] = acc + window[half] * taps[half];
+	}
+}
+
+// two neighbouring outputs at once without decimation. otherwise two samples per register, the taps
+// are duplicated for I and Q on the fly
+static void filterComplexSSE2(const Complex* in, int count, int step, const Real* taps, int nTaps, Complex* out)
+{
+	int half = nTaps / 2;
+	int j = 0;
+
+	if(step == 1) {
+		for(; j + 2 <= count; j += 2) {
+			const float* window = (const float*)(in + j);
+			__m128 sum = _mm_mul_ps(_mm_loadu_ps(window + 2 * half), _mm_set1_ps(taps[half]));
+
+			for(int i = 0; i < half; i++)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(window + 2 * i), _mm_loadu_ps(window + 2 * (nTaps - 1 - i))), _mm_set1_ps(taps[i])));
+
+			_mm_storeu_ps((float*)(out + j), sum);
+		}
+	}
+
+	for(; j < count; j++) {
+		const float* window = (const float*)(in + j * step);
+		__m128 sum = _mm_setzero_ps();
+		int i = 0;
+
+		for(; i + 2 <= half; i += 2) {
+			__m128 far = _mm_loadu_ps(window + 2 * (nTaps - 2 - i));
+			far = _mm_shuffle_ps(far, far, _MM_SHUFFLE(1, 0, 3, 2));
+			__m128 coeff = _mm_castpd_ps(_mm_load_sd((const double*)(taps + i)));
+			coeff = _mm_unpacklo_ps(coeff, coeff);
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(window + 2 * i), far), coeff));
+		}
+
+		// odd tap left over and the center tap
+		__m128 coeff = _mm_set_ps(taps[half], taps[half], (i < half) ? taps[i] : 0.0f, (i < half) ? taps[i] : 0.0f);
+		__m128 rest = _mm_loadh_pi(_mm_setzero_ps(), (const __m64*)(window + 2 * half));
+		if(i < half) {
+			__m128 pair = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(window + 2 * i));
+			pair = _mm_add_ps(pair, _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(window + 2 * (nTaps - 1 - i))));
+			rest = _mm_add_ps(rest, pair);
+		}
+		sum = _mm_add_ps(sum, _mm_mul_ps(rest, coeff));
+
+		_mm_storel_pi((__m64*)(out + j), _mm_add_ps(sum, _mm_movehl_ps(sum, sum)));
+	}
+}
+#endif
+
+#if defined(CPUFEATURES_NEON)
+static void filterRealNEON(const Real* in, int count, int step, const Real* taps, int nTaps, Real* out)
+{
+	int half = nTaps / 2;
+	int j = 0;
+
+	if(step == 1) {
+		for(; j + 4 <= count; j += 4) {
+			const Real* window = in + j;
+			float32x4_t sum = vmulq_n_f32(vld1q_f32(window + half), taps[half]);
+
+			for(int i = 0; i < half; i++)
+				sum = vmlaq_n_f32(sum, vaddq_f32(vld1q_f32(window + i), vld1q_f32(window + nTaps - 1 - i)), taps[i]);
+
+			vst1q_f32(out + j, sum);
+		}
+	}
+
+	for(; j < count; j++) {
+		const Real* window = in + j * step;
+		float32x4_t sum = vdupq_n_f32(0.0f);
+		int i = 0;
+
+		for(; i + 4 <= half; i += 4) {
+			float32x4_t far = vrev64q_f32(vld1q_f32(window + nTaps - 4 - i));
+			far = vcombine_f32(vget_high_f32(far), vget_low_f32(far));
+			sum = vmlaq_f32(sum, vaddq_f32(vld1q_f32(window + i), far), vld1q_f32(taps + i));
+		}
+
+		float32x2_t pair = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+		Real acc = vget_lane_f32(vpadd_f32(pair, pair), 0);
+		for(; i < half; i++)
+			acc += (window[i] + window[nTaps - 1 - i]) * taps[i];
+		out[j] = acc + window[half] * taps[half];
+	}
+}
+
+static void filterComplexNEON(const Complex* in, int count, int step, const Real* taps, int nTaps, Complex* out)
+{
+	int half = nTaps / 2;
+	int j = 0;
+
+	if(step == 1) {
+		for(; j + 2 <= count; j += 2) {
+			const float* window = (const float*)(in + j);
+			float32x4_t sum = vmulq_n_f32(vld1q_f32(window + 2 * half), taps[half]);
+
+			for(int i = 0; i < half; i++)
+				sum = vmlaq_n_f32(sum, vaddq_f32(vld1q_f32(window + 2 * i), vld1q_f32(window + 2 * (nTaps - 1 - i))), taps[i]);
+
+			vst1q_f32((float*)(out + j), sum);
+		}
+	}
+
+	for(; j < count; j++) {
+		const float* window = (const float*)(in + j * step);
+		float32x2_t sum = vdup_n_f32(0.0f);
+
+		for(int i = 0; i < half; i++)
+			sum = vmla_n_f32(sum, vadd_f32(vld1_f32(window + 2 * i), vld1_f32(window + 2 * (nTaps - 1 - i))), taps[i]);
+		sum = vmla_n_f32(sum, vld1_f32(window + 2 * half), taps[half]);
+
+		vst1_f32((float*)(out + j), sum);
+	}
+}
+#endif
+
+const LowpassKernels::RealKernel LowpassKernels::m_realKernel = LowpassKernels::selectRealKernel();
+const LowpassKernels::ComplexKernel LowpassKernels::m_complexKernel = LowpassKernels::selectComplexKernel();
+
+LowpassKernels::RealKernel LowpassKernels::selectRealKernel()
+{
+#if defined(LOWPASS_USE_SSE2)
+	if(CPUFeatures::has(CPUFeatures::SSE2))
+		return filterRealSSE2;
+#endif
+#if defined(CPUFEATURES_NEON)
+	if(CPUFeatures::has(CPUFeatures::NEON))
+		return filterRealNEON;
+#endif
+	return filterRealScalar;
+}
+
+LowpassKernels::ComplexKernel LowpassKernels::selectComplexKernel()
+{
+#if defined(LOWPASS_USE_SSE2)
+	if(CPUFeatures::has(CPUFeatures::SSE2))
+		return filterComplexSSE2;
+#endif
+#if defined(CPUFEATURES_NEON)
+	if(CPUFeatures::has(CPUFeatures::NEON))
+		return filterComplexNEON;
+#endif
+	return filterComplexScalar;
+}
@@ -20,10 +20,184 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 #include "dsp/nco.h"
+#include "util/cpufeatures.h"
+
+#if defined(USE_SIMD) && defined(CPUFEATURES_X86)
+#include <emmintrin.h>
+#define NCO_USE_SSE2
+#endif
+
+#if defined(CPUFEATURES_NEON)
+#include <arm_neon.h>
+#endif
 
 Real NCO::m_table[NCO::TableSize];
 bool NCO::m_tableInitialized = false;
 
+// the table index is the top of the accumulator, a quarter turn back from cos gives sin
+static inline quint32 tableIndex(quint32 phase)
+{
+	return phase >> (32 - NCO::TableBits);
+}
+
+static inline quint32 sinIndex(quint32 index)
+{
+	return (index + 3 * NCO::TableSize / 4) & (NCO::TableSize - 1);
+}
+
+static void mixTableScalar(const Complex* in, Complex* out, int count, const Real* table, quint32* phase, quint32 phaseIncrement)
+{
+	quint32 p = *phase;
+
+	for(int i = 0; i < count; i++) {
+		p += phaseIncrement;
+		quint32 index = tableIndex(p);
+		Real c = table[index];
+		Real s = table[sinIndex(index)];
+		// spelled out - std::complex multiplication checks for NaN and inf on every sample
+		Real re = in[i].real();
+		Real im = in[i].imag();
+		out[i] = Complex(re * c - im * s, re * s + im * c);
+	}
+
+	*phase = p;
+}
+
+static void mixOscillatorScalar(const Complex* in, Complex* out, int count, const NCO::Phasors& start, float stepRe, float stepIm)
+{
+	NCO::Phasors p = start;
+
+	for(int i = 0; i < count; i += 4) {
+		int lanes = qMin(4, count - i);
+		for(int k = 0; k < lanes; k++) {
+			Real re = in[i + k].real();
+			Real im = in[i + k].imag();
+			out[i + k] = Complex(re * p.m_re[k] - im * p.m_im[k], re * p.m_im[k] + im * p.m_re[k]);
+		}
+		for(int k = 0; k < 4; k++) {
+			float re = p.m_re[k] * stepRe - p.m_im[k] * stepIm;
+			p.m_im[k] = p.m_re[k] * stepIm + p.m_im[k] * stepRe;
+			p.m_re[k] = re;
+		}
+	}
+}
+
+#if defined(NCO_USE_SSE2)
+// two samples per register: the phasor is spread into [re re re re] and [im im im im] halves and
+// the swapped input gets the signs for the cross terms
+static void mixTableSSE2(const Complex* in, Complex* out, int count, const Real* table, quint32* phase, quint32 phaseIncrement)
+{
+	const __m128 sign = _mm_set_ps(1.0f, -1.0f, 1.0f, -1.0f);
+	const float* src = (const float*)in;
+	float* dst = (float*)out;
+	quint32 p = *phase;
+
+	int i = 0;
+	for(; i + 2 <= count; i += 2) {
+		quint32 index0 = tableIndex(p + phaseIncrement);
+		quint32 index1 = tableIndex(p + 2 * phaseIncrement);
+		p += 2 * phaseIncrement;
+		__m128 c = _mm_set_ps(table[index1], table[index1], table[index0], table[index0]);
+		__m128 s = _mm_set_ps(table[sinIndex(index1)], table[sinIndex(index1)], table[sinIndex(index0)], table[sinIndex(index0)]);
+		__m128 x = _mm_loadu_ps(src + 2 * i);
+		__m128 swapped = _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1));
+		_mm_storeu_ps(dst + 2 * i, _mm_add_ps(_mm_mul_ps(x, c), _mm_mul_ps(_mm_mul_ps(swapped, s), sign)));
+	}
+
+	*phase = p;
+	mixTableScalar(in + i, out + i, count - i, table, phase, phaseIncrement);
+}
+
+// four samples per step, deinterleaved into real and imaginary registers so the four phasors
+// advance with plain multiplies
+static void mixOscillatorSSE2(const Complex* in, Complex* out, int count, const NCO::Phasors& start, float stepRe, float stepIm)
+{
+	const __m128 sRe = _mm_set1_ps(stepRe);
+	const __m128 sIm = _mm_set1_ps(stepIm);
+	__m128 pRe = _mm_loadu_ps(start.m_re);
+	__m128 pIm = _mm_loadu_ps(start.m_im);
+	const float* src = (const float*)in;
+	float* dst = (float*)out;
+
+	int i = 0;
+	for(; i + 4 <= count; i += 4) {
+		__m128 x0 = _mm_loadu_ps(src + 2 * i);
+		__m128 x1 = _mm_loadu_ps(src + 2 * i + 4);
+		__m128 re = _mm_shuffle_ps(x0, x1, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 im = _mm_shuffle_ps(x0, x1, _MM_SHUFFLE(3, 1, 3, 1));
+		__m128 yRe = _mm_sub_ps(_mm_mul_ps(re, pRe), _mm_mul_ps(im, pIm));
+		__m128 yIm = _mm_add_ps(_mm_mul_ps(re, pIm), _mm_mul_ps(im, pRe));
+		_mm_storeu_ps(dst + 2 * i, _mm_unpacklo_ps(yRe, yIm));
+		_mm_storeu_ps(dst + 2 * i + 4, _mm_unpackhi_ps(yRe, yIm));
+
+		__m128 t = _mm_sub_ps(_mm_mul_ps(pRe, sRe), _mm_mul_ps(pIm, sIm));
+		pIm = _mm_add_ps(_mm_mul_ps(pRe, sIm), _mm_mul_ps(pIm, sRe));
+		pRe = t;
+	}
+
+	if(i < count) {
+		NCO::Phasors p;
+		_mm_storeu_ps(p.m_re, pRe);
+		_mm_storeu_ps(p.m_im, pIm);
+		mixOscillatorScalar(in + i, out + i, count - i, p, stepRe, stepIm);
+	}
+}
+#endif
+
+#if defined(CPUFEATURES_NEON)
+// vld2/vst2 do the deinterleaving
+static void mixOscillatorNEON(const Complex* in, Complex* out, int count, const NCO::Phasors& start, float stepRe, float stepIm)
+{
+	float32x4_t pRe = vld1q_f32(start.m_re);
+	float32x4_t pIm = vld1q_f32(start.m_im);
+
+	int i = 0;
+	for(; i + 4 <= count; i += 4) {
+		float32x4x2_t x = vld2q_f32((const float*)(in + i));
+		float32x4x2_t y;
+		y.val[0] = vmlsq_f32(vmulq_f32(x.val[0], pRe), x.val[1], pIm);
+		y.val[1] = vmlaq_f32(vmulq_f32(x.val[0], pIm), x.val[1], pRe);
+		vst2q_f32((float*)(out + i), y);
+
+		float32x4_t t = vmlsq_n_f32(vmulq_n_f32(pRe, stepRe), pIm, stepIm);
+		pIm = vmlaq_n_f32(vmulq_n_f32(pRe, stepIm), pIm, stepRe);
+		pRe = t;
+	}
+
+	if(i < count) {
+		NCO::Phasors p;
+		vst1q_f32(p.m_re, pRe);
+		vst1q_f32(p.m_im, pIm);
+		mixOscillatorScalar(in + i, out + i, count - i, p, stepRe, stepIm);
+	}
+}
+#endif
+
+const NCO::TableKernel NCO::m_tableKernel = NCO::selectTableKernel();
+const NCO::OscillatorKernel NCO::m_oscillatorKernel = NCO::selectOscillatorKernel();
+
+NCO::TableKernel NCO::selectTableKernel()
+{
+#if defined(NCO_USE_SSE2)
+	if(CPUFeatures::has(CPUFeatures::SSE2))
+		return mixTableSSE2;
+#endif
+	return mixTableScalar;
+}
+
+NCO::OscillatorKernel NCO::selectOscillatorKernel()
+{
+#if defined(NCO_USE_SSE2)
+	if(CPUFeatures::has(CPUFeatures::SSE2))
+		return mixOscillatorSSE2;
+#endif
+#if defined(CPUFEATURES_NEON)
+	if(CPUFeatures::has(CPUFeatures::NEON))
+		return mixOscillatorNEON;
+#endif
+	return mixOscillatorScalar;
+}
+
 void NCO::initTable()
 {
 	if(m_tableInitialized)
@@ -39,41 +213,63 @@ NCO::NCO()
 {
 	initTable();
 	m_phase = 0;
+	m_phaseIncrement = 0;
+	m_mode = ModeTable;
 }
 
 void NCO::setFreq(Real freq, Real sampleRate)
 {
 	if(sampleRate > 0) {
-		m_phaseIncrement = (freq * TableSize) / sampleRate;
+		// wrap into [0, 1) of a turn - negative frequencies become large increments
+		double turns = (double)freq / (double)sampleRate;
+		turns -= floor(turns);
+		m_phaseIncrement = (quint32)(qint64)llround(turns * 4294967296.0);
 		if(m_phaseIncrement != 0)
-			qDebug("NCO phase inc %d (period %f)", m_phaseIncrement, (Real)TableSize / (Real)m_phaseIncrement);
-		else qDebug("NCO phase inc %d (period oo)", m_phaseIncrement);
+			qDebug("NCO phase inc %u (period %f)", m_phaseIncrement, (Real)sampleRate / freq);
+		else qDebug("NCO phase inc %u (period oo)", m_phaseIncrement);
 	} else {
 		qDebug("cannot calculate NCO phase increment since samplerate is 0");
-		m_phaseIncrement = 1;
+		m_phaseIncrement = 1 << (32 - TableBits);
 	}
 }
 
 float NCO::next()
 {
 	m_phase += m_phaseIncrement;
-	while(m_phase >= TableSize)
-		m_phase -= TableSize;
-	while(m_phase < 0)
-		m_phase += TableSize;
 
-	return m_table[m_phase];
+	return m_table[tableIndex(m_phase)];
 }
 
 Complex NCO::nextIQ()
 {
 	m_phase += m_phaseIncrement;
-	while(m_phase >= TableSize)
-		m_phase -= TableSize;
-	while(m_phase < 0)
-		m_phase += TableSize;
+	quint32 index = tableIndex(m_phase);
 
-	int idxQuad = (m_phase + (TableSize / 4) + (TableSize / 2)) % TableSize;
+	return Complex(m_table[index], m_table[sinIndex(index)]);
+}
 
-	return Complex(m_table[m_phase], m_table[idxQuad]);
+void NCO::mix(const Complex* in, Complex* out, int count)
+{
+	if(m_mode == ModeTable) {
+		m_tableKernel(in, out, count, m_table, &m_phase, m_phaseIncrement);
+		return;
+	}
+
+	// every lane starts from the exact phase and then advances by four samples per step
+	double increment = m_phaseIncrement * (2.0 * M_PI / 4294967296.0);
+	float stepRe = cos(4.0 * increment);
+	float stepIm = sin(4.0 * increment);
+
+	for(int done = 0; done < count; ) {
+		int n = qMin(count - done, (int)ReseedInterval);
+		Phasors start;
+		for(int k = 0; k < 4; k++) {
+			double phase = (quint32)(m_phase + (k + 1) * m_phaseIncrement) * (2.0 * M_PI / 4294967296.0);
+			start.m_re[k] = cos(phase);
+			start.m_im[k] = sin(phase);
+		}
+		m_oscillatorKernel(in + done, out + done, n, start, stepRe, stepIm);
+		m_phase += n * m_phaseIncrement;
+		done += n;
+	}
 }
@@ -0,0 +1,251 @@
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include "dsp/pfbchannelizer.h"
+#include "dsp/fftengine.h"
+#include "dsp/samplesink.h"
+#include "dsp/dspcommands.h"
+
+PFBChannelizer::PFBChannelizer() :
+	m_channels(),
+	m_sampleRate(0),
+	m_nChannels(0),
+	m_decimation(0),
+	m_fft(NULL),
+	m_taps(),
+	m_history(),
+	m_historyPtr(0),
+	m_phase(0),
+	m_oddBlock(false),
+	m_outputFill(0),
+	m_firstOfBurst(false)
+{
+}
+
+PFBChannelizer::~PFBChannelizer()
+{
+	for(Channels::iterator it = m_channels.begin(); it != m_channels.end(); ++it)
+		delete *it;
+	if(m_fft != NULL)
+		delete m_fft;
+}
+
+void PFBChannelizer::configure(int sampleRate)
+{
+	if(sampleRate == m_sampleRate)
+		return;
+
+	m_sampleRate = sampleRate;
+	m_nChannels = 0;
+	createFilterbank();
+}
+
+void PFBChannelizer::addChannel(SampleSink* sampleSink)
+{
+	for(Channels::iterator it = m_channels.begin(); it != m_channels.end(); ++it) {
+		if((*it)->m_sampleSink == sampleSink)
+			return;
+	}
+	m_channels.push_back(new Channel(sampleSink));
+}
+
+void PFBChannelizer::removeChannel(SampleSink* sampleSink)
+{
+	for(Channels::iterator it = m_channels.begin(); it != m_channels.end(); ++it) {
+		if((*it)->m_sampleSink == sampleSink) {
+			delete *it;
+			m_channels.erase(it);
+			// the widest channel might be gone
+			createFilterbank();
+			return;
+		}
+	}
+}
+
+void PFBChannelizer::configureChannel(SampleSink* sampleSink, int bandwidth, int centerFrequency)
+{
+	for(Channels::iterator it = m_channels.begin(); it != m_channels.end(); ++it) {
+		Channel* channel = *it;
+		if(channel->m_sampleSink != sampleSink)
+			continue;
+
+		channel->m_bandwidth = bandwidth;
+		channel->m_centerFrequency = centerFrequency;
+		int nChannels = m_nChannels;
+		createFilterbank();
+		// a new bin count has already notified everyone
+		if(m_nChannels == nChannels) {
+			assignChannel(channel);
+			notifyChannel(channel);
+		}
+		return;
+	}
+}
+
+void PFBChannelizer::feed(SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst)
+{
+	if(m_nChannels == 0)
+		return;
+
+	int historySize = m_taps.size();
+	m_firstOfBurst = firstOfBurst;
+
+	for(SampleVector::const_iterator it = begin; it != end; ++it) {
+		Complex c(it->real(), it->imag());
+		m_history[m_historyPtr] = c;
+		m_history[m_historyPtr + historySize] = c;
+		if(++m_historyPtr == historySize)
+			m_historyPtr = 0;
+
+		if(++m_phase == m_decimation) {
+			m_phase = 0;
+			analyze();
+		}
+	}
+
+	flush();
+}
+
+void PFBChannelizer::start()
+{
+	for(Channels::iterator it = m_channels.begin(); it != m_channels.end(); ++it) {
+		(*it)->m_sampleSink->start();
+		// a restart at the same rate does not go through createFilterbank()
+		if(m_nChannels > 0)
+			notifyChannel(*it);
+	}
+}
+
+void PFBChannelizer::stop()
+{
+	for(Channels::iterator it = m_channels.begin(); it != m_channels.end(); ++it)
+		(*it)->m_sampleSink->stop();
+}
+
+void PFBChannelizer::createFilterbank()
+{
+	if(m_sampleRate <= 0)
+		return;
+
+	// a channel at the worst offset (half a bin) plus half its bandwidth has to stay
+	// in the flat passband of +/- 3/4 bin
+	int bandwidth = 0;
+	for(Channels::const_iterator it = m_channels.begin(); it != m_channels.end(); ++it) {
+		if((*it)->m_bandwidth > bandwidth)
+			bandwidth = (*it)->m_bandwidth;
+	}
+	int nChannels = MaxChannels;
+	while((nChannels > MinChannels) && (m_sampleRate / nChannels < 2 * bandwidth))
+		nChannels /= 2;
+	if(m_sampleRate / nChannels < 2 * bandwidth)
+		qDebug("PFBChannelizer: %d Hz channels do not fit into %d Hz bins", bandwidth, m_sampleRate / nChannels);
+
+	if(nChannels == m_nChannels)
+		return;
+
+	m_nChannels = nChannels;
+	m_decimation = nChannels / 2;
+
+	// windowed sinc, cutoff (-6 dB) at one bin from the center, stop band from 5/4 bin on -
+	// everything aliasing back from beyond the output Nyquist frequency ends up outside +/- 3/4 bin
+	int nTaps = nChannels * TapsPerBranch;
+	double fc = 1.0 / nChannels;
+	double sum = 0;
+	m_taps.resize(nTaps);
+	for(int i = 0; i < nTaps; i++) {
+		double x = i - (nTaps - 1) / 2.0;
+		double sinc = 2.0 * fc * sin(2.0 * M_PI * fc * x) / (2.0 * M_PI * fc * x);
+		double window = 0.42 - 0.5 * cos(2.0 * M_PI * (i + 0.5) / nTaps) + 0.08 * cos(4.0 * M_PI * (i + 0.5) / nTaps);
+		m_taps[i] = sinc * window;
+		sum += m_taps[i];
+	}
+	// unity gain, and int16 full scale in to 1.0 out
+	for(int i = 0; i < nTaps; i++)
+		m_taps[i] /= sum * 32768.0;
+
+	m_history.assign(2 * nTaps, Complex(0, 0));
+	m_historyPtr = 0;
+	m_phase = 0;
+	m_oddBlock = false;
+	m_outputFill = 0;
+
+	if(m_fft == NULL)
+		m_fft = FFTEngine::create();
+	m_fft->configure(nChannels, false);
+
+	qDebug("PFBChannelizer: %d bins of %d Hz", m_nChannels, m_sampleRate / m_nChannels);
+
+	for(Channels::iterator it = m_channels.begin(); it != m_channels.end(); ++it) {
+		assignChannel(*it);
+		notifyChannel(*it);
+	}
+}
+
+void PFBChannelizer::assignChannel(Channel* channel)
+{
+	// bin k is centered at k * sampleRate / nChannels
+	int k = floor((double)channel->m_centerFrequency * m_nChannels / m_sampleRate + 0.5);
+	if(k < -m_nChannels / 2)
+		k = -m_nChannels / 2;
+	else if(k >= m_nChannels / 2)
+		k = m_nChannels / 2 - 1;
+
+	// analyze() mixes with exp(+j...), so bin k is found at FFT output -k
+	channel->m_bin = (m_nChannels - k) % m_nChannels;
+}
+
+void PFBChannelizer::notifyChannel(Channel* channel)
+{
+	int k = (m_nChannels - channel->m_bin) % m_nChannels;
+	if(k >= m_nChannels / 2)
+		k -= m_nChannels;
+	qint64 offset = channel->m_centerFrequency - (qint64)k * m_sampleRate / m_nChannels;
+
+	DSPSignalNotification* signal = DSPSignalNotification::create(m_sampleRate / m_decimation, offset);
+	if(!channel->m_sampleSink->handleMessage(signal))
+		signal->completed();
+}
+
+void PFBChannelizer::analyze()
+{
+	int nTaps = m_taps.size();
+	const Complex* history = &m_history[m_historyPtr];
+	const Real* taps = &m_taps[0];
+	Complex* in = m_fft->in();
+
+	// weight and fold the history into one FFT frame, newest sample at frame position 0
+	for(int m = 0; m < m_nChannels; m++) {
+		Real i = 0;
+		Real q = 0;
+		for(int p = nTaps - 1 - m; p >= 0; p -= m_nChannels) {
+			i += history[p].real() * taps[p];
+			q += history[p].imag() * taps[p];
+		}
+		in[m] = Complex(i, q);
+	}
+
+	m_fft->transform();
+	const Complex* out = m_fft->out();
+
+	// the output of bin k advances by pi * k every frame (hop of half a frame)
+	for(Channels::iterator it = m_channels.begin(); it != m_channels.end(); ++it) {
+		Channel* channel = *it;
+		if(m_oddBlock && (channel->m_bin & 1))
+			channel->m_sampleBuffer[m_outputFill] = -out[channel->m_bin];
+		else channel->m_sampleBuffer[m_outputFill] = out[channel->m_bin];
+	}
+	m_oddBlock = !m_oddBlock;
+
+	if(++m_outputFill == OutputBlockSize) {
+		flush();
+		m_firstOfBurst = false;
+	}
+}
+
+void PFBChannelizer::flush()
+{
+	for(Channels::iterator it = m_channels.begin(); it != m_channels.end(); ++it) {
+		Channel* channel = *it;
+		channel->m_sampleSink->feedComplex(channel->m_sampleBuffer.begin(), channel->m_sampleBuffer.begin() + m_outputFill, m_firstOfBurst);
+	}
+	m_outputFill = 0;
+}
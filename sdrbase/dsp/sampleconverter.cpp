@@ -0,0 +1,266 @@
+#include <math.h>
+#include "dsp/sampleconverter.h"
+#include "util/cpufeatures.h"
+
+#if defined(USE_SIMD) && defined(CPUFEATURES_X86)
+#include <emmintrin.h>
+#define SC_USE_SSE2
+#endif
+
+#if defined(CPUFEATURES_NEON)
+#include <arm_neon.h>
+#endif
+
+static void convertU8Scalar(const quint8* in, int count, Sample* out)
+{
+	for(int i = 0; i < count; i++)
+		out[i] = SampleConverter::fromU8(in + 2 * i);
+}
+
+static void deinterleaveU8Scalar(const quint8* in, int count, Sample* even, Sample* odd)
+{
+	for(int i = 0; i < count; i++) {
+		even[i] = SampleConverter::fromU8(in + 4 * i);
+		odd[i] = SampleConverter::fromU8(in + 4 * i + 2);
+	}
+}
+
+static inline FixReal saturate(float v)
+{
+	return qBound(-32768L, lrintf(v), 32767L);
+}
+
+static void convertFloatScalar(const float* in, int count, float scale, Sample* out)
+{
+	for(int i = 0; i < count; i++)
+		out[i] = Sample(saturate(in[2 * i] * scale), saturate(in[2 * i + 1] * scale));
+}
+
+static void toComplexScalar(const Sample* in, int count, Complex* out)
+{
+	for(int i = 0; i < count; i++)
+		out[i] = Complex(in[i].real() / 32768.0f, in[i].imag() / 32768.0f);
+}
+
+#if defined(SC_USE_SSE2)
+// flipping the top bit turns offset binary into two's complement, unpacking against zero then puts
+// each byte into the high half of a 16 bit lane - no shuffle table needed
+static void convertU8SSE2(const quint8* in, int count, Sample* out)
+{
+	const __m128i bias = _mm_set1_epi8((char)0x80);
+	const __m128i zero = _mm_setzero_si128();
+
+	int i = 0;
+	for(; i + 8 <= count; i += 8) {
+		__m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(in + 2 * i)), bias);
+		_mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi8(zero, x));
+		_mm_storeu_si128((__m128i*)(out + i + 4), _mm_unpackhi_epi8(zero, x));
+	}
+	convertU8Scalar(in + 2 * i, count - i, out + i);
+}
+
+// a sample is 32 bits, so pshufd sorts them into even and odd ones
+static void deinterleaveU8SSE2(const quint8* in, int count, Sample* even, Sample* odd)
+{
+	const __m128i bias = _mm_set1_epi8((char)0x80);
+	const __m128i zero = _mm_setzero_si128();
+
+	int i = 0;
+	for(; i + 4 <= count; i += 4) {
+		__m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(in + 4 * i)), bias);
+		__m128i lo = _mm_shuffle_epi32(_mm_unpacklo_epi8(zero, x), _MM_SHUFFLE(3, 1, 2, 0));
+		__m128i hi = _mm_shuffle_epi32(_mm_unpackhi_epi8(zero, x), _MM_SHUFFLE(3, 1, 2, 0));
+		_mm_storeu_si128((__m128i*)(even + i), _mm_unpacklo_epi64(lo, hi));
+		_mm_storeu_si128((__m128i*)(odd + i), _mm_unpackhi_epi64(lo, hi));
+	}
+	deinterleaveU8Scalar(in + 4 * i, count - i, even + i, odd + i);
+}
+
+// cvtps2dq rounds like lrintf(), but turns everything out of range into 0x80000000 - so clamp
+// first and let packssdw do the rest
+static void convertFloatSSE2(const float* in, int count, float scale, Sample* out)
+{
+	const __m128 s = _mm_set1_ps(scale);
+	const __m128 lower = _mm_set1_ps(-32768.0f);
+	const __m128 upper = _mm_set1_ps(32767.0f);
+
+	int i = 0;
+	for(; i + 4 <= count; i += 4) {
+		__m128 lo = _mm_mul_ps(_mm_loadu_ps(in + 2 * i), s);
+		__m128 hi = _mm_mul_ps(_mm_loadu_ps(in + 2 * i + 4), s);
+		lo = _mm_min_ps(_mm_max_ps(lo, lower), upper);
+		hi = _mm_min_ps(_mm_max_ps(hi, lower), upper);
+		_mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi)));
+	}
+	convertFloatScalar(in + 2 * i, count - i, scale, out + i);
+}
+
+// unpacking a register with itself and shifting right by 16 sign extends without SSE4.1
+static void toComplexSSE2(const Sample* in, int count, Complex* out)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+	float* dst = (float*)out;
+
+	int i = 0;
+	for(; i + 4 <= count; i += 4) {
+		__m128i x = _mm_loadu_si128((const __m128i*)(in + i));
+		__m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+		__m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16));
+		_mm_storeu_ps(dst + 2 * i, _mm_mul_ps(lo, scale));
+		_mm_storeu_ps(dst + 2 * i + 4, _mm_mul_ps(hi, scale));
+	}
+	toComplexScalar(in + i, count - i, out + i);
+}
+#endif
+
+#if defined(CPUFEATURES_NEON)
+static void convertU8NEON(const quint8* in, int count, Sample* out)
+{
+	const uint8x16_t bias = vdupq_n_u8(0x80);
+
+	int i = 0;
+	for(; i + 8 <= count; i += 8) {
+		int8x16_t x = vreinterpretq_s8_u8(veorq_u8(vld1q_u8(in + 2 * i), bias));
+		vst1q_s16((qint16*)(out + i), vshll_n_s8(vget_low_s8(x), 8));
+		vst1q_s16((qint16*)(out + i + 4), vshll_n_s8(vget_high_s8(x), 8));
+	}
+	convertU8Scalar(in + 2 * i, count - i, out + i);
+}
+
+// vld2 on 16 bit lanes splits the byte pairs of even and odd samples
+static void deinterleaveU8NEON(const quint8* in, int count, Sample* even, Sample* odd)
+{
+	const uint8x16_t bias = vdupq_n_u8(0x80);
+
+	int i = 0;
+	for(; i + 8 <= count; i += 8) {
+		uint16x8x2_t x = vld2q_u16((const quint16*)(in + 4 * i));
+		int8x16_t e = vreinterpretq_s8_u8(veorq_u8(vreinterpretq_u8_u16(x.val[0]), bias));
+		int8x16_t o = vreinterpretq_s8_u8(veorq_u8(vreinterpretq_u8_u16(x.val[1]), bias));
+		vst1q_s16((qint16*)(even + i), vshll_n_s8(vget_low_s8(e), 8));
+		vst1q_s16((qint16*)(even + i + 4), vshll_n_s8(vget_high_s8(e), 8));
+		vst1q_s16((qint16*)(odd + i), vshll_n_s8(vget_low_s8(o), 8));
+		vst1q_s16((qint16*)(odd + i + 4), vshll_n_s8(vget_high_s8(o), 8));
+	}
+	deinterleaveU8Scalar(in + 4 * i, count - i, even + i, odd + i);
+}
+
+// has to round like lrintf() and cvtps2dq, half to even. AArch64 has vcvtn for that, ARMv7 only
+// the truncating vcvt - there adding and subtracting 1.5 * 2^23 rounds the clamped value (NEON
+// always rounds to nearest even) and leaves an integer for vcvt. vqmovn saturates
+static inline int32x4_t roundNEON(float32x4_t v)
+{
+#if defined(__aarch64__)
+	return vcvtnq_s32_f32(v);
+#else
+	const float32x4_t magic = vdupq_n_f32(12582912.0f);
+	return vcvtq_s32_f32(vsubq_f32(vaddq_f32(v, magic), magic));
+#endif
+}
+
+static void convertFloatNEON(const float* in, int count, float scale, Sample* out)
+{
+	const float32x4_t lower = vdupq_n_f32(-32768.0f);
+	const float32x4_t upper = vdupq_n_f32(32767.0f);
+
+	int i = 0;
+	for(; i + 4 <= count; i += 4) {
+		float32x4_t lo = vmulq_n_f32(vld1q_f32(in + 2 * i), scale);
+		float32x4_t hi = vmulq_n_f32(vld1q_f32(in + 2 * i + 4), scale);
+		lo = vminq_f32(vmaxq_f32(lo, lower), upper);
+		hi = vminq_f32(vmaxq_f32(hi, lower), upper);
+		vst1q_s16((qint16*)(out + i), vcombine_s16(vqmovn_s32(roundNEON(lo)), vqmovn_s32(roundNEON(hi))));
+	}
+	convertFloatScalar(in + 2 * i, count - i, scale, out + i);
+}
+
+static void toComplexNEON(const Sample* in, int count, Complex* out)
+{
+	float* dst = (float*)out;
+
+	int i = 0;
+	for(; i + 4 <= count; i += 4) {
+		int16x8_t x = vld1q_s16((const qint16*)(in + i));
+		vst1q_f32(dst + 2 * i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), 1.0f / 32768.0f));
+		vst1q_f32(dst + 2 * i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), 1.0f / 32768.0f));
+	}
+	toComplexScalar(in + i, count - i, out + i);
+}
+#endif
+
+const SampleConverter::ConvertKernel SampleConverter::m_convertKernel = SampleConverter::selectConvertKernel();
+const SampleConverter::DeinterleaveKernel SampleConverter::m_deinterleaveKernel = SampleConverter::selectDeinterleaveKernel();
+const SampleConverter::FloatKernel SampleConverter::m_floatKernel = SampleConverter::selectFloatKernel();
+const SampleConverter::ComplexKernel SampleConverter::m_complexKernel = SampleConverter::selectComplexKernel();
+
+void SampleConverter::convertU8(const quint8* in, int count, Sample* out)
+{
+	m_convertKernel(in, count, out);
+}
+
+void SampleConverter::deinterleaveU8(const quint8* in, int count, Sample* even, Sample* odd)
+{
+	m_deinterleaveKernel(in, count, even, odd);
+}
+
+void SampleConverter::convertFloat(const float* in, int count, float scale, Sample* out)
+{
+	m_floatKernel(in, count, scale, out);
+}
+
+void SampleConverter::toComplex(const Sample* in, int count, Complex* out)
+{
+	m_complexKernel(in, count, out);
+}
+
+SampleConverter::ConvertKernel SampleConverter::selectConvertKernel()
+{
+#if defined(SC_USE_SSE2)
+	if(CPUFeatures::has(CPUFeatures::SSE2))
+		return convertU8SSE2;
+#endif
+#if defined(CPUFEATURES_NEON)
+	if(CPUFeatures::has(CPUFeatures::NEON))
+		return convertU8NEON;
+#endif
+	return convertU8Scalar;
+}
+
+SampleConverter::DeinterleaveKernel SampleConverter::selectDeinterleaveKernel()
+{
+#if defined(SC_USE_SSE2)
+	if(CPUFeatures::has(CPUFeatures::SSE2))
+		return deinterleaveU8SSE2;
+#endif
+#if defined(CPUFEATURES_NEON)
+	if(CPUFeatures::has(CPUFeatures::NEON))
+		return deinterleaveU8NEON;
+#endif
+	return deinterleaveU8Scalar;
+}
+
+SampleConverter::FloatKernel SampleConverter::selectFloatKernel()
+{
+#if defined(SC_USE_SSE2)
+	if(CPUFeatures::has(CPUFeatures::SSE2))
+		return convertFloatSSE2;
+#endif
+#if defined(CPUFEATURES_NEON)
+	if(CPUFeatures::has(CPUFeatures::NEON))
+		return convertFloatNEON;
+#endif
+	return convertFloatScalar;
+}
+
+SampleConverter::ComplexKernel SampleConverter::selectComplexKernel()
+{
+#if defined(SC_USE_SSE2)
+	if(CPUFeatures::has(CPUFeatures::SSE2))
+		return toComplexSSE2;
+#endif
+#if defined(CPUFEATURES_NEON)
+	if(CPUFeatures::has(CPUFeatures::NEON))
+		return toComplexNEON;
+#endif
+	return toComplexScalar;
+}
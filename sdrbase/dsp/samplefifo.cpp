@@ -15,38 +15,203 @@
 // along with this program. If not, see <http://www.gnu.org/licenses/>.          //
 ///////////////////////////////////////////////////////////////////////////////////
 
+#include <new>
+#include <stdio.h>
 #include "dsp/samplefifo.h"
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
 
+// map "bytes" of shared memory twice into consecutive virtual memory
+// returns NULL if the platform does not cooperate
+#if defined(_WIN32)
+static Sample* mapMirrored(size_t bytes, void** mapping)
+{
+	HANDLE handle = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD)bytes, NULL);
+	if(handle == NULL)
+		return NULL;
+
+	// there is no atomic way to reserve and map, so retry if someone else grabs the gap
+	for(int retry = 0; retry < 16; retry++) {
+		char* base = (char*)VirtualAlloc(NULL, 2 * bytes, MEM_RESERVE, PAGE_NOACCESS);
+		if(base == NULL)
+			break;
+		VirtualFree(base, 0, MEM_RELEASE);
+		if(MapViewOfFileEx(handle, FILE_MAP_ALL_ACCESS, 0, 0, bytes, base) != base)
+			continue;
+		if(MapViewOfFileEx(handle, FILE_MAP_ALL_ACCESS, 0, 0, bytes, base + bytes) != base + bytes) {
+			UnmapViewOfFile(base);
+			continue;
+		}
+		*mapping = handle;
+		return (Sample*)base;
+	}
+
+	CloseHandle(handle);
+	return NULL;
+}
+
+static void unmapMirrored(Sample* data, size_t bytes, void* mapping)
+{
+	UnmapViewOfFile((char*)data + bytes);
+	UnmapViewOfFile(data);
+	CloseHandle((HANDLE)mapping);
+}
+
+static size_t mapGranularity()
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwAllocationGranularity;
+}
+#else
+static int createSharedMemory()
+{
+#if defined(SYS_memfd_create)
+	int fd = syscall(SYS_memfd_create, "samplefifo", 0);
+	if(fd >= 0)
+		return fd;
+#endif
+	char name[64];
+	static QAtomicInt counter;
+	snprintf(name, sizeof(name), "/sdrangelove-fifo-%d-%d", (int)getpid(), counter.fetchAndAddRelaxed(1));
+	int fd2 = shm_open(name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+	if(fd2 >= 0)
+		shm_unlink(name);
+	return fd2;
+}
+
+static Sample* mapMirrored(size_t bytes, void** mapping)
+{
+	int fd = createSharedMemory();
+	if(fd < 0)
+		return NULL;
+	if(ftruncate(fd, bytes) < 0) {
+		close(fd);
+		return NULL;
+	}
+
+	// reserve the address range, then map the same pages into both halves
+	char* base = (char*)mmap(NULL, 2 * bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(base == MAP_FAILED) {
+		close(fd);
+		return NULL;
+	}
+	if((mmap(base, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != base) ||
+		(mmap(base + bytes, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != base + bytes)) {
+		munmap(base, 2 * bytes);
+		close(fd);
+		return NULL;
+	}
+
+	close(fd);
+	*mapping = NULL;
+	return (Sample*)base;
+}
+
+static void unmapMirrored(Sample* data, size_t bytes, void* mapping)
+{
+	Q_UNUSED(mapping);
+	munmap(data, 2 * bytes);
+}
+
+static size_t mapGranularity()
+{
+	return sysconf(_SC_PAGESIZE);
+}
+#endif
+
 void SampleFifo::create(uint s)
 {
+	destroy();
+
+	if(s == 0)
+		return;
+
+	// round up to whole pages
+	size_t granularity = mapGranularity();
+	size_t bytes = (((size_t)s * sizeof(Sample) + granularity - 1) / granularity) * granularity;
+	uint size = bytes / sizeof(Sample);
+
+	if((m_data = mapMirrored(bytes, &m_mapping)) != NULL) {
+		m_mirrored = true;
+	} else {
+		// no virtual memory tricks available - keep a second copy of every written sample instead
+		qDebug("SampleFifo: mirrored mapping failed, using software mirror");
+		m_data = new(std::nothrow) Sample[2 * size];
+		m_mirrored = false;
+		if(m_data == NULL) {
+			qCritical("SampleFifo: out of memory");
+			return;
+		}
+	}
+
+	m_size = size;
+}
+
+void SampleFifo::destroy()
+{
+	if(m_data != NULL) {
+		if(m_mirrored)
+			unmapMirrored(m_data, m_size * sizeof(Sample), m_mapping);
+		else delete[] m_data;
+	}
+	m_data = NULL;
+	m_mapping = NULL;
+	m_mirrored = false;
 	m_size = 0;
-	m_fill = 0;
+	m_fill.store(0);
 	m_head = 0;
 	m_tail = 0;
+}
 
-	m_data.resize(s);
-	m_size = m_data.size();
-
-	if(m_size != s)
-		qCritical("SampleFifo: out of memory");
+void SampleFifo::mirror(uint pos, uint count)
+{
+	// keep both halves identical when the ring is not mapped twice
+	while(count > 0) {
+		uint len;
+		if(pos < m_size) {
+			len = MIN(count, m_size - pos);
+			std::copy(m_data + pos, m_data + pos + len, m_data + pos + m_size);
+		} else {
+			len = count;
+			std::copy(m_data + pos, m_data + pos + len, m_data + pos - m_size);
+		}
+		pos += len;
+		count -= len;
+	}
 }
 
 SampleFifo::SampleFifo(QObject* parent) :
 	QObject(parent),
-	m_data()
+	m_data(NULL),
+	m_mapping(NULL),
+	m_mirrored(false),
+	m_size(0),
+	m_fill(0),
+	m_head(0),
+	m_tail(0)
 {
 	m_suppressed = -1;
-	m_size = 0;
-	m_fill = 0;
-	m_head = 0;
-	m_tail = 0;
 }
 
 SampleFifo::SampleFifo(int size, QObject* parent) :
 	QObject(parent),
-	m_data()
+	m_data(NULL),
+	m_mapping(NULL),
+	m_mirrored(false),
+	m_size(0),
+	m_fill(0),
+	m_head(0),
+	m_tail(0)
 {
 	m_suppressed = -1;
 
@@ -55,32 +220,28 @@ SampleFifo::SampleFifo(int size, QObject* parent) :
 
 SampleFifo::~SampleFifo()
 {
-	QMutexLocker mutexLocker(&m_mutex);
-
-	m_size = 0;
+	destroy();
 }
 
 bool SampleFifo::setSize(int size)
 {
 	create(size);
 
-	return m_size == (uint)size;
+	return m_size >= (uint)size;
 }
 
 uint SampleFifo::write(const quint8* data, uint count)
 {
 	return write(SampleVector::const_iterator((Sample*)data), SampleVector::const_iterator((Sample*)(data + count)));
-#if 0
-	QMutexLocker mutexLocker(&m_mutex);
-	uint total;
-	uint remaining;
-	uint len;
-	const Sample* begin = (const Sample*)data;
-	count /= sizeof(Sample);
+}
 
-	//qDebug("write pre count %d %u", count, m_fill);
+uint SampleFifo::write(SampleVector::const_iterator begin, SampleVector::const_iterator end)
+{
+	uint count = end - begin;
+	SampleVector::iterator spanBegin;
+	SampleVector::iterator spanEnd;
+	uint total = writeBegin(count, &spanBegin, &spanEnd);
 
-	total = MIN(count, m_size - m_fill);
 	if(total < count) {
 		if(m_suppressed < 0) {
 			m_suppressed = 0;
@@ -97,144 +258,78 @@ uint SampleFifo::write(const quint8* data, uint count)
 		}
 	}
 
-	remaining = total;
-	while(remaining > 0) {
-		len = MIN(remaining, m_size - m_tail);
-		//qDebug("write remaining %u, len %u", remaining, len);
-		std::copy(begin, begin + len, m_data.begin() + m_tail);
-		m_tail += len;
-		m_tail %= m_size;
-		m_fill += len;
-		begin += len;
-		remaining -= len;
-	}
+	std::copy(begin, begin + total, spanBegin);
+	return writeCommit(total);
+}
 
-	//qDebug("write post count %d %u [%u;%u]", count, m_fill, m_head, m_tail);
+uint SampleFifo::writeBegin(uint count, SampleVector::iterator* begin, SampleVector::iterator* end)
+{
+	uint space = m_size - fill();
+	uint total = MIN(count, space);
 
-	if(m_fill > 0)
-		emit dataReady();
+	// the free space behind m_tail is always contiguous thanks to the mirror
+	*begin = SampleVector::iterator(m_data + m_tail);
+	*end = *begin + total;
 
 	return total;
-#endif
 }
 
-uint SampleFifo::write(SampleVector::const_iterator begin, SampleVector::const_iterator end)
+uint SampleFifo::writeCommit(uint count)
 {
-	QMutexLocker mutexLocker(&m_mutex);
-	uint count = end - begin;
-	uint total;
-	uint remaining;
-	uint len;
+	// no buffer (yet), nothing was handed out
+	if(m_size == 0)
+		return 0;
 
-	total = MIN(count, m_size - m_fill);
-	if(total < count) {
-		if(m_suppressed < 0) {
-			m_suppressed = 0;
-			m_msgRateTimer.start();
-			qCritical("SampleFifo: overflow - dropping %u samples", count - total);
-		} else {
-			if(m_msgRateTimer.elapsed() > 2500) {
-				qCritical("SampleFifo: %u messages dropped", m_suppressed);
-				qCritical("SampleFifo: overflow - dropping %u samples", count - total);
-				m_suppressed = -1;
-			} else {
-				m_suppressed++;
-			}
-		}
+	uint space = m_size - fill();
+
+	if(count > space) {
+		qCritical("SampleFifo: cannot commit more than free space");
+		count = space;
 	}
 
-	remaining = total;
-	while(remaining > 0) {
-		len = MIN(remaining, m_size - m_tail);
-		std::copy(begin, begin + len, m_data.begin() + m_tail);
-		m_tail = (m_tail + len) % m_size;
-		m_fill += len;
-		begin += len;
-		remaining -= len;
+	if(count > 0) {
+		if(!m_mirrored)
+			mirror(m_tail, count);
+		m_tail = (m_tail + count) % m_size;
+		// publish the new samples to the consumer
+		m_fill.fetchAndAddRelease(count);
 	}
 
-	if(m_fill > 0)
+	if(fill() > 0)
 		emit dataReady();
 
-	return total;
+	return count;
 }
-/*
-uint SampleFifo::read(SampleVector::iterator begin, SampleVector::iterator end)
-{
-	QMutexLocker mutexLocker(&m_mutex);
-	uint count = end - begin;
-	uint total;
-	uint remaining;
-	uint len;
-
-	total = MIN(count, m_fill);
-	if(total < count)
-		qCritical("SampleFifo: underflow - missing %u samples", count - total);
-
-	remaining = total;
-	while(remaining > 0) {
-		len = MIN(remaining, m_size - m_head);
-		std::copy(m_data.begin() + m_head, m_data.begin() + m_head + len, begin);
-		m_head += len;
-		m_head %= m_size;
-		m_fill -= len;
-		begin += len;
-		remaining -= len;
-	}
 
-	return total;
-}
-*/
-uint SampleFifo::readBegin(uint count,
-	SampleVector::iterator* part1Begin, SampleVector::iterator* part1End,
-	SampleVector::iterator* part2Begin, SampleVector::iterator* part2End)
+uint SampleFifo::readBegin(uint count, SampleVector::iterator* begin, SampleVector::iterator* end)
 {
-	QMutexLocker mutexLocker(&m_mutex);
+	uint available = fill();
 	uint total;
-	uint done = 0;
-	uint remaining;
-	uint len;
-	uint head = m_head;
 
-	total = MIN(count, m_fill);
+	total = MIN(count, available);
 	if(total < count)
 		qCritical("SampleFifo: underflow - missing %u samples", count - total);
 
-	remaining = total;
-	if(remaining > 0) {
-		len = MIN(remaining, m_size - head);
-		*part1Begin = m_data.begin() + head;
-		*part1End = *part1Begin + len;
-		head = (head + len) % m_size;
-		remaining -= len;
-		done += len;
-	} else {
-		*part1Begin = m_data.end();
-		*part1End = m_data.end();
-	}
-	if(remaining > 0) {
-		len = MIN(remaining, m_size - head);
-		*part2Begin = m_data.begin() + head;
-		*part2End = *part2Begin + len;
-		done += len;
-	} else {
-		*part2Begin = m_data.end();
-		*part2End = m_data.end();
-	}
+	*begin = SampleVector::iterator(m_data + m_head);
+	*end = *begin + total;
 
-	return done;
+	return total;
 }
 
 uint SampleFifo::readCommit(uint count)
 {
-	QMutexLocker mutexLocker(&m_mutex);
+	if(m_size == 0)
+		return 0;
+
+	uint available = fill();
 
-	if(count > m_fill) {
+	if(count > available) {
 		qCritical("SampleFifo: cannot commit more than available samples");
-		count = m_fill;
+		count = available;
 	}
 	m_head = (m_head + count) % m_size;
-	m_fill -= count;
+	// hand the space back to the producer
+	m_fill.fetchAndAddRelease(-(int)count);
 
 	return count;
 }
@@ -1,4 +1,5 @@
 #include "dsp/samplesink.h"
+#include "dsp/sampleconverter.h"
 
 SampleSink::SampleSink()
 {
@@ -8,6 +9,30 @@ SampleSink::~SampleSink()
 {
 }
 
+void SampleSink::feedComplex(ComplexVector::const_iterator begin, ComplexVector::const_iterator end, bool firstOfBurst)
+{
+	int count = end - begin;
+
+	if(count > 0) {
+		if((int)m_convertBuffer.size() < count)
+			m_convertBuffer.resize(count);
+		SampleConverter::fromComplex(&(*begin), count, &m_convertBuffer[0]);
+	}
+	feed(m_convertBuffer.begin(), m_convertBuffer.begin() + count, firstOfBurst);
+}
+
+void ComplexSampleSink::feed(SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst)
+{
+	int count = end - begin;
+
+	if(count > 0) {
+		if((int)m_complexBuffer.size() < count)
+			m_complexBuffer.resize(count);
+		SampleConverter::toComplex(&(*begin), count, &m_complexBuffer[0]);
+	}
+	feedComplex(m_complexBuffer.begin(), m_complexBuffer.begin() + count, firstOfBurst);
+}
+
 #if 0
 #include "samplesink.h"
 
@@ -9,8 +9,8 @@ ScopeVis::ScopeVis(GLScope* glScope) :
 	m_fill(0),
 	m_triggerState(Untriggered),
 	m_triggerChannel(TriggerFreeRun),
-	m_triggerLevelHigh(0.01 * 32768),
-	m_triggerLevelLow(0.01 * 32768 - 1024),
+	m_triggerLevelHigh(0.01),
+	m_triggerLevelLow(0.01 - 1024.0 / 32768.0),
 	m_sampleRate(0)
 {
 }
@@ -21,7 +21,7 @@ void ScopeVis::configure(MessageQueue* msgQueue, TriggerChannel triggerChannel,
 	cmd->submit(msgQueue, this);
 }
 
-void ScopeVis::feed(SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst)
+void ScopeVis::feedComplex(ComplexVector::const_iterator begin, ComplexVector::const_iterator end, bool firstOfBurst)
 {
 	while(begin < end) {
 		if(m_triggerChannel == TriggerChannelI) {
@@ -38,11 +38,8 @@ void ScopeVis::feed(SampleVector::const_iterator begin, SampleVector::const_iter
 				int count = end - begin;
 				if(count > (int)(m_trace.size() - m_fill))
 					count = m_trace.size() - m_fill;
-				std::vector<Complex>::iterator it = m_trace.begin() + m_fill;
-				for(int i = 0; i < count; ++i) {
-					*it++ = Complex(begin->real() / 32768.0, begin->imag() / 32768.0);
-					++begin;
-				}
+				std::copy(begin, begin + count, m_trace.begin() + m_fill);
+				begin += count;
 				m_fill += count;
 				if(m_fill >= m_trace.size()) {
 					m_glScope->newTrace(m_trace, m_sampleRate);
@@ -73,11 +70,8 @@ void ScopeVis::feed(SampleVector::const_iterator begin, SampleVector::const_iter
 				int count = end - begin;
 				if(count > (int)(m_trace.size() - m_fill))
 					count = m_trace.size() - m_fill;
-				std::vector<Complex>::iterator it = m_trace.begin() + m_fill;
-				for(int i = 0; i < count; ++i) {
-					*it++ = Complex(begin->real() / 32768.0, begin->imag() / 32768.0);
-					++begin;
-				}
+				std::copy(begin, begin + count, m_trace.begin() + m_fill);
+				begin += count;
 				m_fill += count;
 				if(m_fill >= m_trace.size()) {
 					m_glScope->newTrace(m_trace, m_sampleRate);
@@ -98,11 +92,8 @@ void ScopeVis::feed(SampleVector::const_iterator begin, SampleVector::const_iter
 			int count = end - begin;
 			if(count > (int)(m_trace.size() - m_fill))
 				count = m_trace.size() - m_fill;
-			std::vector<Complex>::iterator it = m_trace.begin() + m_fill;
-			for(int i = 0; i < count; ++i) {
-				*it++ = Complex(begin->real() / 32768.0, begin->imag() / 32768.0);
-				++begin;
-			}
+			std::copy(begin, begin + count, m_trace.begin() + m_fill);
+			begin += count;
 			m_fill += count;
 			if(m_fill >= m_trace.size()) {
 				m_glScope->newTrace(m_trace, m_sampleRate);
@@ -131,8 +122,8 @@ bool ScopeVis::handleMessage(Message* message)
 		DSPConfigureScopeVis* conf = (DSPConfigureScopeVis*)message;
 		m_triggerState = Untriggered;
 		m_triggerChannel = (TriggerChannel)conf->getTriggerChannel();
-		m_triggerLevelHigh = conf->getTriggerLevelHigh() * 32767;
-		m_triggerLevelLow = conf->getTriggerLevelLow() * 32767;
+		m_triggerLevelHigh = conf->getTriggerLevelHigh();
+		m_triggerLevelLow = conf->getTriggerLevelLow();
 		message->completed();
 		return true;
 	} else {
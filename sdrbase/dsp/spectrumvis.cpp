@@ -1,9 +1,26 @@
+#include <string.h>
+#include <float.h>
+#include <algorithm>
 #include "dsp/spectrumvis.h"
-#include "gui/glspectrum.h"
+#include "dsp/glspectruminterface.h"
 #include "dsp/dspcommands.h"
 #include "util/messagequeue.h"
+#include "util/cpufeatures.h"
 
-#define MAX_FFT_SIZE 8192
+#if defined(USE_SIMD) && defined(CPUFEATURES_X86)
+#include <emmintrin.h>
+#define SPECTRUMVIS_USE_SSE2
+#endif
+
+#if defined(CPUFEATURES_NEON)
+#include <arm_neon.h>
+#endif
+
+#define MAX_FFT_SIZE (1 << 20)
+
+// frames windowed and transformed together, as long as they are small
+static const int maxBatch = 8;
+static const int maxBatchSamples = 65536;
 
 #ifdef _WIN32
 double log2f(double n)
@@ -12,15 +29,132 @@ double log2f(double n)
 }
 #endif
 
-SpectrumVis::SpectrumVis(GLSpectrum* glSpectrum) :
-	SampleSink(),
+// log2(1 + x) for 0 <= x < 1, error below 8e-4 (0.0024 dB)
+static const float log2C1 = 1.42461049f;
+static const float log2C2 = -0.58928329f;
+static const float log2C3 = 0.16545401f;
+
+static void logPowerExact(const Complex* in, int count, Real mult, Real ofs, Real* out)
+{
+	for(int i = 0; i < count; i++) {
+		Real v = in[i].real() * in[i].real() + in[i].imag() * in[i].imag();
+		out[i] = mult * log2f(v) + ofs;
+	}
+}
+
+// the exponent of the float is the integer part of the logarithm, the mantissa (1..2) goes
+// through the polynomial. zero and denormals end up at the smallest normal float (-380 dB)
+static inline float log2Fast(float v)
+{
+	if(v < FLT_MIN)
+		v = FLT_MIN;
+	quint32 bits;
+	memcpy(&bits, &v, sizeof(bits));
+	float e = (float)((int)(bits >> 23) - 127);
+	bits = (bits & 0x007fffff) | 0x3f800000;
+	float x;
+	memcpy(&x, &bits, sizeof(x));
+	x -= 1.0f;
+	return e + x * (log2C1 + x * (log2C2 + x * log2C3));
+}
+
+static void logPowerFastScalar(const Complex* in, int count, Real mult, Real ofs, Real* out)
+{
+	for(int i = 0; i < count; i++)
+		out[i] = mult * log2Fast(in[i].real() * in[i].real() + in[i].imag() * in[i].imag()) + ofs;
+}
+
+#if defined(SPECTRUMVIS_USE_SSE2)
+static void logPowerFastSSE2(const Complex* in, int count, Real mult, Real ofs, Real* out)
+{
+	const __m128i mantissaMask = _mm_set1_epi32(0x007fffff);
+	const __m128i one = _mm_set1_epi32(0x3f800000);
+	const __m128i bias = _mm_set1_epi32(127);
+	int i = 0;
+
+	for(; i + 4 <= count; i += 4) {
+		__m128 c0 = _mm_loadu_ps((const float*)(in + i));
+		__m128 c1 = _mm_loadu_ps((const float*)(in + i + 2));
+		c0 = _mm_mul_ps(c0, c0);
+		c1 = _mm_mul_ps(c1, c1);
+		__m128 v = _mm_add_ps(_mm_shuffle_ps(c0, c1, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(c0, c1, _MM_SHUFFLE(3, 1, 3, 1)));
+		v = _mm_max_ps(v, _mm_set1_ps(FLT_MIN));
+
+		__m128i bits = _mm_castps_si128(v);
+		__m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), bias));
+		__m128 x = _mm_sub_ps(_mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, mantissaMask), one)), _mm_set1_ps(1.0f));
+		__m128 p = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(log2C3)), _mm_set1_ps(log2C2));
+		p = _mm_add_ps(_mm_mul_ps(x, p), _mm_set1_ps(log2C1));
+		p = _mm_add_ps(_mm_mul_ps(x, p), e);
+
+		_mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(p, _mm_set1_ps(mult)), _mm_set1_ps(ofs)));
+	}
+
+	logPowerFastScalar(in + i, count - i, mult, ofs, out + i);
+}
+#endif
+
+#if defined(CPUFEATURES_NEON)
+static void logPowerFastNEON(const Complex* in, int count, Real mult, Real ofs, Real* out)
+{
+	int i = 0;
+
+	for(; i + 4 <= count; i += 4) {
+		float32x4x2_t c = vld2q_f32((const float*)(in + i));
+		float32x4_t v = vmaxq_f32(vmlaq_f32(vmulq_f32(c.val[0], c.val[0]), c.val[1], c.val[1]), vdupq_n_f32(FLT_MIN));
+
+		uint32x4_t bits = vreinterpretq_u32_f32(v);
+		float32x4_t e = vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)), vdupq_n_s32(127)));
+		bits = vorrq_u32(vandq_u32(bits, vdupq_n_u32(0x007fffff)), vdupq_n_u32(0x3f800000));
+		float32x4_t x = vsubq_f32(vreinterpretq_f32_u32(bits), vdupq_n_f32(1.0f));
+		float32x4_t p = vmlaq_n_f32(vdupq_n_f32(log2C2), x, log2C3);
+		p = vmlaq_f32(vdupq_n_f32(log2C1), x, p);
+		p = vmlaq_f32(e, x, p);
+
+		vst1q_f32(out + i, vmlaq_n_f32(vdupq_n_f32(ofs), p, mult));
+	}
+
+	logPowerFastScalar(in + i, count - i, mult, ofs, out + i);
+}
+#endif
+
+const SpectrumVis::LogPowerKernel SpectrumVis::m_logPowerFast = SpectrumVis::selectLogPowerFast();
+
+SpectrumVis::LogPowerKernel SpectrumVis::selectLogPowerFast()
+{
+#if defined(SPECTRUMVIS_USE_SSE2)
+	if(CPUFeatures::has(CPUFeatures::SSE2))
+		return logPowerFastSSE2;
+#endif
+#if defined(CPUFEATURES_NEON)
+	if(CPUFeatures::has(CPUFeatures::NEON))
+		return logPowerFastNEON;
+#endif
+	return logPowerFastScalar;
+}
+
+SpectrumVis::SpectrumVis(GLSpectrumInterface* glSpectrum) :
+	ComplexSampleSink(),
 	m_fft(FFTEngine::create()),
-	m_fftBuffer(MAX_FFT_SIZE),
-	m_logPowerSpectrum(MAX_FFT_SIZE),
+	m_fftBuffer(),
+	m_logPowerSpectrum(),
+	m_powerSpectrum(),
+	m_powerSpectrumCount(0),
+	m_displaySpectrum(),
 	m_fftBufferFill(0),
+	m_sampleBuffer(),
+	m_sampleBufferFill(0),
+	m_bufferSize(0),
+	m_batch(1),
+	m_logAccuracy(LogFast),
+	m_logPower(logPowerExact),
+	m_frameRate(0),
+	m_averaging(AvgNone),
+	m_nextFrame(0),
 	m_glSpectrum(glSpectrum)
 {
-	handleConfigure(1024, 10, FFTWindow::BlackmanHarris);
+	m_frameTimer.start();
+	handleConfigure(1024, 10, FFTWindow::BlackmanHarris, LogFast);
 }
 
 SpectrumVis::~SpectrumVis()
@@ -28,59 +162,107 @@ SpectrumVis::~SpectrumVis()
 	delete m_fft;
 }
 
-void SpectrumVis::configure(MessageQueue* msgQueue, int fftSize, int overlapPercent, FFTWindow::Function window)
+void SpectrumVis::configure(MessageQueue* msgQueue, int fftSize, int overlapPercent, FFTWindow::Function window, LogAccuracy logAccuracy)
 {
-	Message* cmd = DSPConfigureSpectrumVis::create(fftSize, overlapPercent, window);
+	Message* cmd = DSPConfigureSpectrumVis::create(fftSize, overlapPercent, window, logAccuracy);
 	cmd->submit(msgQueue, this);
 }
 
+void SpectrumVis::configureFrames(MessageQueue* msgQueue, int frameRate, Averaging averaging)
+{
+	Message* cmd = DSPConfigureSpectrumFrames::create(frameRate, averaging);
+	cmd->submit(msgQueue, this);
+}
+
+// int16 input stays int16 up to the window, the overlap is read again from the retained samples
 void SpectrumVis::feed(SampleVector::const_iterator begin, SampleVector::const_iterator end, bool firstOfBurst)
 {
 	// if no visualisation is set, send the samples to /dev/null
-	if(m_glSpectrum == NULL)
+	if((m_glSpectrum == NULL) || (begin == end))
 		return;
 
+	feedFrames(&m_sampleBuffer, &m_sampleBufferFill, &(*begin), &(*begin) + (end - begin));
+}
+
+void SpectrumVis::feedComplex(ComplexVector::const_iterator begin, ComplexVector::const_iterator end, bool firstOfBurst)
+{
+	// if no visualisation is set, send the samples to /dev/null
+	if((m_glSpectrum == NULL) || (begin == end))
+		return;
+
+	feedFrames(&m_fftBuffer, &m_fftBufferFill, &(*begin), &(*begin) + (end - begin));
+}
+
+template<typename T> void SpectrumVis::feedFrames(std::vector<T>* buffer, size_t* fill, const T* begin, const T* end)
+{
+	// the buffer holds up to m_batch overlapping frames, m_refillSize apart
+	// Sample() leaves its values alone, the overlap of the first frame has to be silence
+	if(buffer->size() != m_bufferSize)
+		buffer->resize(m_bufferSize, T(0));
+
 	while(begin < end) {
-		size_t todo = end - begin;
-		size_t samplesNeeded = m_refillSize - m_fftBufferFill;
-
-		if(todo >= samplesNeeded) {
-			// fill up the buffer
-			std::vector<Complex>::iterator it = m_fftBuffer.begin() + m_fftBufferFill;
-			for(size_t i = 0; i < samplesNeeded; ++i, ++begin)
-				*it++ = Complex(begin->real() / 32768.0, begin->imag() / 32768.0);
-
-			// apply fft window (and copy from m_fftBuffer to m_fftIn)
-			m_window.apply(&m_fftBuffer[0], m_fft->in());
-
-			// calculate FFT
-			m_fft->transform();
-
-			// extract power spectrum and reorder buckets
-			Real ofs = 20.0f * log10f(1.0f / m_fftSize);
-			Real mult = (10.0f / log2f(10.0f));
-			const Complex* fftOut = m_fft->out();
-			for(size_t i = 0; i < m_fftSize; i++) {
-				Complex c = fftOut[((i + (m_fftSize >> 1)) & (m_fftSize - 1))];
-				Real v = c.real() * c.real() + c.imag() * c.imag();
-				v = mult * log2f(v) + ofs;
-				m_logPowerSpectrum[i] = v;
-			}
-
-			// send new data to visualisation
-			m_glSpectrum->newSpectrum(m_logPowerSpectrum, m_fftSize);
-
-			// advance buffer respecting the fft overlap factor
-			std::copy(m_fftBuffer.begin() + m_refillSize, m_fftBuffer.end(), m_fftBuffer.begin());
-
-			// start over
-			m_fftBufferFill = m_overlapSize;
+		size_t todo = std::min((size_t)(end - begin), m_bufferSize - *fill);
+		std::copy(begin, begin + todo, buffer->begin() + *fill);
+		begin += todo;
+		*fill += todo;
+
+		if(*fill < m_fftSize)
+			break;
+
+		int frames = (*fill - m_fftSize) / m_refillSize + 1;
+		processFrames(&(*buffer)[0], frames);
+
+		// keep the overlap and whatever is there of the next frame
+		size_t used = frames * m_refillSize;
+		std::copy(buffer->begin() + used, buffer->begin() + *fill, buffer->begin());
+		*fill -= used;
+	}
+}
+
+template<typename T> void SpectrumVis::processFrames(const T* buffer, int frames)
+{
+	bool due[maxBatch];
+	int batch = 0;
+	Complex* fftIn = m_fft->in();
+
+	// without averaging only the FFTs that make it to the display are done
+	for(int i = 0; i < frames; i++) {
+		due[i] = frameDue();
+		if(due[i] || (m_averaging != AvgNone)) {
+			// apply fft window (and copy from the buffer to the FFT input)
+			m_window.apply(buffer + i * m_refillSize, fftIn + batch * m_fftSize);
+			batch++;
+		}
+	}
+
+	if(batch == 0)
+		return;
+
+	// calculate all FFTs at once
+	m_fft->transformMany(batch, m_fftSize);
+
+	Real ofs = 20.0f * log10f(1.0f / m_fftSize);
+	Real mult = (10.0f / log2f(10.0f));
+	const Complex* fftOut = m_fft->out();
+
+	for(int i = 0; i < frames; i++) {
+		if(m_averaging == AvgNone) {
+			if(!due[i])
+				continue;
+			// extract power spectrum, the upper half of the bins goes first
+			size_t half = m_fftSize >> 1;
+			m_logPower(fftOut + half, half, mult, ofs, &m_logPowerSpectrum[0]);
+			m_logPower(fftOut, half, mult, ofs, &m_logPowerSpectrum[half]);
 		} else {
-			// not enough samples for FFT - just fill in new data and return
-			for(std::vector<Complex>::iterator it = m_fftBuffer.begin() + m_fftBufferFill; begin < end; ++begin)
-				*it++ = Complex(begin->real() / 32768.0, begin->imag() / 32768.0);
-			m_fftBufferFill += todo;
+			accumulate(fftOut);
+			if(due[i])
+				logAccumulated(mult, ofs);
 		}
+		fftOut += m_fftSize;
+
+		// send new data to visualisation
+		if(due[i])
+			sendSpectrum();
 	}
 }
 
@@ -96,7 +278,12 @@ bool SpectrumVis::handleMessage(Message* message)
 {
 	if(DSPConfigureSpectrumVis::match(message)) {
 		DSPConfigureSpectrumVis* conf = (DSPConfigureSpectrumVis*)message;
-		handleConfigure(conf->getFFTSize(), conf->getOverlapPercent(), conf->getWindow());
+		handleConfigure(conf->getFFTSize(), conf->getOverlapPercent(), conf->getWindow(), conf->getLogAccuracy());
+		message->completed();
+		return true;
+	} else if(DSPConfigureSpectrumFrames::match(message)) {
+		DSPConfigureSpectrumFrames* conf = (DSPConfigureSpectrumFrames*)message;
+		handleConfigureFrames(conf->getFrameRate(), conf->getAveraging());
 		message->completed();
 		return true;
 	} else {
@@ -104,16 +291,17 @@ bool SpectrumVis::handleMessage(Message* message)
 	}
 }
 
-void SpectrumVis::handleConfigure(int fftSize, int overlapPercent, FFTWindow::Function window)
+void SpectrumVis::handleConfigure(int fftSize, int overlapPercent, FFTWindow::Function window, LogAccuracy logAccuracy)
 {
 	if(fftSize > MAX_FFT_SIZE)
 		fftSize = MAX_FFT_SIZE;
 	else if(fftSize < 64)
 		fftSize = 64;
-	if(overlapPercent > 100)
-		m_overlapPercent = 100;
+	// at least one new sample per frame
+	if(overlapPercent > 99)
+		overlapPercent = 99;
 	else if(overlapPercent < 0)
-		m_overlapPercent = 0;
+		overlapPercent = 0;
 
 	m_fftSize = fftSize;
 	m_overlapPercent = overlapPercent;
@@ -121,5 +309,111 @@ void SpectrumVis::handleConfigure(int fftSize, int overlapPercent, FFTWindow::Fu
 	m_window.create(window, m_fftSize);
 	m_overlapSize = (m_fftSize * m_overlapPercent) / 100;
 	m_refillSize = m_fftSize - m_overlapSize;
+	m_batch = std::max(1, std::min(maxBatch, maxBatchSamples / (int)m_fftSize));
+	m_bufferSize = m_fftSize + (m_batch - 1) * m_refillSize;
 	m_fftBufferFill = m_overlapSize;
+	m_sampleBufferFill = m_overlapSize;
+	m_fft->reserve(m_batch, m_fftSize);
+	m_logPowerSpectrum.resize(m_fftSize);
+	m_powerSpectrum.resize((m_averaging != AvgNone) ? m_fftSize : 0);
+	m_logAccuracy = logAccuracy;
+	m_logPower = (logAccuracy == LogExact) ? logPowerExact : m_logPowerFast;
+	m_powerSpectrumCount = 0;
+}
+
+void SpectrumVis::handleConfigureFrames(int frameRate, Averaging averaging)
+{
+	m_frameRate = (frameRate > 0) ? frameRate : 0;
+	// every FFT is a frame of its own when the rate is not limited
+	m_averaging = (m_frameRate > 0) ? averaging : AvgNone;
+	m_nextFrame = m_frameTimer.nsecsElapsed();
+	m_powerSpectrum.resize((m_averaging != AvgNone) ? m_fftSize : 0);
+	m_powerSpectrumCount = 0;
+}
+
+bool SpectrumVis::frameDue()
+{
+	if(m_frameRate == 0)
+		return true;
+
+	qint64 now = m_frameTimer.nsecsElapsed();
+	if(now < m_nextFrame)
+		return false;
+
+	// keep the pace, unless we are more than a frame late
+	qint64 interval = 1000000000LL / m_frameRate;
+	m_nextFrame += interval;
+	if(m_nextFrame <= now)
+		m_nextFrame = now + interval;
+	return true;
+}
+
+// linear power per bin into m_powerSpectrum
+void SpectrumVis::accumulate(const Complex* fftOut)
+{
+	Real* acc = &m_powerSpectrum[0];
+	int n = m_fftSize;
+
+	if(m_powerSpectrumCount == 0) {
+		for(int i = 0; i < n; i++)
+			acc[i] = fftOut[i].real() * fftOut[i].real() + fftOut[i].imag() * fftOut[i].imag();
+	} else if(m_averaging == AvgLinear) {
+		for(int i = 0; i < n; i++)
+			acc[i] += fftOut[i].real() * fftOut[i].real() + fftOut[i].imag() * fftOut[i].imag();
+	} else if(m_averaging == AvgPeakHold) {
+		for(int i = 0; i < n; i++)
+			acc[i] = std::max(acc[i], fftOut[i].real() * fftOut[i].real() + fftOut[i].imag() * fftOut[i].imag());
+	} else {
+		for(int i = 0; i < n; i++)
+			acc[i] = std::min(acc[i], fftOut[i].real() * fftOut[i].real() + fftOut[i].imag() * fftOut[i].imag());
+	}
+	m_powerSpectrumCount++;
+}
+
+// m_powerSpectrum to dB, reordered, and start over - once per frame, so no SIMD here
+void SpectrumVis::logAccumulated(Real mult, Real ofs)
+{
+	int n = m_fftSize;
+	int half = n >> 1;
+
+	if(m_averaging == AvgLinear)
+		ofs -= mult * log2f(m_powerSpectrumCount);
+
+	for(int i = 0; i < n; i++) {
+		Real v = m_powerSpectrum[(i + half) & (n - 1)];
+		if(m_logAccuracy == LogExact)
+			m_logPowerSpectrum[i] = mult * log2f(v) + ofs;
+		else m_logPowerSpectrum[i] = mult * log2Fast(v) + ofs;
+	}
+
+	m_powerSpectrumCount = 0;
+}
+
+// no more bins than the display has pixels, each one the highest of the bins it covers so
+// narrow carriers do not get lost
+void SpectrumVis::sendSpectrum()
+{
+	int width = m_glSpectrum->getDisplayWidth();
+	int bins = m_fftSize;
+
+	while((width > 0) && (bins / 2 >= width))
+		bins /= 2;
+
+	if(bins == (int)m_fftSize) {
+		m_glSpectrum->newSpectrum(m_logPowerSpectrum, m_fftSize);
+		return;
+	}
+
+	int factor = m_fftSize / bins;
+	if((int)m_displaySpectrum.size() < bins)
+		m_displaySpectrum.resize(bins);
+	const Real* in = &m_logPowerSpectrum[0];
+	for(int i = 0; i < bins; i++) {
+		Real v = in[0];
+		for(int j = 1; j < factor; j++)
+			v = std::max(v, in[j]);
+		m_displaySpectrum[i] = v;
+		in += factor;
+	}
+	m_glSpectrum->newSpectrum(m_displaySpectrum, bins);
 }
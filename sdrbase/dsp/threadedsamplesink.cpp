@@ -60,26 +60,15 @@ void ThreadedSampleSink::handleData()
 	time.start();
 
 	while((m_sampleFifo.fill() > 0) && (m_messageQueue.countPending() == 0) && (time.elapsed() < 250)) {
-		SampleVector::iterator part1begin;
-		SampleVector::iterator part1end;
-		SampleVector::iterator part2begin;
-		SampleVector::iterator part2end;
+		SampleVector::iterator readBegin;
+		SampleVector::iterator readEnd;
 
-		size_t count = m_sampleFifo.readBegin(m_sampleFifo.fill(), &part1begin, &part1end, &part2begin, &part2end);
+		size_t count = m_sampleFifo.readBegin(m_sampleFifo.fill(), &readBegin, &readEnd);
 
+		// handle data
 		if(m_sampleSink != NULL) {
-			// first part of FIFO data
-			if(part1begin != part1end) {
-				// handle data
-				m_sampleSink->feed(part1begin, part1end, firstOfBurst);
-				firstOfBurst = false;
-			}
-			// second part of FIFO data (used when block wraps around)
-			if(part2begin != part2end) {
-				// handle data
-				m_sampleSink->feed(part2begin, part2end, firstOfBurst);
-				firstOfBurst = false;
-			}
+			m_sampleSink->feed(readBegin, readEnd, firstOfBurst);
+			firstOfBurst = false;
 		}
 
 		// adjust FIFO pointers
@@ -32,6 +32,7 @@ GLSpectrum::GLSpectrum(QWidget* parent) :
 	m_decay(0),
 	m_sampleRate(500000),
 	m_fftSize(512),
+	m_displayWidth(0),
 	m_displayGrid(true),
 	m_invertedWaterfall(false),
 	m_displayMaxHold(false),
@@ -406,6 +407,7 @@ void GLSpectrum::resizeGL(int width, int height)
 {
 	glViewport(0, 0, width, height);
 
+	m_displayWidth.store(width);
 	m_changesPending = true;
 }
 
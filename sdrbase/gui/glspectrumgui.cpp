@@ -5,6 +5,18 @@
 #include "util/simpleserializer.h"
 #include "ui_glspectrumgui.h"
 
+// entries of the rate combo box, 0 is one frame per FFT
+static const int frameRates[] = { 0, 50, 25, 10 };
+
+static int frameRateIndex(int frameRate)
+{
+	for(int i = 0; i < 4; i++) {
+		if(frameRates[i] == frameRate)
+			return i;
+	}
+	return 0;
+}
+
 GLSpectrumGUI::GLSpectrumGUI(QWidget* parent) :
 	QWidget(parent),
 	ui(new Ui::GLSpectrumGUI),
@@ -22,7 +34,9 @@ GLSpectrumGUI::GLSpectrumGUI(QWidget* parent) :
 	m_displayMaxHold(true),
 	m_displayHistogram(true),
 	m_displayGrid(true),
-	m_invert(false)
+	m_invert(false),
+	m_frameRate(25),
+	m_averaging(SpectrumVis::AvgNone)
 {
 	ui->setupUi(this);
 	for(int ref = 0; ref >= -95; ref -= 5)
@@ -58,6 +72,8 @@ void GLSpectrumGUI::resetToDefaults()
 	m_displayHistogram = true;
 	m_displayGrid = true;
 	m_invert = false;
+	m_frameRate = 25;
+	m_averaging = SpectrumVis::AvgNone;
 	applySettings();
 }
 
@@ -76,6 +92,8 @@ QByteArray GLSpectrumGUI::serialize() const
 	s.writeS32(10, m_decay);
 	s.writeBool(11, m_displayGrid);
 	s.writeBool(12, m_invert);
+	s.writeS32(13, m_frameRate);
+	s.writeS32(14, m_averaging);
 	return s.final();
 }
 
@@ -101,6 +119,8 @@ bool GLSpectrumGUI::deserialize(const QByteArray& data)
 		d.readS32(10, &m_decay, 0);
 		d.readBool(11, &m_displayGrid, true);
 		d.readBool(12, &m_invert, false);
+		d.readS32(13, &m_frameRate, 25);
+		d.readS32(14, &m_averaging, SpectrumVis::AvgNone);
 		applySettings();
 		return true;
 	} else {
@@ -112,7 +132,7 @@ bool GLSpectrumGUI::deserialize(const QByteArray& data)
 void GLSpectrumGUI::applySettings()
 {
 	ui->fftWindow->setCurrentIndex(m_fftWindow);
-	for(int i = 0; i < 7; i++) {
+	for(int i = 0; i < 14; i++) {
 		if(m_fftSize == (1 << (i + 7))) {
 			ui->fftSize->setCurrentIndex(i);
 			break;
@@ -121,6 +141,8 @@ void GLSpectrumGUI::applySettings()
 	ui->refLevel->setCurrentIndex(-m_refLevel / 5);
 	ui->levelRange->setCurrentIndex((100 - m_powerRange) / 5);
 	ui->decay->setCurrentIndex(m_decay + 2);
+	ui->frameRate->setCurrentIndex(frameRateIndex(m_frameRate));
+	ui->averaging->setCurrentIndex(m_averaging);
 	ui->waterfall->setChecked(m_displayWaterfall);
 	ui->maxHold->setChecked(m_displayMaxHold);
 	ui->histogram->setChecked(m_displayHistogram);
@@ -136,6 +158,7 @@ void GLSpectrumGUI::applySettings()
 	m_glSpectrum->setDisplayGrid(m_displayGrid);
 
 	m_spectrumVis->configure(m_messageQueue, m_fftSize, m_fftOverlap, (FFTWindow::Function)m_fftWindow);
+	m_spectrumVis->configureFrames(m_messageQueue, m_frameRate, (SpectrumVis::Averaging)m_averaging);
 }
 
 void GLSpectrumGUI::on_fftWindow_currentIndexChanged(int index)
@@ -174,6 +197,20 @@ void GLSpectrumGUI::on_decay_currentIndexChanged(int index)
 		m_glSpectrum->setDecay(m_decay);
 }
 
+void GLSpectrumGUI::on_frameRate_currentIndexChanged(int index)
+{
+	m_frameRate = frameRates[index];
+	if(m_spectrumVis != NULL)
+		m_spectrumVis->configureFrames(m_messageQueue, m_frameRate, (SpectrumVis::Averaging)m_averaging);
+}
+
+void GLSpectrumGUI::on_averaging_currentIndexChanged(int index)
+{
+	m_averaging = index;
+	if(m_spectrumVis != NULL)
+		m_spectrumVis->configureFrames(m_messageQueue, m_frameRate, (SpectrumVis::Averaging)m_averaging);
+}
+
 void GLSpectrumGUI::on_waterfall_toggled(bool checked)
 {
 	m_displayWaterfall = checked;
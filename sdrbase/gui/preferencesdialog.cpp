@@ -54,6 +54,8 @@ PreferencesDialog::PreferencesDialog(Preferences* preferences, QWidget* parent)
 	if(!found)
 		ui->audioRate->setCurrentIndex(1);
 
+	ui->sinkThreads->setValue(m_preferences->getSinkThreads());
+
 	ui->stackedWidget->setCurrentIndex(0);
 	ui->configTree->setCurrentItem(ui->configTree->topLevelItem(0));
 }
@@ -69,6 +71,13 @@ void PreferencesDialog::accept()
 		m_preferences->setAudioOutput(ui->audioTree->currentItem()->data(0, Qt::UserRole).toString());
 	else m_preferences->setAudioOutput(QString());
 	m_preferences->setAudioOutputRate(ui->audioRate->itemData(ui->audioRate->currentIndex()).toInt());
+	m_preferences->setSinkThreads(ui->sinkThreads->value());
 
 	QDialog::accept();
 }
+
+void PreferencesDialog::on_configTree_currentItemChanged(QTreeWidgetItem* current, QTreeWidgetItem*)
+{
+	if(current != NULL)
+		ui->stackedWidget->setCurrentIndex(ui->configTree->indexOfTopLevelItem(current));
+}
@@ -15,6 +15,8 @@
 // along with this program. If not, see <http://www.gnu.org/licenses/>.          //
 ///////////////////////////////////////////////////////////////////////////////////
 
+#include <QDateTime>
+#include <QFileDialog>
 #include <QInputDialog>
 #include <QMessageBox>
 #include <QLabel>
@@ -30,6 +32,7 @@
 #include "gui/rollupwidget.h"
 #include "dsp/dspengine.h"
 #include "dsp/spectrumvis.h"
+#include "dsp/iqrecorder.h"
 #include "dsp/dspcommands.h"
 #include "plugin/plugingui.h"
 #include "plugin/pluginapi.h"
@@ -91,6 +94,8 @@ MainWindow::MainWindow(QWidget* parent) :
 
 	m_spectrumVis = new SpectrumVis(ui->glSpectrum);
 	m_dspEngine->addSink(m_spectrumVis);
+	m_iqRecorder = new IQRecorder(m_messageQueue);
+	m_dspEngine->addSink(m_iqRecorder);
 
 	ui->glSpectrumGUI->setBuddies(m_dspEngine->getMessageQueue(), m_spectrumVis, ui->glSpectrum);
 
@@ -119,6 +124,8 @@ MainWindow::~MainWindow()
 
 	m_dspEngine->removeSink(m_spectrumVis);
 	delete m_spectrumVis;
+	m_dspEngine->removeSink(m_iqRecorder);
+	delete m_iqRecorder;
 
 	if(m_scopeWindow != NULL) {
 		delete m_scopeWindow;
@@ -195,6 +202,7 @@ void MainWindow::loadSettings(const Preset* preset)
 	m_pluginManager->loadSettings(preset);
 
 	m_dspEngine->configureAudioOutput(m_settings.getPreferences()->getAudioOutput(), m_settings.getPreferences()->getAudioOutputRate());
+	m_dspEngine->configureSinkThreads(m_settings.getPreferences()->getSinkThreads());
 
 	// has to be last step
 	restoreState(preset->getLayout());
@@ -314,6 +322,17 @@ void MainWindow::handleMessages()
 			//qDebug("SampleRate:%d, CenterFrequency:%llu", rep->getSampleRate(), rep->getCenterFrequency());
 			updateCenterFreqDisplay();
 			updateSampleRate();
+			// a retune while recording starts a new capture segment
+			if(!m_recordFileName.isEmpty())
+				m_iqRecorder->configure(m_dspEngine->getMessageQueue(), m_recordFileName, m_centerFrequency);
+			message->completed();
+		} else if(DSPIQRecorderStopped::match(message)) {
+			DSPIQRecorderStopped* rep = DSPIQRecorderStopped::cast(message);
+			// unchecking the button clears the file name and tells the recorder
+			if(rep->getFileName() == m_recordFileName) {
+				ui->record->setChecked(false);
+				statusBar()->showMessage(tr("Recording stopped: sample rate changed"), 10000);
+			}
 			message->completed();
 		} else {
 			if(!m_pluginManager->handleMessage(message))
@@ -372,8 +391,15 @@ void MainWindow::updateEnables(bool running)
 {
 	if(running) {
 		ui->action_Preferences->setEnabled(false);
+		ui->record->setEnabled(true);
 	} else {
 		ui->action_Preferences->setEnabled(true);
+		// the recorder closes its file when the engine stops
+		bool recordSignalsBlocked = ui->record->blockSignals(true);
+		ui->record->setChecked(false);
+		ui->record->blockSignals(recordSignalsBlocked);
+		ui->record->setEnabled(false);
+		m_recordFileName.clear();
 	}
 }
 
@@ -406,6 +432,26 @@ void MainWindow::on_iqImbalance_toggled(bool checked)
 	m_dspEngine->configureCorrections(m_settings.getCurrent()->getDCOffsetCorrection(), m_settings.getCurrent()->getIQImbalanceCorrection());
 }
 
+void MainWindow::on_record_toggled(bool checked)
+{
+	if(checked) {
+		QString fileName = QString("sdrangelove-%1-%2Hz.sigmf-data")
+			.arg(QDateTime::currentDateTimeUtc().toString("yyyyMMdd-hhmmss"))
+			.arg(m_centerFrequency);
+		fileName = QFileDialog::getSaveFileName(this, tr("Record Baseband"), fileName, tr("SigMF Recordings (*.sigmf-data)"));
+		if(fileName.isEmpty()) {
+			bool recordSignalsBlocked = ui->record->blockSignals(true);
+			ui->record->setChecked(false);
+			ui->record->blockSignals(recordSignalsBlocked);
+			return;
+		}
+		m_recordFileName = fileName;
+	} else {
+		m_recordFileName.clear();
+	}
+	m_iqRecorder->configure(m_dspEngine->getMessageQueue(), m_recordFileName, m_centerFrequency);
+}
+
 void MainWindow::on_action_View_Fullscreen_toggled(bool checked)
 {
 	if(checked)
@@ -529,6 +575,7 @@ void MainWindow::on_action_Preferences_triggered()
 
 	if(preferencesDialog.exec() == QDialog::Accepted) {
 		m_dspEngine->configureAudioOutput(m_settings.getPreferences()->getAudioOutput(), m_settings.getPreferences()->getAudioOutputRate());
+		m_dspEngine->configureSinkThreads(m_settings.getPreferences()->getSinkThreads());
 	}
 }
 
@@ -70,6 +70,36 @@ void PluginAPI::removeSampleSink(SampleSink* sampleSink)
 	m_dspEngine->removeSink(sampleSink);
 }
 
+void PluginAPI::addPFBSink(SampleSink* sampleSink)
+{
+	m_dspEngine->addPFBSink(sampleSink);
+}
+
+void PluginAPI::removePFBSink(SampleSink* sampleSink)
+{
+	m_dspEngine->removePFBSink(sampleSink);
+}
+
+void PluginAPI::configurePFBSink(SampleSink* sampleSink, int bandwidth, int centerFrequency)
+{
+	m_dspEngine->configurePFBSink(sampleSink, bandwidth, centerFrequency);
+}
+
+void PluginAPI::addChannelizerSink(SampleSink* sampleSink)
+{
+	m_dspEngine->addChannelizerSink(sampleSink);
+}
+
+void PluginAPI::removeChannelizerSink(SampleSink* sampleSink)
+{
+	m_dspEngine->removeChannelizerSink(sampleSink);
+}
+
+void PluginAPI::configureChannelizerSink(SampleSink* sampleSink, int sampleRate, int centerFrequency)
+{
+	m_dspEngine->configureChannelizerSink(sampleSink, sampleRate, centerFrequency);
+}
+
 MessageQueue* PluginAPI::getDSPEngineMessageQueue()
 {
 	return m_dspEngine->getMessageQueue();
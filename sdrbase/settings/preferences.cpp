@@ -10,6 +10,7 @@ void Preferences::resetToDefaults()
 {
 	m_audioOutput.clear();
 	m_audioOutputRate = 44100;
+	m_sinkThreads = 0;
 }
 
 QByteArray Preferences::serialize() const
@@ -17,6 +18,7 @@ QByteArray Preferences::serialize() const
 	SimpleSerializer s(1);
 	s.writeString(1, m_audioOutput);
 	s.writeU32(2, m_audioOutputRate);
+	s.writeS32(3, m_sinkThreads);
 	return s.final();
 }
 
@@ -34,6 +36,7 @@ bool Preferences::deserialize(const QByteArray& data)
 		quint32 tmp;
 		d.readU32(2, &tmp, 44100);
 		m_audioOutputRate = tmp;
+		d.readS32(3, &m_sinkThreads, 0);
 		return true;
 	} else {
 		resetToDefaults();
@@ -0,0 +1,66 @@
+#include "util/cpufeatures.h"
+
+#if defined(CPUFEATURES_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+bool CPUFeatures::has(Feature feature)
+{
+	static const int features = detect();
+	return (features & feature) != 0;
+}
+
+int CPUFeatures::detect()
+{
+	int features = 0;
+
+#if defined(CPUFEATURES_X86)
+#if defined(_MSC_VER)
+	int info[4];
+
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	if(info[3] & (1 << 26))
+		features |= SSE2;
+	if(info[2] & (1 << 9))
+		features |= SSSE3;
+	if(info[2] & (1 << 19))
+		features |= SSE41;
+
+	// AVX also needs the OS to save the YMM registers
+	bool osAVX = (info[2] & (1 << 27)) && ((_xgetbv(0) & 6) == 6);
+	if(osAVX && (info[2] & (1 << 28))) {
+		features |= AVX;
+		if(info[2] & (1 << 12))
+			features |= FMA;
+		if(maxLeaf >= 7) {
+			__cpuidex(info, 7, 0);
+			if(info[1] & (1 << 5))
+				features |= AVX2;
+		}
+	}
+#else
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("sse2"))
+		features |= SSE2;
+	if(__builtin_cpu_supports("ssse3"))
+		features |= SSSE3;
+	if(__builtin_cpu_supports("sse4.1"))
+		features |= SSE41;
+	if(__builtin_cpu_supports("avx"))
+		features |= AVX;
+	if(__builtin_cpu_supports("avx2"))
+		features |= AVX2;
+	if(__builtin_cpu_supports("fma"))
+		features |= FMA;
+#endif
+#endif
+
+#if defined(CPUFEATURES_NEON)
+	features |= NEON;
+#endif
+
+	return features;
+}